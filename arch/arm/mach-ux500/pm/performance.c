@@ -106,9 +106,9 @@ static void wlan_load(struct work_struct *work)
 
 	old_num_irqs = num_irqs;
 
-	schedule_delayed_work_on(0,
-				 &work_wlan_workaround,
-				 msecs_to_jiffies(WLAN_PROBE_DELAY));
+	queue_delayed_work(system_power_efficient_wq,
+			   &work_wlan_workaround,
+			   msecs_to_jiffies(WLAN_PROBE_DELAY));
 }
 
 #ifdef CONFIG_MMC_BLOCK
@@ -214,8 +214,8 @@ static void mmc_load(struct work_struct *work)
 
 	old_mode = new_mode;
 
-	schedule_delayed_work(&work_mmc,
-				 msecs_to_jiffies(PERF_MMC_PROBE_DELAY));
+	queue_delayed_work(system_power_efficient_wq, &work_mmc,
+			   msecs_to_jiffies(PERF_MMC_PROBE_DELAY));
 
 }
 #endif /* CONFIG_MMC_BLOCK */
@@ -241,8 +241,8 @@ static int __init performance_register(void)
 		prcmu_qos_remove_requirement(PRCMU_QOS_DDR_OPP, "mmc");
 	} else {
 		INIT_DELAYED_WORK_DEFERRABLE(&work_mmc, mmc_load);
-		schedule_delayed_work(&work_mmc,
-				      msecs_to_jiffies(PERF_MMC_PROBE_DELAY));
+		queue_delayed_work(system_power_efficient_wq, &work_mmc,
+				   msecs_to_jiffies(PERF_MMC_PROBE_DELAY));
 	}
 #endif
 
@@ -261,8 +261,9 @@ static int __init performance_register(void)
 		prcmu_qos_remove_requirement(PRCMU_QOS_DDR_OPP, "wlan");
 	} else {
 		INIT_DELAYED_WORK_DEFERRABLE(&work_wlan_workaround, wlan_load);
-		schedule_delayed_work_on(0, &work_wlan_workaround,
-					 msecs_to_jiffies(WLAN_PROBE_DELAY));
+		queue_delayed_work(system_power_efficient_wq,
+				   &work_wlan_workaround,
+				   msecs_to_jiffies(WLAN_PROBE_DELAY));
 	}
 
 	/* Only return one error code */
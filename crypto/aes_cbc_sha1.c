@@ -0,0 +1,437 @@
+/*
+ * Stitched authenc(hmac(sha1),cbc(aes)) for IPsec ESP
+ *
+ * The authenc template runs the cipher and the hash as two separate
+ * passes over the request, so every byte of an ESP payload is pulled
+ * through the cache twice.  This implementation processes the payload
+ * one SHA1 block (four AES blocks) at a time: each chunk is copied into
+ * an on-stack buffer, CBC encrypted (or hashed) and then hashed (or
+ * decrypted) while it is still hot, and written back once.
+ *
+ * The AES block function is taken from whatever "aes" cipher has the
+ * highest priority, SHA1 uses the library sha_transform().
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ */
+
+#include <crypto/aead.h>
+#include <crypto/aes.h>
+#include <crypto/algapi.h>
+#include <crypto/authenc.h>
+#include <crypto/scatterwalk.h>
+#include <crypto/sha.h>
+#include <linux/cryptohash.h>
+#include <linux/err.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/rtnetlink.h>
+#include <linux/string.h>
+#include <asm/unaligned.h>
+
+struct aes_cbc_sha1_ctx {
+	struct crypto_cipher *aes;
+	struct sha1_state ipad;
+	struct sha1_state opad;
+	u8 salt[AES_BLOCK_SIZE];
+};
+
+static void aes_cbc_sha1_init_state(struct sha1_state *sctx)
+{
+	*sctx = (struct sha1_state){
+		.state = { SHA1_H0, SHA1_H1, SHA1_H2, SHA1_H3, SHA1_H4 },
+	};
+}
+
+static void aes_cbc_sha1_update(struct sha1_state *sctx, const u8 *data,
+				unsigned int len, u32 *temp)
+{
+	unsigned int partial = sctx->count % SHA1_BLOCK_SIZE;
+
+	sctx->count += len;
+
+	if (partial) {
+		unsigned int n = min(len, SHA1_BLOCK_SIZE - partial);
+
+		memcpy(sctx->buffer + partial, data, n);
+		data += n;
+		len -= n;
+		if (partial + n < SHA1_BLOCK_SIZE)
+			return;
+		sha_transform(sctx->state, sctx->buffer, temp);
+	}
+
+	for (; len >= SHA1_BLOCK_SIZE; len -= SHA1_BLOCK_SIZE) {
+		sha_transform(sctx->state, data, temp);
+		data += SHA1_BLOCK_SIZE;
+	}
+
+	memcpy(sctx->buffer, data, len);
+}
+
+static void aes_cbc_sha1_final(struct sha1_state *sctx, u8 *out, u32 *temp)
+{
+	static const u8 padding[SHA1_BLOCK_SIZE] = { 0x80, };
+	__be32 *dst = (__be32 *)out;
+	unsigned int index, padlen;
+	__be64 bits;
+	int i;
+
+	bits = cpu_to_be64(sctx->count << 3);
+
+	index = sctx->count % SHA1_BLOCK_SIZE;
+	padlen = (index < 56) ? (56 - index) : ((SHA1_BLOCK_SIZE + 56) - index);
+	aes_cbc_sha1_update(sctx, padding, padlen, temp);
+	aes_cbc_sha1_update(sctx, (const u8 *)&bits, sizeof(bits), temp);
+
+	for (i = 0; i < SHA1_DIGEST_SIZE / 4; i++)
+		put_unaligned(cpu_to_be32(sctx->state[i]), dst++);
+}
+
+static void aes_cbc_sha1_update_sg(struct sha1_state *sctx,
+				   struct scatterlist *sg, unsigned int len,
+				   u32 *temp)
+{
+	struct scatter_walk walk;
+	u8 *vaddr;
+	unsigned int n;
+
+	if (!len)
+		return;
+
+	scatterwalk_start(&walk, sg);
+
+	for (;;) {
+		n = min(scatterwalk_clamp(&walk, len), len);
+		vaddr = scatterwalk_map(&walk);
+		aes_cbc_sha1_update(sctx, vaddr, n, temp);
+		scatterwalk_unmap(vaddr);
+
+		scatterwalk_advance(&walk, n);
+		len -= n;
+		scatterwalk_done(&walk, 0, len);
+		if (!len)
+			break;
+	}
+}
+
+static int aes_cbc_sha1_setkey(struct crypto_aead *tfm, const u8 *key,
+			       unsigned int keylen)
+{
+	struct aes_cbc_sha1_ctx *ctx = crypto_aead_ctx(tfm);
+	struct rtattr *rta = (void *)key;
+	struct crypto_authenc_key_param *param;
+	u32 temp[SHA_WORKSPACE_WORDS];
+	u8 pad[SHA1_BLOCK_SIZE];
+	unsigned int authkeylen;
+	unsigned int enckeylen;
+	int i, err;
+
+	if (!RTA_OK(rta, keylen))
+		goto badkey;
+	if (rta->rta_type != CRYPTO_AUTHENC_KEYA_PARAM)
+		goto badkey;
+	if (RTA_PAYLOAD(rta) < sizeof(*param))
+		goto badkey;
+
+	param = RTA_DATA(rta);
+	enckeylen = be32_to_cpu(param->enckeylen);
+
+	key += RTA_ALIGN(rta->rta_len);
+	keylen -= RTA_ALIGN(rta->rta_len);
+
+	if (keylen < enckeylen)
+		goto badkey;
+
+	authkeylen = keylen - enckeylen;
+
+	crypto_cipher_clear_flags(ctx->aes, CRYPTO_TFM_REQ_MASK);
+	crypto_cipher_set_flags(ctx->aes, crypto_aead_get_flags(tfm) &
+					  CRYPTO_TFM_REQ_MASK);
+	err = crypto_cipher_setkey(ctx->aes, key + authkeylen, enckeylen);
+	crypto_aead_set_flags(tfm, crypto_cipher_get_flags(ctx->aes) &
+				   CRYPTO_TFM_RES_MASK);
+	if (err)
+		return err;
+
+	/* HMAC: keys longer than a block are hashed first. */
+	memset(pad, 0, sizeof(pad));
+	if (authkeylen > SHA1_BLOCK_SIZE) {
+		aes_cbc_sha1_init_state(&ctx->ipad);
+		aes_cbc_sha1_update(&ctx->ipad, key, authkeylen, temp);
+		aes_cbc_sha1_final(&ctx->ipad, pad, temp);
+	} else {
+		memcpy(pad, key, authkeylen);
+	}
+
+	for (i = 0; i < SHA1_BLOCK_SIZE; i++)
+		pad[i] ^= 0x36;
+	aes_cbc_sha1_init_state(&ctx->ipad);
+	aes_cbc_sha1_update(&ctx->ipad, pad, SHA1_BLOCK_SIZE, temp);
+
+	for (i = 0; i < SHA1_BLOCK_SIZE; i++)
+		pad[i] ^= 0x36 ^ 0x5c;
+	aes_cbc_sha1_init_state(&ctx->opad);
+	aes_cbc_sha1_update(&ctx->opad, pad, SHA1_BLOCK_SIZE, temp);
+
+	memset(pad, 0, sizeof(pad));
+	memset(temp, 0, sizeof(temp));
+
+	return 0;
+
+badkey:
+	crypto_aead_set_flags(tfm, CRYPTO_TFM_RES_BAD_KEY_LEN);
+	return -EINVAL;
+}
+
+/*
+ * Hash assoc || iv and return the inner HMAC state, ready for the
+ * ciphertext.
+ */
+static void aes_cbc_sha1_start(struct aead_request *req, const u8 *iv,
+			       struct sha1_state *sctx, u32 *temp)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	struct aes_cbc_sha1_ctx *ctx = crypto_aead_ctx(tfm);
+
+	*sctx = ctx->ipad;
+	aes_cbc_sha1_update_sg(sctx, req->assoc, req->assoclen, temp);
+	aes_cbc_sha1_update(sctx, iv, AES_BLOCK_SIZE, temp);
+}
+
+static void aes_cbc_sha1_finish(struct crypto_aead *tfm,
+				struct sha1_state *sctx, u8 *hash, u32 *temp)
+{
+	struct aes_cbc_sha1_ctx *ctx = crypto_aead_ctx(tfm);
+
+	aes_cbc_sha1_final(sctx, hash, temp);
+	*sctx = ctx->opad;
+	aes_cbc_sha1_update(sctx, hash, SHA1_DIGEST_SIZE, temp);
+	aes_cbc_sha1_final(sctx, hash, temp);
+}
+
+/*
+ * Walk src and dst one SHA1 block at a time.  Encryption hashes the
+ * chunk after encrypting it, decryption before decrypting it, so each
+ * chunk is read from and written to the scatterlists exactly once.
+ */
+static void aes_cbc_sha1_crypt(struct aead_request *req, int enc,
+			       unsigned int cryptlen, u8 *iv,
+			       struct sha1_state *sctx, u32 *temp)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	struct aes_cbc_sha1_ctx *ctx = crypto_aead_ctx(tfm);
+	struct crypto_cipher *aes = ctx->aes;
+	struct scatter_walk in, out;
+	u8 buf[SHA1_BLOCK_SIZE];
+	u8 prev[AES_BLOCK_SIZE];
+	unsigned int n, i;
+
+	if (!cryptlen)
+		return;
+
+	scatterwalk_start(&in, req->src);
+	scatterwalk_start(&out, req->dst);
+
+	do {
+		n = min_t(unsigned int, cryptlen, SHA1_BLOCK_SIZE);
+
+		scatterwalk_copychunks(buf, &in, n, 0);
+		scatterwalk_done(&in, 0, cryptlen - n);
+
+		if (enc) {
+			for (i = 0; i < n; i += AES_BLOCK_SIZE) {
+				crypto_xor(buf + i, iv, AES_BLOCK_SIZE);
+				crypto_cipher_encrypt_one(aes, buf + i,
+							  buf + i);
+				iv = buf + i;
+			}
+			aes_cbc_sha1_update(sctx, buf, n, temp);
+			memcpy(prev, iv, AES_BLOCK_SIZE);
+			iv = prev;
+		} else {
+			aes_cbc_sha1_update(sctx, buf, n, temp);
+			for (i = 0; i < n; i += AES_BLOCK_SIZE) {
+				u8 next[AES_BLOCK_SIZE];
+
+				memcpy(next, buf + i, AES_BLOCK_SIZE);
+				crypto_cipher_decrypt_one(aes, buf + i,
+							  buf + i);
+				crypto_xor(buf + i, iv, AES_BLOCK_SIZE);
+				memcpy(prev, next, AES_BLOCK_SIZE);
+				iv = prev;
+			}
+		}
+
+		scatterwalk_copychunks(buf, &out, n, 1);
+		cryptlen -= n;
+		scatterwalk_done(&out, 1, cryptlen);
+	} while (cryptlen);
+
+	memset(buf, 0, sizeof(buf));
+}
+
+static int aes_cbc_sha1_encrypt_iv(struct aead_request *req, u8 *iv)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	unsigned int authsize = crypto_aead_authsize(tfm);
+	u32 temp[SHA_WORKSPACE_WORDS];
+	u8 hash[SHA1_DIGEST_SIZE];
+	u8 civ[AES_BLOCK_SIZE];
+	struct sha1_state sctx;
+
+	if (req->cryptlen % AES_BLOCK_SIZE)
+		return -EINVAL;
+
+	memcpy(civ, iv, AES_BLOCK_SIZE);
+
+	aes_cbc_sha1_start(req, civ, &sctx, temp);
+	aes_cbc_sha1_crypt(req, 1, req->cryptlen, civ, &sctx, temp);
+	aes_cbc_sha1_finish(tfm, &sctx, hash, temp);
+
+	scatterwalk_map_and_copy(hash, req->dst, req->cryptlen, authsize, 1);
+	return 0;
+}
+
+static int aes_cbc_sha1_encrypt(struct aead_request *req)
+{
+	return aes_cbc_sha1_encrypt_iv(req, req->iv);
+}
+
+static int aes_cbc_sha1_givencrypt(struct aead_givcrypt_request *req)
+{
+	struct crypto_aead *tfm = aead_givcrypt_reqtfm(req);
+	struct aes_cbc_sha1_ctx *ctx = crypto_aead_ctx(tfm);
+	__be64 seq = cpu_to_be64(req->seq);
+	u8 *giv = req->giv;
+
+	/*
+	 * The IV is the encrypted sequence number, mixed with a per-tfm
+	 * salt, so it is unpredictable without the key just like the
+	 * eseqiv output the authenc template would produce.
+	 */
+	memcpy(giv, ctx->salt, AES_BLOCK_SIZE);
+	crypto_xor(giv + AES_BLOCK_SIZE - sizeof(seq), (u8 *)&seq,
+		   sizeof(seq));
+	crypto_cipher_encrypt_one(ctx->aes, giv, giv);
+
+	return aes_cbc_sha1_encrypt_iv(&req->areq, giv);
+}
+
+static void aes_cbc_sha1_zero(struct scatterlist *sg, unsigned int len)
+{
+	u8 zero[SHA1_BLOCK_SIZE] = { 0 };
+	unsigned int n, off;
+
+	for (off = 0; off < len; off += n) {
+		n = min_t(unsigned int, len - off, sizeof(zero));
+		scatterwalk_map_and_copy(zero, sg, off, n, 1);
+	}
+}
+
+static int aes_cbc_sha1_decrypt(struct aead_request *req)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	unsigned int authsize = crypto_aead_authsize(tfm);
+	unsigned int cryptlen = req->cryptlen;
+	u32 temp[SHA_WORKSPACE_WORDS];
+	u8 ihash[SHA1_DIGEST_SIZE];
+	u8 ohash[SHA1_DIGEST_SIZE];
+	u8 civ[AES_BLOCK_SIZE];
+	struct sha1_state sctx;
+
+	if (cryptlen < authsize)
+		return -EINVAL;
+	cryptlen -= authsize;
+	if (cryptlen % AES_BLOCK_SIZE)
+		return -EINVAL;
+
+	scatterwalk_map_and_copy(ihash, req->src, cryptlen, authsize, 0);
+
+	memcpy(civ, req->iv, AES_BLOCK_SIZE);
+
+	aes_cbc_sha1_start(req, civ, &sctx, temp);
+	aes_cbc_sha1_crypt(req, 0, cryptlen, civ, &sctx, temp);
+	aes_cbc_sha1_finish(tfm, &sctx, ohash, temp);
+
+	if (memcmp(ihash, ohash, authsize)) {
+		/* Do not hand out unauthenticated plaintext. */
+		aes_cbc_sha1_zero(req->dst, cryptlen);
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+static int aes_cbc_sha1_init_tfm(struct crypto_tfm *tfm)
+{
+	struct aes_cbc_sha1_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct crypto_cipher *aes;
+
+	aes = crypto_alloc_cipher("aes", 0, 0);
+	if (IS_ERR(aes))
+		return PTR_ERR(aes);
+
+	ctx->aes = aes;
+	get_random_bytes(ctx->salt, sizeof(ctx->salt));
+
+	return 0;
+}
+
+static void aes_cbc_sha1_exit_tfm(struct crypto_tfm *tfm)
+{
+	struct aes_cbc_sha1_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	crypto_free_cipher(ctx->aes);
+}
+
+/*
+ * Priority sits above the authenc template built from the generic and
+ * assembler AES/SHA1 (at most 2100), but below compositions that use
+ * dedicated AES instructions.
+ */
+static struct crypto_alg aes_cbc_sha1_alg = {
+	.cra_name		= "authenc(hmac(sha1),cbc(aes))",
+	.cra_driver_name	= "authenc-hmac-sha1-cbc-aes-stitched",
+	.cra_priority		= 3000,
+	.cra_flags		= CRYPTO_ALG_TYPE_AEAD,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aes_cbc_sha1_ctx),
+	.cra_alignmask		= 0,
+	.cra_type		= &crypto_aead_type,
+	.cra_module		= THIS_MODULE,
+	.cra_init		= aes_cbc_sha1_init_tfm,
+	.cra_exit		= aes_cbc_sha1_exit_tfm,
+	.cra_u			= {
+		.aead = {
+			.setkey		= aes_cbc_sha1_setkey,
+			.encrypt	= aes_cbc_sha1_encrypt,
+			.decrypt	= aes_cbc_sha1_decrypt,
+			.givencrypt	= aes_cbc_sha1_givencrypt,
+			.ivsize		= AES_BLOCK_SIZE,
+			.maxauthsize	= SHA1_DIGEST_SIZE,
+		}
+	}
+};
+
+static int __init aes_cbc_sha1_mod_init(void)
+{
+	return crypto_register_alg(&aes_cbc_sha1_alg);
+}
+
+static void __exit aes_cbc_sha1_mod_fini(void)
+{
+	crypto_unregister_alg(&aes_cbc_sha1_alg);
+}
+
+module_init(aes_cbc_sha1_mod_init);
+module_exit(aes_cbc_sha1_mod_fini);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Stitched AES-CBC and HMAC-SHA1 AEAD for IPsec");
+MODULE_ALIAS("authenc(hmac(sha1),cbc(aes))");
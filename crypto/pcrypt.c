@@ -20,6 +20,8 @@
 
 #include <crypto/algapi.h>
 #include <crypto/internal/aead.h>
+#include <crypto/internal/hash.h>
+#include <crypto/internal/skcipher.h>
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/module.h>
@@ -57,6 +59,7 @@ struct padata_pcrypt {
 
 static struct padata_pcrypt pencrypt;
 static struct padata_pcrypt pdecrypt;
+static struct padata_pcrypt phash;
 static struct kset           *pcrypt_kset;
 
 struct pcrypt_instance_ctx {
@@ -64,11 +67,55 @@ struct pcrypt_instance_ctx {
 	unsigned int tfm_count;
 };
 
+struct pcrypt_skcipher_instance_ctx {
+	struct crypto_skcipher_spawn spawn;
+	unsigned int tfm_count;
+};
+
+struct pcrypt_ahash_instance_ctx {
+	struct crypto_ahash_spawn spawn;
+	unsigned int tfm_count;
+};
+
 struct pcrypt_aead_ctx {
 	struct crypto_aead *child;
 	unsigned int cb_cpu;
 };
 
+struct pcrypt_skcipher_ctx {
+	struct crypto_ablkcipher *child;
+	unsigned int cb_cpu;
+};
+
+struct pcrypt_ahash_ctx {
+	struct crypto_ahash *child;
+	unsigned int cb_cpu;
+};
+
+/*
+ * The child request of an asynchronous child may be put on a backlog,
+ * in which case it completes twice: first with -EINPROGRESS once it
+ * leaves the backlog, then with the final status.
+ */
+static inline int pcrypt_in_flight(int err, u32 flags)
+{
+	return err == -EINPROGRESS ||
+	       (err == -EBUSY && (flags & CRYPTO_TFM_REQ_MAY_BACKLOG));
+}
+
+static unsigned int pcrypt_pick_cb_cpu(unsigned int tfm_count)
+{
+	unsigned int cpu, cb_cpu, cpu_index;
+
+	cpu_index = tfm_count % cpumask_weight(cpu_online_mask);
+
+	cb_cpu = cpumask_first(cpu_online_mask);
+	for (cpu = 0; cpu < cpu_index; cpu++)
+		cb_cpu = cpumask_next(cb_cpu, cpu_online_mask);
+
+	return cb_cpu;
+}
+
 static int pcrypt_do_parallel(struct padata_priv *padata, unsigned int *cb_cpu,
 			      struct padata_pcrypt *pcrypt)
 {
@@ -272,19 +319,12 @@ static int pcrypt_aead_givencrypt(struct aead_givcrypt_request *req)
 
 static int pcrypt_aead_init_tfm(struct crypto_tfm *tfm)
 {
-	int cpu, cpu_index;
 	struct crypto_instance *inst = crypto_tfm_alg_instance(tfm);
 	struct pcrypt_instance_ctx *ictx = crypto_instance_ctx(inst);
 	struct pcrypt_aead_ctx *ctx = crypto_tfm_ctx(tfm);
 	struct crypto_aead *cipher;
 
-	ictx->tfm_count++;
-
-	cpu_index = ictx->tfm_count % cpumask_weight(cpu_online_mask);
-
-	ctx->cb_cpu = cpumask_first(cpu_online_mask);
-	for (cpu = 0; cpu < cpu_index; cpu++)
-		ctx->cb_cpu = cpumask_next(ctx->cb_cpu, cpu_online_mask);
+	ctx->cb_cpu = pcrypt_pick_cb_cpu(++ictx->tfm_count);
 
 	cipher = crypto_spawn_aead(crypto_instance_ctx(inst));
 
@@ -306,17 +346,321 @@ static void pcrypt_aead_exit_tfm(struct crypto_tfm *tfm)
 	crypto_free_aead(ctx->child);
 }
 
-static struct crypto_instance *pcrypt_alloc_instance(struct crypto_alg *alg)
+static int pcrypt_skcipher_setkey(struct crypto_ablkcipher *parent,
+				  const u8 *key, unsigned int keylen)
+{
+	struct pcrypt_skcipher_ctx *ctx = crypto_ablkcipher_ctx(parent);
+	struct crypto_ablkcipher *child = ctx->child;
+	int err;
+
+	crypto_ablkcipher_clear_flags(child, CRYPTO_TFM_REQ_MASK);
+	crypto_ablkcipher_set_flags(child, crypto_ablkcipher_get_flags(parent) &
+					   CRYPTO_TFM_REQ_MASK);
+	err = crypto_ablkcipher_setkey(child, key, keylen);
+	crypto_ablkcipher_set_flags(parent, crypto_ablkcipher_get_flags(child) &
+					    CRYPTO_TFM_RES_MASK);
+	return err;
+}
+
+static void pcrypt_skcipher_serial(struct padata_priv *padata)
+{
+	struct pcrypt_request *preq = pcrypt_padata_request(padata);
+	struct ablkcipher_request *req = pcrypt_request_ctx(preq);
+
+	ablkcipher_request_complete(req->base.data, padata->info);
+}
+
+static void pcrypt_skcipher_done(struct crypto_async_request *areq, int err)
+{
+	struct ablkcipher_request *req = areq->data;
+	struct pcrypt_request *preq = ablkcipher_request_ctx(req);
+	struct padata_priv *padata = pcrypt_request_padata(preq);
+
+	if (err == -EINPROGRESS)
+		return;
+
+	padata->info = err;
+	req->base.flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+	padata_do_serial(padata);
+}
+
+static void pcrypt_skcipher_enc(struct padata_priv *padata)
+{
+	struct pcrypt_request *preq = pcrypt_padata_request(padata);
+	struct ablkcipher_request *req = pcrypt_request_ctx(preq);
+
+	padata->info = crypto_ablkcipher_encrypt(req);
+
+	if (pcrypt_in_flight(padata->info, req->base.flags))
+		return;
+
+	padata_do_serial(padata);
+}
+
+static void pcrypt_skcipher_dec(struct padata_priv *padata)
+{
+	struct pcrypt_request *preq = pcrypt_padata_request(padata);
+	struct ablkcipher_request *req = pcrypt_request_ctx(preq);
+
+	padata->info = crypto_ablkcipher_decrypt(req);
+
+	if (pcrypt_in_flight(padata->info, req->base.flags))
+		return;
+
+	padata_do_serial(padata);
+}
+
+static int pcrypt_skcipher_crypt(struct ablkcipher_request *req,
+				 void (*parallel)(struct padata_priv *padata),
+				 struct padata_pcrypt *pcrypt)
+{
+	int err;
+	struct pcrypt_request *preq = ablkcipher_request_ctx(req);
+	struct ablkcipher_request *creq = pcrypt_request_ctx(preq);
+	struct padata_priv *padata = pcrypt_request_padata(preq);
+	struct crypto_ablkcipher *tfm = crypto_ablkcipher_reqtfm(req);
+	struct pcrypt_skcipher_ctx *ctx = crypto_ablkcipher_ctx(tfm);
+	u32 flags = req->base.flags;
+
+	memset(padata, 0, sizeof(struct padata_priv));
+
+	padata->parallel = parallel;
+	padata->serial = pcrypt_skcipher_serial;
+
+	ablkcipher_request_set_tfm(creq, ctx->child);
+	ablkcipher_request_set_callback(creq, flags & ~CRYPTO_TFM_REQ_MAY_SLEEP,
+					pcrypt_skcipher_done, req);
+	ablkcipher_request_set_crypt(creq, req->src, req->dst,
+				     req->nbytes, req->info);
+
+	err = pcrypt_do_parallel(padata, &ctx->cb_cpu, pcrypt);
+	if (!err)
+		return -EINPROGRESS;
+
+	return err;
+}
+
+static int pcrypt_skcipher_encrypt(struct ablkcipher_request *req)
+{
+	return pcrypt_skcipher_crypt(req, pcrypt_skcipher_enc, &pencrypt);
+}
+
+static int pcrypt_skcipher_decrypt(struct ablkcipher_request *req)
+{
+	return pcrypt_skcipher_crypt(req, pcrypt_skcipher_dec, &pdecrypt);
+}
+
+static int pcrypt_skcipher_init_tfm(struct crypto_tfm *tfm)
+{
+	struct crypto_instance *inst = crypto_tfm_alg_instance(tfm);
+	struct pcrypt_skcipher_instance_ctx *ictx = crypto_instance_ctx(inst);
+	struct pcrypt_skcipher_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct crypto_ablkcipher *cipher;
+
+	ctx->cb_cpu = pcrypt_pick_cb_cpu(++ictx->tfm_count);
+
+	cipher = crypto_spawn_skcipher(&ictx->spawn);
+	if (IS_ERR(cipher))
+		return PTR_ERR(cipher);
+
+	ctx->child = cipher;
+	tfm->crt_ablkcipher.reqsize = sizeof(struct pcrypt_request)
+		+ sizeof(struct ablkcipher_request)
+		+ crypto_ablkcipher_reqsize(cipher);
+
+	return 0;
+}
+
+static void pcrypt_skcipher_exit_tfm(struct crypto_tfm *tfm)
+{
+	struct pcrypt_skcipher_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	crypto_free_ablkcipher(ctx->child);
+}
+
+static int pcrypt_ahash_setkey(struct crypto_ahash *parent,
+			       const u8 *key, unsigned int keylen)
+{
+	struct pcrypt_ahash_ctx *ctx = crypto_ahash_ctx(parent);
+	struct crypto_ahash *child = ctx->child;
+	int err;
+
+	crypto_ahash_clear_flags(child, CRYPTO_TFM_REQ_MASK);
+	crypto_ahash_set_flags(child, crypto_ahash_get_flags(parent) &
+				      CRYPTO_TFM_REQ_MASK);
+	err = crypto_ahash_setkey(child, key, keylen);
+	crypto_ahash_set_flags(parent, crypto_ahash_get_flags(child) &
+				       CRYPTO_TFM_RES_MASK);
+	return err;
+}
+
+static void pcrypt_ahash_serial(struct padata_priv *padata)
+{
+	struct pcrypt_request *preq = pcrypt_padata_request(padata);
+	struct ahash_request *creq = pcrypt_request_ctx(preq);
+	struct ahash_request *req = creq->base.data;
+
+	req->base.complete(&req->base, padata->info);
+}
+
+static void pcrypt_ahash_done(struct crypto_async_request *areq, int err)
+{
+	struct ahash_request *req = areq->data;
+	struct pcrypt_request *preq = ahash_request_ctx(req);
+	struct padata_priv *padata = pcrypt_request_padata(preq);
+
+	if (err == -EINPROGRESS)
+		return;
+
+	padata->info = err;
+	req->base.flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+	padata_do_serial(padata);
+}
+
+/*
+ * The child request lives in the request context of the parent, so the
+ * partial hash state of the child survives between the init, update and
+ * final steps of one request.  Independent requests on the same tfm are
+ * what gets spread over the parallel cpumask.
+ */
+#define PCRYPT_AHASH_OP(name, op)					\
+static void pcrypt_ahash_##name(struct padata_priv *padata)		\
+{									\
+	struct pcrypt_request *preq = pcrypt_padata_request(padata);	\
+	struct ahash_request *req = pcrypt_request_ctx(preq);		\
+									\
+	padata->info = op(req);						\
+									\
+	if (pcrypt_in_flight(padata->info, req->base.flags))		\
+		return;							\
+									\
+	padata_do_serial(padata);					\
+}
+
+PCRYPT_AHASH_OP(do_init, crypto_ahash_init)
+PCRYPT_AHASH_OP(do_update, crypto_ahash_update)
+PCRYPT_AHASH_OP(do_final, crypto_ahash_final)
+PCRYPT_AHASH_OP(do_finup, crypto_ahash_finup)
+PCRYPT_AHASH_OP(do_digest, crypto_ahash_digest)
+
+static int pcrypt_ahash_enqueue(struct ahash_request *req,
+				void (*parallel)(struct padata_priv *padata))
+{
+	int err;
+	struct pcrypt_request *preq = ahash_request_ctx(req);
+	struct ahash_request *creq = pcrypt_request_ctx(preq);
+	struct padata_priv *padata = pcrypt_request_padata(preq);
+	struct crypto_ahash *tfm = crypto_ahash_reqtfm(req);
+	struct pcrypt_ahash_ctx *ctx = crypto_ahash_ctx(tfm);
+	u32 flags = req->base.flags;
+
+	memset(padata, 0, sizeof(struct padata_priv));
+
+	padata->parallel = parallel;
+	padata->serial = pcrypt_ahash_serial;
+
+	ahash_request_set_tfm(creq, ctx->child);
+	ahash_request_set_callback(creq, flags & ~CRYPTO_TFM_REQ_MAY_SLEEP,
+				   pcrypt_ahash_done, req);
+	ahash_request_set_crypt(creq, req->src, req->result, req->nbytes);
+
+	err = pcrypt_do_parallel(padata, &ctx->cb_cpu, &phash);
+	if (!err)
+		return -EINPROGRESS;
+
+	return err;
+}
+
+static int pcrypt_ahash_init(struct ahash_request *req)
+{
+	return pcrypt_ahash_enqueue(req, pcrypt_ahash_do_init);
+}
+
+static int pcrypt_ahash_update(struct ahash_request *req)
 {
+	return pcrypt_ahash_enqueue(req, pcrypt_ahash_do_update);
+}
+
+static int pcrypt_ahash_final(struct ahash_request *req)
+{
+	return pcrypt_ahash_enqueue(req, pcrypt_ahash_do_final);
+}
+
+static int pcrypt_ahash_finup(struct ahash_request *req)
+{
+	return pcrypt_ahash_enqueue(req, pcrypt_ahash_do_finup);
+}
+
+static int pcrypt_ahash_digest(struct ahash_request *req)
+{
+	return pcrypt_ahash_enqueue(req, pcrypt_ahash_do_digest);
+}
+
+static int pcrypt_ahash_export(struct ahash_request *req, void *out)
+{
+	struct pcrypt_request *preq = ahash_request_ctx(req);
+	struct ahash_request *creq = pcrypt_request_ctx(preq);
+	struct pcrypt_ahash_ctx *ctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+
+	ahash_request_set_tfm(creq, ctx->child);
+
+	return crypto_ahash_export(creq, out);
+}
+
+static int pcrypt_ahash_import(struct ahash_request *req, const void *in)
+{
+	struct pcrypt_request *preq = ahash_request_ctx(req);
+	struct ahash_request *creq = pcrypt_request_ctx(preq);
+	struct pcrypt_ahash_ctx *ctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+
+	ahash_request_set_tfm(creq, ctx->child);
+
+	return crypto_ahash_import(creq, in);
+}
+
+static int pcrypt_ahash_init_tfm(struct crypto_tfm *tfm)
+{
+	struct crypto_instance *inst = crypto_tfm_alg_instance(tfm);
+	struct pcrypt_ahash_instance_ctx *ictx = crypto_instance_ctx(inst);
+	struct pcrypt_ahash_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct crypto_ahash *hash;
+
+	ctx->cb_cpu = pcrypt_pick_cb_cpu(++ictx->tfm_count);
+
+	hash = crypto_spawn_ahash(&ictx->spawn);
+	if (IS_ERR(hash))
+		return PTR_ERR(hash);
+
+	ctx->child = hash;
+	crypto_ahash_set_reqsize(__crypto_ahash_cast(tfm),
+				 sizeof(struct pcrypt_request) +
+				 sizeof(struct ahash_request) +
+				 crypto_ahash_reqsize(hash));
+
+	return 0;
+}
+
+static void pcrypt_ahash_exit_tfm(struct crypto_tfm *tfm)
+{
+	struct pcrypt_ahash_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	crypto_free_ahash(ctx->child);
+}
+
+static void *pcrypt_alloc_instance(struct crypto_alg *alg, unsigned int head,
+				   unsigned int tail)
+{
+	char *p;
 	struct crypto_instance *inst;
-	struct pcrypt_instance_ctx *ctx;
 	int err;
 
-	inst = kzalloc(sizeof(*inst) + sizeof(*ctx), GFP_KERNEL);
-	if (!inst) {
-		inst = ERR_PTR(-ENOMEM);
-		goto out;
-	}
+	p = kzalloc(head + sizeof(*inst) + tail, GFP_KERNEL);
+	if (!p)
+		return ERR_PTR(-ENOMEM);
+
+	inst = (void *)(p + head);
 
 	err = -ENAMETOOLONG;
 	if (snprintf(inst->alg.cra_driver_name, CRYPTO_MAX_ALG_NAME,
@@ -325,39 +669,42 @@ static struct crypto_instance *pcrypt_alloc_instance(struct crypto_alg *alg)
 
 	memcpy(inst->alg.cra_name, alg->cra_name, CRYPTO_MAX_ALG_NAME);
 
-	ctx = crypto_instance_ctx(inst);
-	err = crypto_init_spawn(&ctx->spawn, alg, inst,
-				CRYPTO_ALG_TYPE_MASK);
-	if (err)
-		goto out_free_inst;
-
 	inst->alg.cra_priority = alg->cra_priority + 100;
 	inst->alg.cra_blocksize = alg->cra_blocksize;
 	inst->alg.cra_alignmask = alg->cra_alignmask;
 
 out:
-	return inst;
+	return p;
 
 out_free_inst:
-	kfree(inst);
-	inst = ERR_PTR(err);
+	kfree(p);
+	p = ERR_PTR(err);
 	goto out;
 }
 
-static struct crypto_instance *pcrypt_alloc_aead(struct rtattr **tb,
-						 u32 type, u32 mask)
+static int pcrypt_create_aead(struct crypto_template *tmpl,
+			      struct rtattr **tb, u32 type, u32 mask)
 {
+	struct pcrypt_instance_ctx *ctx;
 	struct crypto_instance *inst;
 	struct crypto_alg *alg;
+	int err;
 
 	alg = crypto_get_attr_alg(tb, type, (mask & CRYPTO_ALG_TYPE_MASK));
 	if (IS_ERR(alg))
-		return ERR_CAST(alg);
+		return PTR_ERR(alg);
 
-	inst = pcrypt_alloc_instance(alg);
+	inst = pcrypt_alloc_instance(alg, 0, sizeof(*ctx));
+	err = PTR_ERR(inst);
 	if (IS_ERR(inst))
 		goto out_put_alg;
 
+	ctx = crypto_instance_ctx(inst);
+	err = crypto_init_spawn(&ctx->spawn, alg, inst,
+				CRYPTO_ALG_TYPE_MASK);
+	if (err)
+		goto out_free_inst;
+
 	inst->alg.cra_flags = CRYPTO_ALG_TYPE_AEAD | CRYPTO_ALG_ASYNC;
 	inst->alg.cra_type = &crypto_aead_type;
 
@@ -376,33 +723,179 @@ static struct crypto_instance *pcrypt_alloc_aead(struct rtattr **tb,
 	inst->alg.cra_aead.decrypt = pcrypt_aead_decrypt;
 	inst->alg.cra_aead.givencrypt = pcrypt_aead_givencrypt;
 
+	err = crypto_register_instance(tmpl, inst);
+	if (err) {
+		crypto_drop_spawn(&ctx->spawn);
+out_free_inst:
+		kfree(inst);
+	}
+
 out_put_alg:
 	crypto_mod_put(alg);
-	return inst;
+	return err;
 }
 
-static struct crypto_instance *pcrypt_alloc(struct rtattr **tb)
+static int pcrypt_create_skcipher(struct crypto_template *tmpl,
+				  struct rtattr **tb, u32 type, u32 mask)
+{
+	struct pcrypt_skcipher_instance_ctx *ctx;
+	struct crypto_instance *inst;
+	struct crypto_alg *alg;
+	int err;
+
+	alg = crypto_get_attr_alg(tb, type, (mask & CRYPTO_ALG_TYPE_MASK));
+	if (IS_ERR(alg))
+		return PTR_ERR(alg);
+
+	inst = pcrypt_alloc_instance(alg, 0, sizeof(*ctx));
+	err = PTR_ERR(inst);
+	if (IS_ERR(inst))
+		goto out_put_alg;
+
+	ctx = crypto_instance_ctx(inst);
+	err = crypto_init_spawn(&ctx->spawn.base, alg, inst,
+				crypto_skcipher_mask(0));
+	if (err)
+		goto out_free_inst;
+
+	inst->alg.cra_flags = CRYPTO_ALG_TYPE_ABLKCIPHER | CRYPTO_ALG_ASYNC;
+	inst->alg.cra_type = &crypto_ablkcipher_type;
+
+	if ((alg->cra_flags & CRYPTO_ALG_TYPE_MASK) ==
+	    CRYPTO_ALG_TYPE_BLKCIPHER) {
+		inst->alg.cra_ablkcipher.ivsize = alg->cra_blkcipher.ivsize;
+		inst->alg.cra_ablkcipher.min_keysize =
+			alg->cra_blkcipher.min_keysize;
+		inst->alg.cra_ablkcipher.max_keysize =
+			alg->cra_blkcipher.max_keysize;
+		inst->alg.cra_ablkcipher.geniv = alg->cra_blkcipher.geniv;
+	} else {
+		inst->alg.cra_ablkcipher.ivsize = alg->cra_ablkcipher.ivsize;
+		inst->alg.cra_ablkcipher.min_keysize =
+			alg->cra_ablkcipher.min_keysize;
+		inst->alg.cra_ablkcipher.max_keysize =
+			alg->cra_ablkcipher.max_keysize;
+		inst->alg.cra_ablkcipher.geniv = alg->cra_ablkcipher.geniv;
+	}
+
+	inst->alg.cra_ctxsize = sizeof(struct pcrypt_skcipher_ctx);
+
+	inst->alg.cra_init = pcrypt_skcipher_init_tfm;
+	inst->alg.cra_exit = pcrypt_skcipher_exit_tfm;
+
+	inst->alg.cra_ablkcipher.setkey = pcrypt_skcipher_setkey;
+	inst->alg.cra_ablkcipher.encrypt = pcrypt_skcipher_encrypt;
+	inst->alg.cra_ablkcipher.decrypt = pcrypt_skcipher_decrypt;
+
+	err = crypto_register_instance(tmpl, inst);
+	if (err) {
+		crypto_drop_skcipher(&ctx->spawn);
+out_free_inst:
+		kfree(inst);
+	}
+
+out_put_alg:
+	crypto_mod_put(alg);
+	return err;
+}
+
+static int pcrypt_create_ahash(struct crypto_template *tmpl,
+			       struct rtattr **tb, u32 type, u32 mask)
+{
+	struct pcrypt_ahash_instance_ctx *ctx;
+	struct ahash_instance *inst;
+	struct hash_alg_common *halg;
+	struct crypto_alg *alg;
+	int err;
+
+	halg = ahash_attr_alg(tb[1], CRYPTO_ALG_TYPE_HASH,
+			      CRYPTO_ALG_TYPE_AHASH_MASK);
+	if (IS_ERR(halg))
+		return PTR_ERR(halg);
+
+	alg = &halg->base;
+	inst = pcrypt_alloc_instance(alg, ahash_instance_headroom(),
+				     sizeof(*ctx));
+	err = PTR_ERR(inst);
+	if (IS_ERR(inst))
+		goto out_put_alg;
+
+	ctx = ahash_instance_ctx(inst);
+	err = crypto_init_ahash_spawn(&ctx->spawn, halg,
+				      ahash_crypto_instance(inst));
+	if (err)
+		goto out_free_inst;
+
+	inst->alg.halg.base.cra_flags = CRYPTO_ALG_ASYNC;
+
+	inst->alg.halg.digestsize = halg->digestsize;
+	inst->alg.halg.statesize = halg->statesize;
+	inst->alg.halg.base.cra_ctxsize = sizeof(struct pcrypt_ahash_ctx);
+
+	inst->alg.halg.base.cra_init = pcrypt_ahash_init_tfm;
+	inst->alg.halg.base.cra_exit = pcrypt_ahash_exit_tfm;
+
+	inst->alg.init   = pcrypt_ahash_init;
+	inst->alg.update = pcrypt_ahash_update;
+	inst->alg.final  = pcrypt_ahash_final;
+	inst->alg.finup  = pcrypt_ahash_finup;
+	inst->alg.digest = pcrypt_ahash_digest;
+	inst->alg.export = pcrypt_ahash_export;
+	inst->alg.import = pcrypt_ahash_import;
+	inst->alg.setkey = pcrypt_ahash_setkey;
+
+	err = ahash_register_instance(tmpl, inst);
+	if (err) {
+		crypto_drop_ahash(&ctx->spawn);
+out_free_inst:
+		kfree(inst);
+	}
+
+out_put_alg:
+	crypto_mod_put(alg);
+	return err;
+}
+
+static int pcrypt_create(struct crypto_template *tmpl, struct rtattr **tb)
 {
 	struct crypto_attr_type *algt;
 
 	algt = crypto_get_attr_type(tb);
 	if (IS_ERR(algt))
-		return ERR_CAST(algt);
+		return PTR_ERR(algt);
 
 	switch (algt->type & algt->mask & CRYPTO_ALG_TYPE_MASK) {
 	case CRYPTO_ALG_TYPE_AEAD:
-		return pcrypt_alloc_aead(tb, algt->type, algt->mask);
+		return pcrypt_create_aead(tmpl, tb, algt->type, algt->mask);
+	case CRYPTO_ALG_TYPE_BLKCIPHER:
+		return pcrypt_create_skcipher(tmpl, tb, algt->type,
+					      algt->mask);
+	case CRYPTO_ALG_TYPE_DIGEST:
+		return pcrypt_create_ahash(tmpl, tb, algt->type, algt->mask);
 	}
 
-	return ERR_PTR(-EINVAL);
+	return -EINVAL;
 }
 
 static void pcrypt_free(struct crypto_instance *inst)
 {
 	struct pcrypt_instance_ctx *ctx = crypto_instance_ctx(inst);
+	struct pcrypt_skcipher_instance_ctx *sctx = crypto_instance_ctx(inst);
+	struct pcrypt_ahash_instance_ctx *hctx = crypto_instance_ctx(inst);
 
-	crypto_drop_spawn(&ctx->spawn);
-	kfree(inst);
+	switch (inst->alg.cra_flags & CRYPTO_ALG_TYPE_MASK) {
+	case CRYPTO_ALG_TYPE_AHASH:
+		crypto_drop_ahash(&hctx->spawn);
+		kfree(ahash_instance(inst));
+		return;
+	case CRYPTO_ALG_TYPE_ABLKCIPHER:
+		crypto_drop_skcipher(&sctx->spawn);
+		kfree(inst);
+		return;
+	default:
+		crypto_drop_spawn(&ctx->spawn);
+		kfree(inst);
+	}
 }
 
 static int pcrypt_cpumask_change_notify(struct notifier_block *self,
@@ -516,7 +1009,7 @@ static void pcrypt_fini_padata(struct padata_pcrypt *pcrypt)
 
 static struct crypto_template pcrypt_tmpl = {
 	.name = "pcrypt",
-	.alloc = pcrypt_alloc,
+	.create = pcrypt_create,
 	.free = pcrypt_free,
 	.module = THIS_MODULE,
 };
@@ -537,11 +1030,18 @@ static int __init pcrypt_init(void)
 	if (err)
 		goto err_deinit_pencrypt;
 
+	err = pcrypt_init_padata(&phash, "phash");
+	if (err)
+		goto err_deinit_pdecrypt;
+
 	padata_start(pencrypt.pinst);
 	padata_start(pdecrypt.pinst);
+	padata_start(phash.pinst);
 
 	return crypto_register_template(&pcrypt_tmpl);
 
+err_deinit_pdecrypt:
+	pcrypt_fini_padata(&pdecrypt);
 err_deinit_pencrypt:
 	pcrypt_fini_padata(&pencrypt);
 err_unreg_kset:
@@ -554,6 +1054,7 @@ static void __exit pcrypt_exit(void)
 {
 	pcrypt_fini_padata(&pencrypt);
 	pcrypt_fini_padata(&pdecrypt);
+	pcrypt_fini_padata(&phash);
 
 	kset_unregister(pcrypt_kset);
 	crypto_unregister_template(&pcrypt_tmpl);
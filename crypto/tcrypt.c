@@ -22,6 +22,8 @@
  *
  */
 
+#include <crypto/aead.h>
+#include <crypto/authenc.h>
 #include <crypto/hash.h>
 #include <linux/err.h>
 #include <linux/init.h>
@@ -33,6 +35,13 @@
 #include <linux/jiffies.h>
 #include <linux/timex.h>
 #include <linux/interrupt.h>
+#include <linux/kernel_stat.h>
+#include <linux/kthread.h>
+#include <linux/rtnetlink.h>
+#include <linux/sort.h>
+#include <linux/tick.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
 #include "tcrypt.h"
 #include "internal.h"
 
@@ -920,6 +929,717 @@ out:
 	crypto_free_ablkcipher(tfm);
 }
 
+/*
+ * Key an authenc() transform with a 20 byte authentication key and an
+ * enckeylen byte cipher key, both filled with a constant pattern.
+ */
+static int tcrypt_authenc_setkey(struct crypto_aead *tfm,
+				 unsigned int enckeylen)
+{
+	char key[RTA_SPACE(sizeof(struct crypto_authenc_key_param)) + 20 + 32];
+	struct crypto_authenc_key_param *param;
+	struct rtattr *rta;
+
+	if (enckeylen > 32)
+		return -EINVAL;
+
+	memset(key, 0xa5, sizeof(key));
+
+	rta = (void *)key;
+	rta->rta_type = CRYPTO_AUTHENC_KEYA_PARAM;
+	rta->rta_len = RTA_LENGTH(sizeof(*param));
+	param = RTA_DATA(rta);
+	param->enckeylen = cpu_to_be32(enckeylen);
+
+	return crypto_aead_setkey(tfm, key, RTA_SPACE(sizeof(*param)) + 20 +
+					    enckeylen);
+}
+
+static inline int do_one_aead_op(struct aead_request *req, int ret)
+{
+	if (ret == -EINPROGRESS || ret == -EBUSY) {
+		struct tcrypt_result *tr = req->base.data;
+
+		ret = wait_for_completion_interruptible(&tr->completion);
+		if (!ret)
+			ret = tr->err;
+		INIT_COMPLETION(tr->completion);
+	}
+
+	return ret;
+}
+
+static int test_aead_jiffies(struct aead_request *req, int enc,
+			     int blen, int sec)
+{
+	unsigned long start, end;
+	int bcount;
+	int ret;
+
+	for (start = jiffies, end = start + sec * HZ, bcount = 0;
+	     time_before(jiffies, end); bcount++) {
+		if (enc)
+			ret = do_one_aead_op(req, crypto_aead_encrypt(req));
+		else
+			ret = do_one_aead_op(req, crypto_aead_decrypt(req));
+
+		if (ret)
+			return ret;
+	}
+
+	pr_cont("%d operations in %d seconds (%ld bytes)\n",
+		bcount, sec, (long)bcount * blen);
+	return 0;
+}
+
+static int test_aead_cycles(struct aead_request *req, int enc, int blen)
+{
+	unsigned long cycles = 0;
+	int ret = 0;
+	int i;
+
+	/* Warm-up run. */
+	for (i = 0; i < 4; i++) {
+		if (enc)
+			ret = do_one_aead_op(req, crypto_aead_encrypt(req));
+		else
+			ret = do_one_aead_op(req, crypto_aead_decrypt(req));
+
+		if (ret)
+			goto out;
+	}
+
+	/* The real thing. */
+	for (i = 0; i < 8; i++) {
+		cycles_t start, end;
+
+		start = get_cycles();
+		if (enc)
+			ret = do_one_aead_op(req, crypto_aead_encrypt(req));
+		else
+			ret = do_one_aead_op(req, crypto_aead_decrypt(req));
+		end = get_cycles();
+
+		if (ret)
+			goto out;
+
+		cycles += end - start;
+	}
+
+out:
+	if (ret == 0)
+		pr_cont("1 operation in %lu cycles (%d bytes)\n",
+			(cycles + 4) / 8, blen);
+
+	return ret;
+}
+
+/*
+ * Per-packet cost of an authenc() transform on ESP sized payloads: 8
+ * bytes of associated data (SPI and sequence number) and a 96 bit ICV.
+ * Decryption reads from tvmem[0] and writes to tvmem[1] so that the
+ * ciphertext stays valid across iterations.
+ */
+static void test_aead_speed(const char *algo, int enc, unsigned int sec,
+			    u8 *keysize)
+{
+	static u32 aead_sizes[] = { 16, 64, 256, 512, 1024, 1408, 0 };
+	const unsigned int authsize = 12;
+	struct scatterlist src, dst, asg;
+	struct tcrypt_result tresult;
+	struct aead_request *req;
+	struct crypto_aead *tfm;
+	char iv[32], assoc[8];
+	const char *e;
+	u32 *b_size;
+	int ret;
+
+	if (enc == ENCRYPT)
+		e = "encryption";
+	else
+		e = "decryption";
+
+	init_completion(&tresult.completion);
+
+	tfm = crypto_alloc_aead(algo, 0, 0);
+	if (IS_ERR(tfm)) {
+		pr_err("failed to load transform for %s: %ld\n", algo,
+		       PTR_ERR(tfm));
+		return;
+	}
+
+	pr_info("\ntesting speed of %s (%s) %s\n", algo,
+		crypto_tfm_alg_driver_name(crypto_aead_tfm(tfm)), e);
+
+	req = aead_request_alloc(tfm, GFP_KERNEL);
+	if (!req) {
+		pr_err("tcrypt: aead: Failed to allocate request for %s\n",
+		       algo);
+		goto out;
+	}
+
+	aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				  tcrypt_complete, &tresult);
+
+	ret = crypto_aead_setauthsize(tfm, authsize);
+	if (ret) {
+		pr_err("setauthsize() failed\n");
+		goto out_free_req;
+	}
+
+	memset(iv, 0xff, sizeof(iv));
+	memset(assoc, 0xff, sizeof(assoc));
+	sg_init_one(&asg, assoc, sizeof(assoc));
+
+	do {
+		for (b_size = aead_sizes; *b_size; b_size++) {
+			pr_info("%d bit key, %d byte packets: ", *keysize * 8,
+				*b_size);
+
+			crypto_aead_clear_flags(tfm, ~0);
+			ret = tcrypt_authenc_setkey(tfm, *keysize);
+			if (ret) {
+				pr_err("setkey() failed flags=%x\n",
+				       crypto_aead_get_flags(tfm));
+				goto out_free_req;
+			}
+
+			memset(tvmem[0], 0xff, PAGE_SIZE);
+			sg_init_one(&src, tvmem[0], *b_size + authsize);
+			sg_init_one(&dst, tvmem[1], *b_size + authsize);
+			aead_request_set_assoc(req, &asg, sizeof(assoc));
+
+			if (enc == DECRYPT) {
+				/* Produce a ciphertext with a valid ICV. */
+				aead_request_set_crypt(req, &src, &src,
+						       *b_size, iv);
+				ret = do_one_aead_op(req,
+						     crypto_aead_encrypt(req));
+				if (ret) {
+					pr_err("encryption failed: %d\n", ret);
+					break;
+				}
+				aead_request_set_crypt(req, &src, &dst,
+						       *b_size + authsize, iv);
+			} else {
+				aead_request_set_crypt(req, &src, &dst,
+						       *b_size, iv);
+			}
+
+			if (sec)
+				ret = test_aead_jiffies(req, enc, *b_size, sec);
+			else
+				ret = test_aead_cycles(req, enc, *b_size);
+
+			if (ret) {
+				pr_err("%s() failed flags=%x\n", e,
+				       crypto_aead_get_flags(tfm));
+				break;
+			}
+		}
+		keysize++;
+	} while (*keysize);
+
+out_free_req:
+	aead_request_free(req);
+out:
+	crypto_free_aead(tfm);
+}
+
+/*
+ * Multi-threaded async speed tests.  Each of mt_threads kthreads keeps
+ * mt_inflight requests outstanding on a shared transform for sec seconds
+ * and records the submit-to-completion latency of every request.
+ */
+#define TCRYPT_MT_MAX_INFLIGHT	64
+#define TCRYPT_MT_SAMPLES	4096
+#define TCRYPT_MT_BUFSIZE	(PAGE_SIZE + 64)
+
+static unsigned int mt_threads;
+static unsigned int mt_inflight = 8;
+
+enum tcrypt_mt_type {
+	TCRYPT_MT_CIPHER,
+	TCRYPT_MT_AHASH,
+	TCRYPT_MT_AEAD,
+};
+
+struct tcrypt_mt_test {
+	enum tcrypt_mt_type type;
+	int enc;
+	unsigned int blen;
+	unsigned long end;
+	union {
+		struct crypto_ablkcipher *cipher;
+		struct crypto_ahash *ahash;
+		struct crypto_aead *aead;
+	} tfm;
+};
+
+struct tcrypt_mt_thread;
+
+struct tcrypt_mt_req {
+	struct tcrypt_mt_thread *thread;
+	struct list_head list;
+	void *req;
+	char *buf;
+	struct scatterlist sg;
+	struct scatterlist asg;
+	u8 iv[32];
+	u8 assoc[8];
+	u8 result[64];
+	ktime_t start;
+	ktime_t end;
+	int err;
+};
+
+struct tcrypt_mt_thread {
+	struct tcrypt_mt_test *test;
+	struct tcrypt_mt_req reqs[TCRYPT_MT_MAX_INFLIGHT];
+	spinlock_t lock;
+	struct list_head done;
+	wait_queue_head_t wait;
+	struct completion exited;
+	unsigned int inflight;
+	unsigned long ops;
+	int err;
+	u32 *lat;
+	unsigned int nr_lat;
+};
+
+static void tcrypt_mt_done(struct tcrypt_mt_req *r, int err)
+{
+	struct tcrypt_mt_thread *t = r->thread;
+	unsigned long flags;
+
+	r->end = ktime_get();
+	r->err = err;
+
+	/*
+	 * Wake up under the lock: once the request is reaped the thread may
+	 * finish and its caller free @t, and only the unlock may follow.
+	 */
+	spin_lock_irqsave(&t->lock, flags);
+	list_add_tail(&r->list, &t->done);
+	wake_up(&t->wait);
+	spin_unlock_irqrestore(&t->lock, flags);
+}
+
+static void tcrypt_mt_complete(struct crypto_async_request *req, int err)
+{
+	if (err == -EINPROGRESS)
+		return;
+
+	tcrypt_mt_done(req->data, err);
+}
+
+static int tcrypt_mt_submit(struct tcrypt_mt_req *r)
+{
+	struct tcrypt_mt_test *test = r->thread->test;
+	int ret;
+
+	r->start = ktime_get();
+
+	switch (test->type) {
+	case TCRYPT_MT_CIPHER:
+		ret = test->enc ? crypto_ablkcipher_encrypt(r->req) :
+				  crypto_ablkcipher_decrypt(r->req);
+		break;
+	case TCRYPT_MT_AHASH:
+		ret = crypto_ahash_digest(r->req);
+		break;
+	default:
+		ret = test->enc ? crypto_aead_encrypt(r->req) :
+				  crypto_aead_decrypt(r->req);
+		break;
+	}
+
+	r->thread->inflight++;
+
+	if (ret == -EINPROGRESS || ret == -EBUSY)
+		return 0;
+
+	/* Synchronous completion, or an immediate error. */
+	tcrypt_mt_done(r, ret);
+	return 0;
+}
+
+static bool tcrypt_mt_has_done(struct tcrypt_mt_thread *t)
+{
+	bool ret;
+
+	spin_lock_irq(&t->lock);
+	ret = !list_empty(&t->done);
+	spin_unlock_irq(&t->lock);
+
+	return ret;
+}
+
+static void tcrypt_mt_reap(struct tcrypt_mt_thread *t, bool resubmit)
+{
+	struct tcrypt_mt_req *r, *n;
+	LIST_HEAD(done);
+
+	spin_lock_irq(&t->lock);
+	list_splice_init(&t->done, &done);
+	spin_unlock_irq(&t->lock);
+
+	list_for_each_entry_safe(r, n, &done, list) {
+		list_del(&r->list);
+		t->inflight--;
+
+		if (r->err) {
+			/* Decryption of garbage fails the aead tag check. */
+			if (!(r->err == -EBADMSG &&
+			      t->test->type == TCRYPT_MT_AEAD) && !t->err)
+				t->err = r->err;
+		}
+
+		t->lat[t->ops % TCRYPT_MT_SAMPLES] =
+			min_t(s64, ktime_to_ns(ktime_sub(r->end, r->start)),
+			      UINT_MAX);
+		t->ops++;
+
+		if (resubmit && !t->err)
+			tcrypt_mt_submit(r);
+	}
+}
+
+static int tcrypt_mt_thread_fn(void *data)
+{
+	struct tcrypt_mt_thread *t = data;
+	unsigned int i;
+
+	for (i = 0; i < mt_inflight; i++)
+		tcrypt_mt_submit(&t->reqs[i]);
+
+	while (time_before(jiffies, t->test->end) && !t->err) {
+		wait_event_timeout(t->wait, tcrypt_mt_has_done(t), HZ / 10);
+		tcrypt_mt_reap(t, true);
+	}
+
+	while (t->inflight) {
+		wait_event(t->wait, tcrypt_mt_has_done(t));
+		tcrypt_mt_reap(t, false);
+	}
+
+	t->nr_lat = min_t(unsigned long, t->ops, TCRYPT_MT_SAMPLES);
+	complete(&t->exited);
+
+	return 0;
+}
+
+static int tcrypt_mt_init_req(struct tcrypt_mt_test *test,
+			      struct tcrypt_mt_req *r)
+{
+	unsigned int blen = test->blen;
+
+	r->buf = kmalloc(TCRYPT_MT_BUFSIZE, GFP_KERNEL);
+	if (!r->buf)
+		return -ENOMEM;
+
+	memset(r->buf, 0xff, TCRYPT_MT_BUFSIZE);
+	memset(r->iv, 0xff, sizeof(r->iv));
+	memset(r->assoc, 0xff, sizeof(r->assoc));
+
+	switch (test->type) {
+	case TCRYPT_MT_CIPHER: {
+		struct ablkcipher_request *req;
+
+		req = ablkcipher_request_alloc(test->tfm.cipher, GFP_KERNEL);
+		if (!req)
+			return -ENOMEM;
+
+		sg_init_one(&r->sg, r->buf, blen);
+		ablkcipher_request_set_callback(req,
+						CRYPTO_TFM_REQ_MAY_BACKLOG,
+						tcrypt_mt_complete, r);
+		ablkcipher_request_set_crypt(req, &r->sg, &r->sg, blen, r->iv);
+		r->req = req;
+		break;
+	}
+	case TCRYPT_MT_AHASH: {
+		struct ahash_request *req;
+
+		req = ahash_request_alloc(test->tfm.ahash, GFP_KERNEL);
+		if (!req)
+			return -ENOMEM;
+
+		sg_init_one(&r->sg, r->buf, blen);
+		ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   tcrypt_mt_complete, r);
+		ahash_request_set_crypt(req, &r->sg, r->result, blen);
+		r->req = req;
+		break;
+	}
+	case TCRYPT_MT_AEAD: {
+		struct aead_request *req;
+		unsigned int authsize = crypto_aead_authsize(test->tfm.aead);
+
+		req = aead_request_alloc(test->tfm.aead, GFP_KERNEL);
+		if (!req)
+			return -ENOMEM;
+
+		/* Leave room for the tag; decryption includes it in blen. */
+		sg_init_one(&r->sg, r->buf, blen + authsize);
+		sg_init_one(&r->asg, r->assoc, sizeof(r->assoc));
+		aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					  tcrypt_mt_complete, r);
+		aead_request_set_crypt(req, &r->sg, &r->sg,
+				       test->enc ? blen : blen + authsize,
+				       r->iv);
+		aead_request_set_assoc(req, &r->asg, sizeof(r->assoc));
+		r->req = req;
+		break;
+	}
+	}
+
+	return 0;
+}
+
+static void tcrypt_mt_free_req(struct tcrypt_mt_test *test,
+			       struct tcrypt_mt_req *r)
+{
+	if (r->req) {
+		switch (test->type) {
+		case TCRYPT_MT_CIPHER:
+			ablkcipher_request_free(r->req);
+			break;
+		case TCRYPT_MT_AHASH:
+			ahash_request_free(r->req);
+			break;
+		case TCRYPT_MT_AEAD:
+			aead_request_free(r->req);
+			break;
+		}
+	}
+	kfree(r->buf);
+}
+
+/* Sum of idle and iowait time over all online CPUs, in microseconds. */
+static u64 tcrypt_mt_idle_us(void)
+{
+	u64 idle = 0, t;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		t = get_cpu_idle_time_us(cpu, NULL);
+		if (t == -1ULL)
+			t = cputime_to_usecs(kcpustat_cpu(cpu).cpustat[CPUTIME_IDLE]);
+		idle += t;
+
+		t = get_cpu_iowait_time_us(cpu, NULL);
+		if (t == -1ULL)
+			t = cputime_to_usecs(kcpustat_cpu(cpu).cpustat[CPUTIME_IOWAIT]);
+		idle += t;
+	}
+
+	return idle;
+}
+
+static int tcrypt_mt_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int tcrypt_mt_run(struct tcrypt_mt_test *test, unsigned int nthreads)
+{
+	struct tcrypt_mt_thread *threads;
+	u64 idle, elapsed_us, busy_us, total_us;
+	unsigned long ops = 0;
+	unsigned int i, j, n = 0, cpu = 0, started;
+	ktime_t start;
+	u32 *lat = NULL;
+	int ret = 0;
+
+	threads = vzalloc(nthreads * sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	for (i = 0; i < nthreads; i++) {
+		struct tcrypt_mt_thread *t = &threads[i];
+
+		t->test = test;
+		spin_lock_init(&t->lock);
+		INIT_LIST_HEAD(&t->done);
+		init_waitqueue_head(&t->wait);
+		init_completion(&t->exited);
+
+		t->lat = vmalloc(TCRYPT_MT_SAMPLES * sizeof(*t->lat));
+		if (!t->lat) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		for (j = 0; j < mt_inflight; j++) {
+			t->reqs[j].thread = t;
+			ret = tcrypt_mt_init_req(test, &t->reqs[j]);
+			if (ret)
+				goto out;
+		}
+	}
+
+	test->end = jiffies + (sec ?: 1) * HZ;
+	idle = tcrypt_mt_idle_us();
+	start = ktime_get();
+
+	for (started = 0; started < nthreads; started++) {
+		struct task_struct *task;
+
+		task = kthread_create(tcrypt_mt_thread_fn, &threads[started],
+				      "tcrypt/%u", started);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			break;
+		}
+
+		/* Spread the submitters round-robin over the online CPUs. */
+		cpu = started ? cpumask_next(cpu, cpu_online_mask) :
+			  cpumask_first(cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+		kthread_bind(task, cpu);
+		wake_up_process(task);
+	}
+
+	for (i = 0; i < started; i++)
+		wait_for_completion(&threads[i].exited);
+
+	elapsed_us = ktime_to_us(ktime_sub(ktime_get(), start));
+	idle = tcrypt_mt_idle_us() - idle;
+
+	for (i = 0; i < started; i++) {
+		ops += threads[i].ops;
+		n += threads[i].nr_lat;
+		if (threads[i].err && !ret)
+			ret = threads[i].err;
+	}
+
+	if (ret) {
+		pr_cont("failed: %d\n", ret);
+		goto out;
+	}
+
+	lat = vmalloc(max(n, 1U) * sizeof(*lat));
+	if (!lat) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0, j = 0; i < nthreads; i++) {
+		memcpy(lat + j, threads[i].lat,
+		       threads[i].nr_lat * sizeof(*lat));
+		j += threads[i].nr_lat;
+	}
+	sort(lat, n, sizeof(*lat), tcrypt_mt_cmp_u32, NULL);
+
+	total_us = elapsed_us * num_online_cpus();
+	busy_us = total_us > idle ? total_us - idle : 0;
+	elapsed_us = max_t(u64, elapsed_us, 1);
+
+	pr_cont("%8llu ops/s %6llu MB/s p50 %6u us p99 %6u us cpu %3llu%%\n",
+		div64_u64((u64)ops * USEC_PER_SEC, elapsed_us),
+		div64_u64((u64)ops * test->blen, elapsed_us),
+		n ? lat[n / 2] / 1000 : 0,
+		n ? lat[n * 99 / 100] / 1000 : 0,
+		div64_u64(busy_us * 100, max_t(u64, total_us, 1)));
+
+out:
+	for (i = 0; i < nthreads; i++) {
+		for (j = 0; j < mt_inflight; j++)
+			tcrypt_mt_free_req(test, &threads[i].reqs[j]);
+		vfree(threads[i].lat);
+	}
+	vfree(lat);
+	vfree(threads);
+
+	return ret;
+}
+
+static int tcrypt_mt_setkey(struct tcrypt_mt_test *test, const char *algo,
+			    unsigned int klen)
+{
+	char key[64];
+
+	memset(key, 0xa5, sizeof(key));
+
+	switch (test->type) {
+	case TCRYPT_MT_CIPHER:
+		return crypto_ablkcipher_setkey(test->tfm.cipher, key, klen);
+	case TCRYPT_MT_AHASH:
+		if (strncmp(algo, "hmac(", 5))
+			return 0;
+		return crypto_ahash_setkey(test->tfm.ahash, key, klen);
+	case TCRYPT_MT_AEAD:
+		if (strncmp(algo, "authenc(", 8))
+			return crypto_aead_setkey(test->tfm.aead, key, klen);
+		return tcrypt_authenc_setkey(test->tfm.aead, klen);
+	}
+
+	return -EINVAL;
+}
+
+static void test_mt_speed(const char *algo, enum tcrypt_mt_type type,
+			  int enc, unsigned int klen)
+{
+	static const unsigned int sizes[] = { 64, 256, 1024, 4096, 0 };
+	unsigned int nthreads = mt_threads ?: num_online_cpus();
+	struct tcrypt_mt_test test = { .type = type, .enc = enc };
+	struct crypto_tfm *tfm;
+	const unsigned int *b_size;
+	int ret;
+
+	mt_inflight = clamp(mt_inflight, 1U, (unsigned)TCRYPT_MT_MAX_INFLIGHT);
+
+	switch (type) {
+	case TCRYPT_MT_CIPHER:
+		test.tfm.cipher = crypto_alloc_ablkcipher(algo, 0, 0);
+		tfm = IS_ERR(test.tfm.cipher) ? ERR_CAST(test.tfm.cipher) :
+			crypto_ablkcipher_tfm(test.tfm.cipher);
+		break;
+	case TCRYPT_MT_AHASH:
+		test.tfm.ahash = crypto_alloc_ahash(algo, 0, 0);
+		tfm = IS_ERR(test.tfm.ahash) ? ERR_CAST(test.tfm.ahash) :
+			crypto_ahash_tfm(test.tfm.ahash);
+		break;
+	default:
+		test.tfm.aead = crypto_alloc_aead(algo, 0, 0);
+		tfm = IS_ERR(test.tfm.aead) ? ERR_CAST(test.tfm.aead) :
+			crypto_aead_tfm(test.tfm.aead);
+		break;
+	}
+
+	if (IS_ERR(tfm)) {
+		pr_err("failed to load transform for %s: %ld\n", algo,
+		       PTR_ERR(tfm));
+		return;
+	}
+
+	pr_info("\ntesting speed of %s (%s) %s, %u threads x %u requests\n",
+		algo, crypto_tfm_alg_driver_name(tfm),
+		type == TCRYPT_MT_AHASH ? "digest" :
+		enc ? "encryption" : "decryption", nthreads, mt_inflight);
+
+	ret = tcrypt_mt_setkey(&test, algo, klen);
+	if (ret) {
+		pr_err("setkey() failed flags=%x\n", crypto_tfm_get_flags(tfm));
+		goto out;
+	}
+
+	for (b_size = sizes; *b_size; b_size++) {
+		test.blen = *b_size;
+		pr_info("%s %5u bytes: ", crypto_tfm_alg_driver_name(tfm),
+			*b_size);
+		if (tcrypt_mt_run(&test, nthreads))
+			break;
+	}
+
+out:
+	crypto_free_tfm(tfm);
+}
+
 static void test_available(void)
 {
 	char **name = check;
@@ -1339,6 +2059,17 @@ static int do_test(int m)
 				  speed_template_32_64);
 		break;
 
+	case 211:
+		test_aead_speed("authenc(hmac(sha1-generic),cbc(aes-generic))",
+				ENCRYPT, sec, speed_template_16_24_32);
+		test_aead_speed("authenc(hmac(sha1-generic),cbc(aes-generic))",
+				DECRYPT, sec, speed_template_16_24_32);
+		test_aead_speed("authenc(hmac(sha1),cbc(aes))", ENCRYPT, sec,
+				speed_template_16_24_32);
+		test_aead_speed("authenc(hmac(sha1),cbc(aes))", DECRYPT, sec,
+				speed_template_16_24_32);
+		break;
+
 	case 300:
 		/* fall through */
 
@@ -1488,6 +2219,16 @@ static int do_test(int m)
 		test_ahash_speed("rmd320", sec, generic_hash_speed_template);
 		if (mode > 400 && mode < 500) break;
 
+	case 418:
+		test_ahash_speed("pcrypt(sha1)", sec,
+				 generic_hash_speed_template);
+		if (mode > 400 && mode < 500) break;
+
+	case 419:
+		test_ahash_speed("pcrypt(sha256)", sec,
+				 generic_hash_speed_template);
+		if (mode > 400 && mode < 500) break;
+
 	case 499:
 		break;
 
@@ -1563,6 +2304,40 @@ static int do_test(int m)
 				   speed_template_32_64);
 		break;
 
+	case 504:
+		test_acipher_speed("pcrypt(cbc(aes))", ENCRYPT, sec, NULL, 0,
+				   speed_template_16_24_32);
+		test_acipher_speed("pcrypt(cbc(aes))", DECRYPT, sec, NULL, 0,
+				   speed_template_16_24_32);
+		test_acipher_speed("pcrypt(ctr(aes))", ENCRYPT, sec, NULL, 0,
+				   speed_template_16_24_32);
+		test_acipher_speed("pcrypt(ctr(aes))", DECRYPT, sec, NULL, 0,
+				   speed_template_16_24_32);
+		break;
+
+	case 600:
+		test_mt_speed("cbc(aes)", TCRYPT_MT_CIPHER, ENCRYPT, 16);
+		test_mt_speed("cbc(aes)", TCRYPT_MT_CIPHER, DECRYPT, 16);
+		test_mt_speed("ctr(aes)", TCRYPT_MT_CIPHER, ENCRYPT, 16);
+		break;
+
+	case 601:
+		test_mt_speed("sha1", TCRYPT_MT_AHASH, ENCRYPT, 0);
+		test_mt_speed("sha256", TCRYPT_MT_AHASH, ENCRYPT, 0);
+		test_mt_speed("hmac(sha1)", TCRYPT_MT_AHASH, ENCRYPT, 20);
+		break;
+
+	case 602:
+		test_mt_speed("authenc(hmac(sha1),cbc(aes))", TCRYPT_MT_AEAD,
+			      ENCRYPT, 16);
+		test_mt_speed("gcm(aes)", TCRYPT_MT_AEAD, ENCRYPT, 16);
+		break;
+
+	case 603:
+		test_mt_speed("pcrypt(cbc(aes))", TCRYPT_MT_CIPHER, ENCRYPT, 16);
+		test_mt_speed("pcrypt(sha1)", TCRYPT_MT_AHASH, ENCRYPT, 0);
+		break;
+
 	case 1000:
 		test_available();
 		break;
@@ -1631,6 +2406,12 @@ module_param(mode, int, 0);
 module_param(sec, uint, 0);
 MODULE_PARM_DESC(sec, "Length in seconds of speed tests "
 		      "(defaults to zero which uses CPU cycles instead)");
+module_param(mt_threads, uint, 0);
+MODULE_PARM_DESC(mt_threads, "Number of submitting threads for the "
+		 "multi-threaded speed tests (defaults to online CPUs)");
+module_param(mt_inflight, uint, 0);
+MODULE_PARM_DESC(mt_inflight, "Outstanding requests per thread for the "
+		 "multi-threaded speed tests (1-64, default 8)");
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Quick & dirty crypto testing module");
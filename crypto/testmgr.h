@@ -6129,6 +6129,8 @@ static struct cipher_testvec cast6_dec_tv_template[] = {
 #define AES_CCM_DEC_TEST_VECTORS 7
 #define AES_CCM_4309_ENC_TEST_VECTORS 7
 #define AES_CCM_4309_DEC_TEST_VECTORS 10
+#define HMAC_SHA1_AES_CBC_ENC_TEST_VECTORS 5
+#define HMAC_SHA1_AES_CBC_DEC_TEST_VECTORS 5
 
 static struct cipher_testvec aes_enc_tv_template[] = {
 	{ /* From FIPS-197 */
@@ -10330,6 +10332,386 @@ static struct aead_testvec aes_ccm_rfc4309_dec_tv_template[] = {
 	},
 };
 
+static struct aead_testvec hmac_sha1_aes_cbc_enc_tv_template[] = {
+	{ /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x6a\xe5\x56\xfd\x1a\xca\xf1\x85"
+			  "\x4f\x16\xe7\x58\xb1\x26\x39\xe7"
+			  "\x55\x67\x40\xd5\x5e\xe5\x8a\x88"
+			  "\xc4\xcf\xe7\x74\x2c\xce\x78\xcc"
+			  "\x07\xda\xc5\xa6",
+		.klen	= 44,
+		.iv	= "\xc6\x52\x3e\x5d\x08\x19\xaf\x9e"
+			  "\xd1\x6c\xe5\x14\x57\x5a\x70\x8e",
+		.assoc	= "\xb0\x64\x25\x1a\x24\xe3\x5c\x88",
+		.alen	= 8,
+		.input	= "\xdf\x39\xde\x44\x18\x5d\xc9\x32"
+			  "\x8d\xda\x26\x1e\xe3\x05\x0f\xa3",
+		.ilen	= 16,
+		.result	= "\xce\xd6\xf5\x7b\x03\x66\xe7\x92"
+			  "\x87\x59\xb7\xe8\x06\x6f\xbd\x3b"
+			  "\xf6\x22\xb8\x6d\xc5\x11\xdf\xe9"
+			  "\xdc\x8d\x54\x48\xa0\xaf\x8c\x83"
+			  "\x14\x4b\x64\x6b",
+		.rlen	= 36,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x5d\x10\xfe\x7a\x4b\x64\x0d\x42"
+			  "\x13\x1e\x9c\x0a\xea\xc4\xa4\x71"
+			  "\xfd\xdc\x32\x4e\xa0\x1d\x87\xc2"
+			  "\xf3\xc3\xdb\x74\x4f\x49\x06\x77"
+			  "\xea\x45\xec\x3f",
+		.klen	= 44,
+		.iv	= "\x53\xaf\x92\xbc\x18\x36\x3b\xdb"
+			  "\xe2\x35\x4c\x64\xd8\x7d\xc1\x82",
+		.assoc	= "\x0c\xf4\xad\x3b\x90\xf1\x26\x57",
+		.alen	= 8,
+		.input	= "\x66\x8b\x30\x53\x4d\xfa\x50\x01"
+			  "\xf7\x88\xea\xa3\x5d\x73\x00\xf2"
+			  "\xaf\xc8\xf9\x53\xe7\x78\x20\x6a"
+			  "\xcc\xfc\x92\xf3\x53\x99\x5f\x24"
+			  "\x71\x45\x27\x32\xde\x8b\x3c\xfd"
+			  "\xab\xc2\x1d\x92\x38\x45\x32\x47"
+			  "\xc6\x07\x2f\x0c\x0e\x3f\xa9\x3b"
+			  "\x31\x40\x64\x63\xe2\x72\x4f\x5b",
+		.ilen	= 64,
+		.result	= "\xbb\x03\x29\xb2\x75\xde\xbb\x7c"
+			  "\x73\x22\xac\x24\x19\x48\xf0\x13"
+			  "\x97\x46\xca\xa0\x78\x47\xf8\x34"
+			  "\x92\xdd\x52\x27\x48\xae\x95\x58"
+			  "\x19\xbd\x20\x23\xe5\xa8\x04\x9c"
+			  "\x3a\x64\x65\xb2\xd8\x71\xd3\xa1"
+			  "\x10\xe9\x18\x1e\x07\x3a\xb0\x07"
+			  "\xf5\x77\x2a\xea\x83\xa6\x57\xd6"
+			  "\xc2\x00\x61\x33\xd9\xd3\x7f\x7d"
+			  "\x82\x94\x2e\x27\x3f\x91\x83\x69"
+			  "\x8e\x58\x7b\xf2",
+		.rlen	= 84,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x18" /* enc key length */
+			  "\xbe\x51\x7a\x8d\x3d\x68\xbe\xee"
+			  "\x40\x53\x14\x33\xf7\x7a\xf8\xf0"
+			  "\xad\x24\xeb\x59\xe6\xeb\xe4\x5f"
+			  "\x63\x80\x8c\xfb\x09\xa3\x69\xb8"
+			  "\x8e\x11\x9a\xdf\x0a\xb1\xe2\xc7"
+			  "\x05\xbd\xe0\xec",
+		.klen	= 52,
+		.iv	= "\xb4\x36\x7c\x15\xc0\x53\x9a\x59"
+			  "\xf3\xfa\xc8\x81\xc4\xf0\xae\xd4",
+		.assoc	= "\x1b\x9d\x15\xc7\x2f\x68\x58\xd6",
+		.alen	= 8,
+		.input	= "\xe9\xa5\x97\xc3\x38\x7d\x2d\xe8"
+			  "\x58\x0a\x4c\x14\x79\x9d\x94\xaa"
+			  "\x3f\xc0\x46\xa5\x2e\xfb\x77\x66"
+			  "\xd6\x4e\x50\xc7\x54\xaf\xfa\x67"
+			  "\xf0\xe5\x64\x68\x5c\x6f\x5c\x4c"
+			  "\x35\x82\x16\xd9\x6f\x64\x00\x45"
+			  "\xb6\x07\x6b\xce\xb9\xba\x41\x43"
+			  "\x0a\xe6\x89\xe2\xd3\xba\xd5\x45"
+			  "\xb0\x7c\xf0\x2e\xa1\xeb\x14\x70"
+			  "\x64\x2f\x9c\x4c\xa0\xa2\x7a\xe7",
+		.ilen	= 80,
+		.result	= "\xf3\xee\xfa\x5c\x57\xca\xc4\xcb"
+			  "\xd9\xa0\x45\x7e\x26\x6e\x02\x9b"
+			  "\x8e\xc4\x0d\xa7\x1b\x8a\x4b\x1f"
+			  "\x99\x8b\x93\x0c\xb1\x82\xf9\x63"
+			  "\x40\xad\x0d\xca\x4d\x82\xdb\xa6"
+			  "\x49\x1e\x55\xe1\xb1\x44\xce\x2f"
+			  "\x80\xf6\x0c\x14\x50\xac\xb1\x4c"
+			  "\xec\xf0\xa9\x16\x84\x09\x89\xcb"
+			  "\x54\x5b\x37\x1e\xd7\xba\x2c\x7b"
+			  "\x9a\xcd\xcd\x8b\x5f\x54\xf6\x68"
+			  "\x11\x6f\x9c\x2a\xf2\xbf\xfb\x3b"
+			  "\xe1\x96\x4b\x6b",
+		.rlen	= 92,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x20" /* enc key length */
+			  "\x4b\xeb\x54\x87\xe2\xbc\x97\xba"
+			  "\x32\xf0\x92\x13\xfb\x23\x8a\x30"
+			  "\x8c\xac\x9c\xff\xc4\xe2\xa9\xa4"
+			  "\xcb\xed\x44\xe6\x27\xf3\x99\x07"
+			  "\x5d\x91\x19\xf7\x7d\x23\x49\xe8"
+			  "\x37\xcc\x33\xc0\xf1\xae\xa3\x38"
+			  "\x5f\xae\x85\x2e",
+		.klen	= 60,
+		.iv	= "\xc2\xf8\x8d\x43\xad\x9d\xa2\xa4"
+			  "\x1a\x5b\xed\x25\xf0\x28\x07\x30",
+		.input	= "\x50\x08\x8e\x95\x09\x55\xd3\x09"
+			  "\x40\xf8\xf6\x98\x08\x36\x8c\xaa"
+			  "\x3a\x8d\xd8\xa5\x3f\x10\x44\xa0"
+			  "\x00\x63\x3c\xed\xf8\xf9\x42\x1e"
+			  "\xe5\x6b\x24\x0c\x4b\xeb\xaf\x72"
+			  "\x99\x79\x2b\xcd\x6b\xf7\xeb\x48",
+		.ilen	= 48,
+		.result	= "\x64\x67\x1d\xd6\x08\x7e\x2a\xc9"
+			  "\xbd\xe2\x93\xd2\x0f\xbf\xd1\x90"
+			  "\x95\xe4\x35\x5f\x6e\x24\xdf\x99"
+			  "\xa4\xcc\x1c\x45\xa6\x59\x6e\x87"
+			  "\x0b\x78\xe7\x35\xee\x28\x36\xd6"
+			  "\x2b\xd2\x51\xf1\x54\x95\x2a\x5d"
+			  "\x27\x21\xb8\x8e\x00\x6d\x6e\xb9"
+			  "\x41\x68\xda\x71\x68\xcd\x63\x68"
+			  "\xf2\x71\x31\xfc",
+		.rlen	= 68,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x65\x23\xdb\x02\x50\xf9\x41\xee"
+			  "\x72\xad\x58\xba\x4e\x99\xdb\xe3"
+			  "\x32\xfb\x68\xa9\xb0\x48\xa9\x47"
+			  "\x67\xff\xce\x43\x68\xdd\x1d\x7d"
+			  "\x3e\xfa\x77\x62",
+		.klen	= 44,
+		.iv	= "\x68\x75\x0f\x0e\x1a\xdf\xea\x94"
+			  "\xe3\x55\xcb\x63\xb9\xbf\x50\x08",
+		.assoc	= "\x52\xcf\x92\x84\x3f\xe0\x0b\xde"
+			  "\xa1\x57\x40\x00\x1c\xa7\x63\xd2",
+		.alen	= 16,
+		.input	= "\x7f\x67\x42\xd6\xe6\x7a\xae\xf0"
+			  "\x41\x43\x53\x03\x1e\xb2\x64\x1b"
+			  "\xcd\xa2\x41\x12\xb1\x4f\x8f\x58"
+			  "\x90\x9a\xfa\xcf\xe0\xdb\x41\xe9"
+			  "\x87\x6b\x62\x9d\x86\xf4\xc6\xe9"
+			  "\x21\x48\x73\x91\x38\x98\x2f\x4a"
+			  "\x75\x1f\x98\xd5\x7e\xf8\x25\xd8"
+			  "\x5f\x02\xed\x62\x3c\x29\x54\x01"
+			  "\xe3\xb6\xef\xdd\x58\xb4\x8d\xb5"
+			  "\x93\x78\x4a\xbd\x59\xa8\xa3\xa2"
+			  "\xf2\x03\x5e\xba\xaf\xc9\x42\x5f"
+			  "\x2e\xab\x02\x3c\x87\xae\xe2\x14",
+		.ilen	= 96,
+		.result	= "\xbb\xc7\x05\xd2\x26\xf4\x35\x94"
+			  "\x53\xe5\x56\xd6\xf2\xc4\x83\xef"
+			  "\x20\x95\x90\x32\xd7\xd1\x3e\x89"
+			  "\xa7\x26\xc4\xfb\x3b\x89\x82\x69"
+			  "\x55\x4d\x2b\x2c\xdd\x1c\x0a\x26"
+			  "\x1e\x69\x0a\x5b\x44\xe9\xff\x9a"
+			  "\xa4\x7d\xcf\x88\xf5\xb2\xc6\x9c"
+			  "\x94\x07\x78\xc0\xce\x61\x73\xd3"
+			  "\xea\xbb\xc4\xd6\x89\x54\x13\x0e"
+			  "\x6a\x94\xf3\xa7\x47\x32\x67\x90"
+			  "\xf0\x2a\x1b\x0b\x0f\xaa\x28\x06"
+			  "\xf0\x7e\x09\x5d\x39\x2e\x31\x70"
+			  "\xca\xd5\xd6\x2d\xe5\xdc\x45\x7e"
+			  "\x6b\x5f\x10\x17",
+		.rlen	= 108,
+	}
+};
+
+static struct aead_testvec hmac_sha1_aes_cbc_dec_tv_template[] = {
+	{ /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x6a\xe5\x56\xfd\x1a\xca\xf1\x85"
+			  "\x4f\x16\xe7\x58\xb1\x26\x39\xe7"
+			  "\x55\x67\x40\xd5\x5e\xe5\x8a\x88"
+			  "\xc4\xcf\xe7\x74\x2c\xce\x78\xcc"
+			  "\x07\xda\xc5\xa6",
+		.klen	= 44,
+		.iv	= "\xc6\x52\x3e\x5d\x08\x19\xaf\x9e"
+			  "\xd1\x6c\xe5\x14\x57\x5a\x70\x8e",
+		.assoc	= "\xb0\x64\x25\x1a\x24\xe3\x5c\x88",
+		.alen	= 8,
+		.input	= "\xce\xd6\xf5\x7b\x03\x66\xe7\x92"
+			  "\x87\x59\xb7\xe8\x06\x6f\xbd\x3b"
+			  "\xf6\x22\xb8\x6d\xc5\x11\xdf\xe9"
+			  "\xdc\x8d\x54\x48\xa0\xaf\x8c\x83"
+			  "\x14\x4b\x64\x6b",
+		.ilen	= 36,
+		.result	= "\xdf\x39\xde\x44\x18\x5d\xc9\x32"
+			  "\x8d\xda\x26\x1e\xe3\x05\x0f\xa3",
+		.rlen	= 16,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x5d\x10\xfe\x7a\x4b\x64\x0d\x42"
+			  "\x13\x1e\x9c\x0a\xea\xc4\xa4\x71"
+			  "\xfd\xdc\x32\x4e\xa0\x1d\x87\xc2"
+			  "\xf3\xc3\xdb\x74\x4f\x49\x06\x77"
+			  "\xea\x45\xec\x3f",
+		.klen	= 44,
+		.iv	= "\x53\xaf\x92\xbc\x18\x36\x3b\xdb"
+			  "\xe2\x35\x4c\x64\xd8\x7d\xc1\x82",
+		.assoc	= "\x0c\xf4\xad\x3b\x90\xf1\x26\x57",
+		.alen	= 8,
+		.input	= "\xbb\x03\x29\xb2\x75\xde\xbb\x7c"
+			  "\x73\x22\xac\x24\x19\x48\xf0\x13"
+			  "\x97\x46\xca\xa0\x78\x47\xf8\x34"
+			  "\x92\xdd\x52\x27\x48\xae\x95\x58"
+			  "\x19\xbd\x20\x23\xe5\xa8\x04\x9c"
+			  "\x3a\x64\x65\xb2\xd8\x71\xd3\xa1"
+			  "\x10\xe9\x18\x1e\x07\x3a\xb0\x07"
+			  "\xf5\x77\x2a\xea\x83\xa6\x57\xd6"
+			  "\xc2\x00\x61\x33\xd9\xd3\x7f\x7d"
+			  "\x82\x94\x2e\x27\x3f\x91\x83\x69"
+			  "\x8e\x58\x7b\xf2",
+		.ilen	= 84,
+		.result	= "\x66\x8b\x30\x53\x4d\xfa\x50\x01"
+			  "\xf7\x88\xea\xa3\x5d\x73\x00\xf2"
+			  "\xaf\xc8\xf9\x53\xe7\x78\x20\x6a"
+			  "\xcc\xfc\x92\xf3\x53\x99\x5f\x24"
+			  "\x71\x45\x27\x32\xde\x8b\x3c\xfd"
+			  "\xab\xc2\x1d\x92\x38\x45\x32\x47"
+			  "\xc6\x07\x2f\x0c\x0e\x3f\xa9\x3b"
+			  "\x31\x40\x64\x63\xe2\x72\x4f\x5b",
+		.rlen	= 64,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x18" /* enc key length */
+			  "\xbe\x51\x7a\x8d\x3d\x68\xbe\xee"
+			  "\x40\x53\x14\x33\xf7\x7a\xf8\xf0"
+			  "\xad\x24\xeb\x59\xe6\xeb\xe4\x5f"
+			  "\x63\x80\x8c\xfb\x09\xa3\x69\xb8"
+			  "\x8e\x11\x9a\xdf\x0a\xb1\xe2\xc7"
+			  "\x05\xbd\xe0\xec",
+		.klen	= 52,
+		.iv	= "\xb4\x36\x7c\x15\xc0\x53\x9a\x59"
+			  "\xf3\xfa\xc8\x81\xc4\xf0\xae\xd4",
+		.assoc	= "\x1b\x9d\x15\xc7\x2f\x68\x58\xd6",
+		.alen	= 8,
+		.input	= "\xf3\xee\xfa\x5c\x57\xca\xc4\xcb"
+			  "\xd9\xa0\x45\x7e\x26\x6e\x02\x9b"
+			  "\x8e\xc4\x0d\xa7\x1b\x8a\x4b\x1f"
+			  "\x99\x8b\x93\x0c\xb1\x82\xf9\x63"
+			  "\x40\xad\x0d\xca\x4d\x82\xdb\xa6"
+			  "\x49\x1e\x55\xe1\xb1\x44\xce\x2f"
+			  "\x80\xf6\x0c\x14\x50\xac\xb1\x4c"
+			  "\xec\xf0\xa9\x16\x84\x09\x89\xcb"
+			  "\x54\x5b\x37\x1e\xd7\xba\x2c\x7b"
+			  "\x9a\xcd\xcd\x8b\x5f\x54\xf6\x68"
+			  "\x11\x6f\x9c\x2a\xf2\xbf\xfb\x3b"
+			  "\xe1\x96\x4b\x6b",
+		.ilen	= 92,
+		.result	= "\xe9\xa5\x97\xc3\x38\x7d\x2d\xe8"
+			  "\x58\x0a\x4c\x14\x79\x9d\x94\xaa"
+			  "\x3f\xc0\x46\xa5\x2e\xfb\x77\x66"
+			  "\xd6\x4e\x50\xc7\x54\xaf\xfa\x67"
+			  "\xf0\xe5\x64\x68\x5c\x6f\x5c\x4c"
+			  "\x35\x82\x16\xd9\x6f\x64\x00\x45"
+			  "\xb6\x07\x6b\xce\xb9\xba\x41\x43"
+			  "\x0a\xe6\x89\xe2\xd3\xba\xd5\x45"
+			  "\xb0\x7c\xf0\x2e\xa1\xeb\x14\x70"
+			  "\x64\x2f\x9c\x4c\xa0\xa2\x7a\xe7",
+		.rlen	= 80,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x20" /* enc key length */
+			  "\x4b\xeb\x54\x87\xe2\xbc\x97\xba"
+			  "\x32\xf0\x92\x13\xfb\x23\x8a\x30"
+			  "\x8c\xac\x9c\xff\xc4\xe2\xa9\xa4"
+			  "\xcb\xed\x44\xe6\x27\xf3\x99\x07"
+			  "\x5d\x91\x19\xf7\x7d\x23\x49\xe8"
+			  "\x37\xcc\x33\xc0\xf1\xae\xa3\x38"
+			  "\x5f\xae\x85\x2e",
+		.klen	= 60,
+		.iv	= "\xc2\xf8\x8d\x43\xad\x9d\xa2\xa4"
+			  "\x1a\x5b\xed\x25\xf0\x28\x07\x30",
+		.input	= "\x64\x67\x1d\xd6\x08\x7e\x2a\xc9"
+			  "\xbd\xe2\x93\xd2\x0f\xbf\xd1\x90"
+			  "\x95\xe4\x35\x5f\x6e\x24\xdf\x99"
+			  "\xa4\xcc\x1c\x45\xa6\x59\x6e\x87"
+			  "\x0b\x78\xe7\x35\xee\x28\x36\xd6"
+			  "\x2b\xd2\x51\xf1\x54\x95\x2a\x5d"
+			  "\x27\x21\xb8\x8e\x00\x6d\x6e\xb9"
+			  "\x41\x68\xda\x71\x68\xcd\x63\x68"
+			  "\xf2\x71\x31\xfc",
+		.ilen	= 68,
+		.result	= "\x50\x08\x8e\x95\x09\x55\xd3\x09"
+			  "\x40\xf8\xf6\x98\x08\x36\x8c\xaa"
+			  "\x3a\x8d\xd8\xa5\x3f\x10\x44\xa0"
+			  "\x00\x63\x3c\xed\xf8\xf9\x42\x1e"
+			  "\xe5\x6b\x24\x0c\x4b\xeb\xaf\x72"
+			  "\x99\x79\x2b\xcd\x6b\xf7\xeb\x48",
+		.rlen	= 48,
+	}, { /* Generated with OpenSSL */
+#ifdef __LITTLE_ENDIAN
+		.key	= "\x08\x00\x01\x00" /* rta length, rta type */
+#else
+		.key	= "\x00\x08\x00\x01" /* rta length, rta type */
+#endif
+			  "\x00\x00\x00\x10" /* enc key length */
+			  "\x65\x23\xdb\x02\x50\xf9\x41\xee"
+			  "\x72\xad\x58\xba\x4e\x99\xdb\xe3"
+			  "\x32\xfb\x68\xa9\xb0\x48\xa9\x47"
+			  "\x67\xff\xce\x43\x68\xdd\x1d\x7d"
+			  "\x3e\xfa\x77\x62",
+		.klen	= 44,
+		.iv	= "\x68\x75\x0f\x0e\x1a\xdf\xea\x94"
+			  "\xe3\x55\xcb\x63\xb9\xbf\x50\x08",
+		.assoc	= "\x52\xcf\x92\x84\x3f\xe0\x0b\xde"
+			  "\xa1\x57\x40\x00\x1c\xa7\x63\xd2",
+		.alen	= 16,
+		.input	= "\xbb\xc7\x05\xd2\x26\xf4\x35\x94"
+			  "\x53\xe5\x56\xd6\xf2\xc4\x83\xef"
+			  "\x20\x95\x90\x32\xd7\xd1\x3e\x89"
+			  "\xa7\x26\xc4\xfb\x3b\x89\x82\x69"
+			  "\x55\x4d\x2b\x2c\xdd\x1c\x0a\x26"
+			  "\x1e\x69\x0a\x5b\x44\xe9\xff\x9a"
+			  "\xa4\x7d\xcf\x88\xf5\xb2\xc6\x9c"
+			  "\x94\x07\x78\xc0\xce\x61\x73\xd3"
+			  "\xea\xbb\xc4\xd6\x89\x54\x13\x0e"
+			  "\x6a\x94\xf3\xa7\x47\x32\x67\x90"
+			  "\xf0\x2a\x1b\x0b\x0f\xaa\x28\x06"
+			  "\xf0\x7e\x09\x5d\x39\x2e\x31\x70"
+			  "\xca\xd5\xd6\x2d\xe5\xdc\x45\x7e"
+			  "\x6b\x5f\x10\x17",
+		.ilen	= 108,
+		.result	= "\x7f\x67\x42\xd6\xe6\x7a\xae\xf0"
+			  "\x41\x43\x53\x03\x1e\xb2\x64\x1b"
+			  "\xcd\xa2\x41\x12\xb1\x4f\x8f\x58"
+			  "\x90\x9a\xfa\xcf\xe0\xdb\x41\xe9"
+			  "\x87\x6b\x62\x9d\x86\xf4\xc6\xe9"
+			  "\x21\x48\x73\x91\x38\x98\x2f\x4a"
+			  "\x75\x1f\x98\xd5\x7e\xf8\x25\xd8"
+			  "\x5f\x02\xed\x62\x3c\x29\x54\x01"
+			  "\xe3\xb6\xef\xdd\x58\xb4\x8d\xb5"
+			  "\x93\x78\x4a\xbd\x59\xa8\xa3\xa2"
+			  "\xf2\x03\x5e\xba\xaf\xc9\x42\x5f"
+			  "\x2e\xab\x02\x3c\x87\xae\xe2\x14",
+		.rlen	= 96,
+	}
+};
+
 /*
  * ANSI X9.31 Continuous Pseudo-Random Number Generator (AES mode)
  * test vectors, taken from Appendix B.2.9 and B.2.10:
@@ -0,0 +1,270 @@
+/*
+ * drivers/base/power/async_test.c - Test ordering of async suspend/resume.
+ *
+ * Registers a few dummy platform devices which are all handled
+ * asynchronously by the PM core, and are related both as parent and
+ * child and through device_pm_add_dependency():
+ *
+ *	root ---- a ---- a1		c consumes a
+ *	     \--- b			d consumes b and c
+ *	c, d
+ *
+ * c and d are registered before their suppliers, so the PM core has to
+ * reorder them as well.  Every suspend and resume callback sleeps for
+ * delay_ms and records when it ran.  After a suspend/resume cycle, e.g.
+ *
+ *	echo devices > /sys/power/pm_test
+ *	echo mem > /sys/power/state
+ *
+ * the result attribute of the root device tells whether every device was
+ * suspended after its children and consumers and resumed after its parent
+ * and suppliers, and how many callbacks ran in parallel.
+ *
+ * This file is released under the GPLv2.
+ */
+
+#define pr_fmt(fmt) "pm_async_test: " fmt
+
+#include <linux/atomic.h>
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/platform_device.h>
+#include <linux/pm.h>
+#include <linux/suspend.h>
+
+#define DRV_NAME	"pm_async_test"
+
+static unsigned int delay_ms = 100;
+module_param(delay_ms, uint, 0644);
+MODULE_PARM_DESC(delay_ms, "Time each suspend and resume callback takes");
+
+enum { DEV_C, DEV_D, DEV_ROOT, DEV_A, DEV_A1, DEV_B, NR_DEVS };
+
+static const struct {
+	const char	*name;
+	int		parent;
+	int		suppliers[2];
+} test_devs[NR_DEVS] = {
+	[DEV_C]		= { "c",    -1,       { DEV_A, -1 } },
+	[DEV_D]		= { "d",    -1,       { DEV_B, DEV_C } },
+	[DEV_ROOT]	= { "root", -1,       { -1, -1 } },
+	[DEV_A]		= { "a",    DEV_ROOT, { -1, -1 } },
+	[DEV_A1]	= { "a1",   DEV_A,    { -1, -1 } },
+	[DEV_B]		= { "b",    DEV_ROOT, { -1, -1 } },
+};
+
+/* Sequence numbers of the start and end of the callbacks of a phase */
+struct phase {
+	int		start[NR_DEVS];
+	int		end[NR_DEVS];
+	int		max_running;
+	ktime_t		first;
+	ktime_t		last;
+};
+
+static struct platform_device *pdevs[NR_DEVS];
+static struct phase suspend_phase, resume_phase;
+static atomic_t seq, running;
+
+static void phase_begin(struct phase *p, int i)
+{
+	int now_running = atomic_inc_return(&running);
+
+	if (now_running > p->max_running)
+		p->max_running = now_running;
+	if (!p->first.tv64)
+		p->first = ktime_get();
+	p->start[i] = atomic_inc_return(&seq);
+}
+
+static void phase_end(struct phase *p, int i)
+{
+	p->end[i] = atomic_inc_return(&seq);
+	p->last = ktime_get();
+	atomic_dec(&running);
+}
+
+static int test_suspend(struct device *dev)
+{
+	int i = to_platform_device(dev)->id;
+
+	phase_begin(&suspend_phase, i);
+	msleep(delay_ms);
+	phase_end(&suspend_phase, i);
+	return 0;
+}
+
+static int test_resume(struct device *dev)
+{
+	int i = to_platform_device(dev)->id;
+
+	phase_begin(&resume_phase, i);
+	msleep(delay_ms);
+	phase_end(&resume_phase, i);
+	return 0;
+}
+
+/* Count the devices handled before something they depend on */
+static int check_order(struct phase *p, bool resume)
+{
+	int i, j, before, after, errors = 0;
+
+	for (i = 0; i < NR_DEVS; i++) {
+		int deps[3] = { test_devs[i].parent,
+				test_devs[i].suppliers[0],
+				test_devs[i].suppliers[1] };
+
+		for (j = 0; j < ARRAY_SIZE(deps); j++) {
+			if (deps[j] < 0)
+				continue;
+			/* resume: supplier then consumer, suspend reversed */
+			before = resume ? deps[j] : i;
+			after = resume ? i : deps[j];
+			if (p->start[after] < p->end[before]) {
+				pr_err("%s %s before %s was done\n",
+				       resume ? "resumed" : "suspended",
+				       test_devs[after].name,
+				       test_devs[before].name);
+				errors++;
+			}
+		}
+	}
+
+	return errors;
+}
+
+static ssize_t show_phase(char *buf, struct phase *p, bool resume)
+{
+	int errors = check_order(p, resume);
+
+	return sprintf(buf, "%s: %s, max %d in parallel, %lld ms\n",
+		       resume ? "resume" : "suspend",
+		       errors ? "ordering violated" : "ok", p->max_running,
+		       ktime_to_ms(ktime_sub(p->last, p->first)));
+}
+
+static ssize_t result_show(struct device *dev, struct device_attribute *attr,
+			   char *buf)
+{
+	ssize_t n;
+
+	if (!resume_phase.end[DEV_ROOT])
+		return sprintf(buf, "no suspend/resume cycle yet\n");
+
+	n = show_phase(buf, &suspend_phase, false);
+	n += show_phase(buf + n, &resume_phase, true);
+	return n;
+}
+static DEVICE_ATTR(result, 0444, result_show, NULL);
+
+/* Start over for every suspend/resume cycle */
+static int test_pm_notify(struct notifier_block *nb, unsigned long event,
+			  void *unused)
+{
+	if (event == PM_SUSPEND_PREPARE) {
+		memset(&suspend_phase, 0, sizeof(suspend_phase));
+		memset(&resume_phase, 0, sizeof(resume_phase));
+		atomic_set(&seq, 0);
+	}
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block test_pm_nb = {
+	.notifier_call = test_pm_notify,
+};
+
+static int __devinit test_probe(struct platform_device *pdev)
+{
+	device_enable_async_suspend(&pdev->dev);
+	return 0;
+}
+
+static const struct dev_pm_ops test_pm_ops = {
+	.suspend	= test_suspend,
+	.resume		= test_resume,
+};
+
+static struct platform_driver test_driver = {
+	.probe		= test_probe,
+	.driver		= {
+		.name	= DRV_NAME,
+		.owner	= THIS_MODULE,
+		.pm	= &test_pm_ops,
+	},
+};
+
+static void unregister_devs(void)
+{
+	int i;
+
+	for (i = NR_DEVS - 1; i >= 0; i--)
+		if (pdevs[i])
+			platform_device_unregister(pdevs[i]);
+}
+
+static int __init pm_async_test_init(void)
+{
+	int i, j, ret;
+
+	ret = platform_driver_register(&test_driver);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < NR_DEVS; i++) {
+		struct platform_device *pdev;
+
+		pdev = platform_device_alloc(DRV_NAME, i);
+		if (!pdev) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		if (test_devs[i].parent >= 0)
+			pdev->dev.parent = &pdevs[test_devs[i].parent]->dev;
+		ret = platform_device_add(pdev);
+		if (ret) {
+			platform_device_put(pdev);
+			goto err;
+		}
+		pdevs[i] = pdev;
+	}
+
+	for (i = 0; i < NR_DEVS; i++)
+		for (j = 0; j < ARRAY_SIZE(test_devs[i].suppliers); j++) {
+			int s = test_devs[i].suppliers[j];
+
+			if (s < 0)
+				continue;
+			ret = device_pm_add_dependency(&pdevs[i]->dev,
+						       &pdevs[s]->dev);
+			if (ret)
+				goto err;
+		}
+
+	ret = device_create_file(&pdevs[DEV_ROOT]->dev, &dev_attr_result);
+	if (ret)
+		goto err;
+
+	register_pm_notifier(&test_pm_nb);
+	return 0;
+
+ err:
+	unregister_devs();
+	platform_driver_unregister(&test_driver);
+	return ret;
+}
+module_init(pm_async_test_init);
+
+static void __exit pm_async_test_exit(void)
+{
+	unregister_pm_notifier(&test_pm_nb);
+	device_remove_file(&pdevs[DEV_ROOT]->dev, &dev_attr_result);
+	unregister_devs();
+	platform_driver_unregister(&test_driver);
+}
+module_exit(pm_async_test_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Test ordering of asynchronous suspend/resume");
@@ -29,6 +29,8 @@
 #include <linux/async.h>
 #include <linux/suspend.h>
 #include <linux/timer.h>
+#include <linux/slab.h>
+#include <trace/events/power.h>
 
 #include "../base.h"
 #include "power.h"
@@ -63,6 +65,29 @@ struct dpm_drv_wd_data {
 
 static int async_error;
 
+/*
+ * A dependency of a consumer device on a supplier device other than its
+ * parent, e.g. on the regulator it is powered from.  Like a child, the
+ * consumer is suspended before and resumed after the supplier, which
+ * lets both be handled asynchronously.  Protected by dpm_list_mtx.
+ */
+struct pm_dependency {
+	struct device		*supplier;
+	struct device		*consumer;
+	struct list_head	supplier_node;	/* in consumer's suppliers */
+	struct list_head	consumer_node;	/* in supplier's consumers */
+	unsigned int		count;
+};
+
+static void dpm_drop_dependency(struct pm_dependency *dep)
+{
+	list_del(&dep->supplier_node);
+	list_del(&dep->consumer_node);
+	put_device(dep->supplier);
+	put_device(dep->consumer);
+	kfree(dep);
+}
+
 /**
  * device_pm_init - Initialize the PM-related part of a device object.
  * @dev: Device object being initialized.
@@ -77,6 +102,8 @@ void device_pm_init(struct device *dev)
 	spin_lock_init(&dev->power.lock);
 	pm_runtime_init(dev);
 	INIT_LIST_HEAD(&dev->power.entry);
+	INIT_LIST_HEAD(&dev->power.suppliers);
+	INIT_LIST_HEAD(&dev->power.consumers);
 	dev->power.power_state = PMSG_INVALID;
 }
 
@@ -119,11 +146,17 @@ void device_pm_add(struct device *dev)
  */
 void device_pm_remove(struct device *dev)
 {
+	struct pm_dependency *dep, *n;
+
 	pr_debug("PM: Removing info for %s:%s\n",
 		 dev->bus ? dev->bus->name : "No Bus", dev_name(dev));
 	complete_all(&dev->power.completion);
 	mutex_lock(&dpm_list_mtx);
 	dev_pm_qos_constraints_destroy(dev);
+	list_for_each_entry_safe(dep, n, &dev->power.suppliers, supplier_node)
+		dpm_drop_dependency(dep);
+	list_for_each_entry_safe(dep, n, &dev->power.consumers, consumer_node)
+		dpm_drop_dependency(dep);
 	list_del_init(&dev->power.entry);
 	mutex_unlock(&dpm_list_mtx);
 	device_wakeup_disable(dev);
@@ -169,32 +202,117 @@ void device_pm_move_last(struct device *dev)
 	list_move_tail(&dev->power.entry, &dpm_list);
 }
 
-static ktime_t initcall_debug_start(struct device *dev)
+/*
+ * Whether target is dev itself or depends on it, as a descendant or a
+ * consumer (or a descendant of a consumer...) of dev.
+ */
+static int dpm_is_dependent(struct device *dev, void *target)
 {
-	ktime_t calltime = ktime_set(0, 0);
+	struct pm_dependency *dep;
 
-	if (initcall_debug) {
-		pr_info("calling  %s+ @ %i, parent: %s\n",
-			dev_name(dev), task_pid_nr(current),
-			dev->parent ? dev_name(dev->parent) : "none");
-		calltime = ktime_get();
-	}
+	if (dev == target)
+		return 1;
+
+	if (device_for_each_child(dev, target, dpm_is_dependent))
+		return 1;
 
-	return calltime;
+	list_for_each_entry(dep, &dev->power.consumers, consumer_node)
+		if (dpm_is_dependent(dep->consumer, target))
+			return 1;
+
+	return 0;
 }
 
-static void initcall_debug_report(struct device *dev, ktime_t calltime,
-				  int error)
+/*
+ * Move dev, its descendants and its consumers to the end of dpm_list, so
+ * that they come after a new supplier of dev.  Devices which are not on
+ * dpm_list or already prepared for a transition are left alone.
+ */
+static int dpm_reorder_to_tail(struct device *dev, void *not_used)
 {
-	ktime_t delta, rettime;
+	struct pm_dependency *dep;
 
-	if (initcall_debug) {
-		rettime = ktime_get();
-		delta = ktime_sub(rettime, calltime);
-		pr_info("call %s+ returned %d after %Ld usecs\n", dev_name(dev),
-			error, (unsigned long long)ktime_to_ns(delta) >> 10);
+	if (list_empty(&dev->power.entry) || dev->power.is_prepared)
+		return 0;
+
+	device_pm_move_last(dev);
+	device_for_each_child(dev, NULL, dpm_reorder_to_tail);
+	list_for_each_entry(dep, &dev->power.consumers, consumer_node)
+		dpm_reorder_to_tail(dep->consumer, NULL);
+
+	return 0;
+}
+
+/**
+ * device_pm_add_dependency - Make the PM core handle a device after another.
+ * @consumer: Device depending on @supplier.
+ * @supplier: Device @consumer depends on.
+ *
+ * Make the PM core suspend @consumer before and resume it after @supplier,
+ * like a child of @supplier, also if either is handled asynchronously.
+ * Dependencies are reference counted and dropped when either device is
+ * removed, or with device_pm_remove_dependency().
+ *
+ * Returns -EINVAL if @supplier already depends on @consumer.
+ */
+int device_pm_add_dependency(struct device *consumer, struct device *supplier)
+{
+	struct pm_dependency *dep;
+	int error = 0;
+
+	mutex_lock(&dpm_list_mtx);
+
+	if (dpm_is_dependent(consumer, supplier)) {
+		error = -EINVAL;
+		goto out;
+	}
+
+	list_for_each_entry(dep, &consumer->power.suppliers, supplier_node)
+		if (dep->supplier == supplier) {
+			dep->count++;
+			goto out;
+		}
+
+	dep = kzalloc(sizeof(*dep), GFP_KERNEL);
+	if (!dep) {
+		error = -ENOMEM;
+		goto out;
 	}
+
+	dep->supplier = get_device(supplier);
+	dep->consumer = get_device(consumer);
+	dep->count = 1;
+	list_add_tail(&dep->supplier_node, &consumer->power.suppliers);
+	list_add_tail(&dep->consumer_node, &supplier->power.consumers);
+
+	dpm_reorder_to_tail(consumer, NULL);
+
+ out:
+	mutex_unlock(&dpm_list_mtx);
+	return error;
+}
+EXPORT_SYMBOL_GPL(device_pm_add_dependency);
+
+/**
+ * device_pm_remove_dependency - Undo device_pm_add_dependency().
+ * @consumer: Device depending on @supplier.
+ * @supplier: Device @consumer depends on.
+ */
+void device_pm_remove_dependency(struct device *consumer,
+				 struct device *supplier)
+{
+	struct pm_dependency *dep;
+
+	mutex_lock(&dpm_list_mtx);
+	list_for_each_entry(dep, &consumer->power.suppliers, supplier_node)
+		if (dep->supplier == supplier) {
+			if (!--dep->count)
+				dpm_drop_dependency(dep);
+			break;
+		}
+	mutex_unlock(&dpm_list_mtx);
 }
+EXPORT_SYMBOL_GPL(device_pm_remove_dependency);
 
 /**
  * dpm_wait - Wait for a PM operation to complete.
@@ -210,6 +328,12 @@ static void dpm_wait(struct device *dev, bool async)
 		wait_for_completion(&dev->power.completion);
 }
 
+static bool dpm_must_wait(struct device *dev, bool async)
+{
+	return (async || (pm_async_enabled && dev->power.async_suspend)) &&
+		!completion_done(&dev->power.completion);
+}
+
 static int dpm_wait_fn(struct device *dev, void *async_ptr)
 {
 	dpm_wait(dev, *((bool *)async_ptr));
@@ -221,6 +345,55 @@ static void dpm_wait_for_children(struct device *dev, bool async)
        device_for_each_child(dev, &async, dpm_wait_fn);
 }
 
+/*
+ * Return the first supplier (consumer if !suppliers) of dev which is
+ * still in progress and would be waited for by dpm_wait().
+ */
+static struct device *dpm_first_pending(struct device *dev, bool async,
+					bool suppliers)
+{
+	struct pm_dependency *dep;
+	struct device *other;
+
+	if (suppliers) {
+		list_for_each_entry(dep, &dev->power.suppliers, supplier_node) {
+			other = dep->supplier;
+			if (dpm_must_wait(other, async))
+				return get_device(other);
+		}
+	} else {
+		list_for_each_entry(dep, &dev->power.consumers, consumer_node) {
+			other = dep->consumer;
+			if (dpm_must_wait(other, async))
+				return get_device(other);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Wait for the suppliers (on resume) or the consumers (on suspend) of a
+ * device.  dpm_list_mtx can't be held while waiting, so look for one
+ * device still in progress at a time, and rescan after waiting for it.
+ */
+static void dpm_wait_for_deps(struct device *dev, bool async, bool suppliers)
+{
+	struct device *other;
+
+	for (;;) {
+		mutex_lock(&dpm_list_mtx);
+		other = dpm_first_pending(dev, async, suppliers);
+		mutex_unlock(&dpm_list_mtx);
+
+		if (!other)
+			return;
+
+		wait_for_completion(&other->power.completion);
+		put_device(other);
+	}
+}
+
 /**
  * pm_op - Return the PM operation appropriate for given PM event.
  * @ops: PM operations to choose from.
@@ -376,6 +549,32 @@ static void dpm_show_time(ktime_t starttime, pm_message_t state, char *info)
 		usecs / USEC_PER_MSEC, usecs % USEC_PER_MSEC);
 }
 
+static ktime_t initcall_debug_start(struct device *dev)
+{
+	if (initcall_debug)
+		pr_info("calling  %s+ @ %i, parent: %s\n",
+			dev_name(dev), task_pid_nr(current),
+			dev->parent ? dev_name(dev->parent) : "none");
+
+	return ktime_get();
+}
+
+static void initcall_debug_report(struct device *dev, ktime_t calltime,
+				  int error, pm_message_t state, char *info)
+{
+	ktime_t delta, rettime;
+
+	rettime = ktime_get();
+	delta = ktime_sub(rettime, calltime);
+
+	if (initcall_debug)
+		pr_info("call %s+ returned %d after %Ld usecs\n", dev_name(dev),
+			error, (unsigned long long)ktime_to_ns(delta) >> 10);
+
+	trace_device_pm_report_time(dev, info, ktime_to_ns(delta),
+				    pm_verb(state.event), error);
+}
+
 static int dpm_run_callback(pm_callback_t cb, struct device *dev,
 			    pm_message_t state, char *info)
 {
@@ -391,7 +590,7 @@ static int dpm_run_callback(pm_callback_t cb, struct device *dev,
 	error = cb(dev);
 	suspend_report_result(cb, error);
 
-	initcall_debug_report(dev, calltime, error);
+	initcall_debug_report(dev, calltime, error, state, info);
 
 	return error;
 }
@@ -577,6 +776,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	TRACE_RESUME(0);
 
 	dpm_wait(dev->parent, async);
+	dpm_wait_for_deps(dev, async, true);
 	device_lock(dev);
 
 	/*
@@ -1040,7 +1240,7 @@ static int legacy_suspend(struct device *dev, pm_message_t state,
 	error = cb(dev, state);
 	suspend_report_result(cb, error);
 
-	initcall_debug_report(dev, calltime, error);
+	initcall_debug_report(dev, calltime, error, state, "legacy ");
 
 	return error;
 }
@@ -1060,6 +1260,7 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	struct dpm_drv_wd_data data;
 
 	dpm_wait_for_children(dev, async);
+	dpm_wait_for_deps(dev, async, false);
 
 	if (async_error)
 		goto Complete;
@@ -19,6 +19,8 @@
 #include <linux/fs.h>
 #include <linux/anon_inodes.h>
 #include <linux/ion.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/memblock.h>
 #include <linux/miscdevice.h>
@@ -26,31 +28,59 @@
 #include <linux/mm.h>
 #include <linux/mm_types.h>
 #include <linux/rbtree.h>
+#include <linux/rwsem.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
 #include <linux/debugfs.h>
 #include <linux/dma-buf.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
 
 #include "ion_priv.h"
 
+/* allocation latency buckets: <1us, 1-2us, 2-4us, ... , >=16ms */
+#define ION_ALLOC_LATENCY_BUCKETS	16
+
 /**
  * struct ion_device - the metadata of the ion device node
  * @dev:		the actual misc device
- * @buffers:	an rb tree of all the existing buffers
- * @lock:		lock protecting the buffers & heaps trees
- * @heaps:		list of all the heaps in the system
- * @user_clients:	list of all the clients created from userspace
+ * @buffers:		an rb tree of all the existing buffers
+ * @buffer_lock:	lock protecting the buffers tree and the buffers'
+ *			handle_count, task_comm and pid
+ * @heaps:		an rb tree of all the heaps in the system
+ * @heap_lock:		rwsem protecting the heaps tree, held for read
+ *			while allocating
+ * @clients:		an rb tree of all the clients in the system
+ * @client_lock:	lock protecting the clients tree
+ * @free_list:		buffers whose last reference is gone, waiting for
+ *			the free thread to give their memory back
+ * @free_list_size:	total size of the buffers on @free_list
+ * @free_lock:		lock protecting @free_list and @free_list_size
+ * @free_wait:		wait queue the free thread sleeps on
+ * @free_task:		thread draining @free_list
+ * @free_shrinker:	drains @free_list under memory pressure, the free
+ *			thread only runs when the CPU is otherwise idle
+ * @alloc_latency:	histogram of ion_alloc latencies
  */
 struct ion_device {
 	struct miscdevice dev;
 	struct rb_root buffers;
-	struct mutex lock;
+	struct mutex buffer_lock;
 	struct rb_root heaps;
+	struct rw_semaphore heap_lock;
 	long (*custom_ioctl) (struct ion_client *client, unsigned int cmd,
 			      unsigned long arg);
 	struct rb_root clients;
+	struct mutex client_lock;
+	struct list_head free_list;
+	size_t free_list_size;
+	spinlock_t free_lock;
+	wait_queue_head_t free_wait;
+	struct task_struct *free_task;
+	struct shrinker free_shrinker;
+	atomic_t alloc_latency[ION_ALLOC_LATENCY_BUCKETS];
 	struct dentry *debug_root;
 	struct dentry *debug_detailed;
 };
@@ -108,7 +138,7 @@ bool ion_buffer_fault_user_mappings(struct ion_buffer *buffer)
                 !(buffer->flags & ION_FLAG_CACHED_NEEDS_SYNC));
 }
 
-/* this function should only be called while dev->lock is held */
+/* this function should only be called while dev->buffer_lock is held */
 static void ion_buffer_add(struct ion_device *dev,
 			   struct ion_buffer *buffer)
 {
@@ -136,7 +166,6 @@ static void ion_buffer_add(struct ion_device *dev,
 
 static int ion_buffer_alloc_dirty(struct ion_buffer *buffer);
 
-/* this function should only be called while dev->lock is held */
 static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 				     struct ion_device *dev,
 				     unsigned long len,
@@ -202,7 +231,9 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 	   cached mapping that mapping has been invalidated */
 	for_each_sg(buffer->sg_table->sgl, sg, buffer->sg_table->nents, i)
 		sg_dma_address(sg) = sg_phys(sg);
+	mutex_lock(&dev->buffer_lock);
 	ion_buffer_add(dev, buffer);
+	mutex_unlock(&dev->buffer_lock);
 	return buffer;
 
 err:
@@ -212,23 +243,122 @@ err:
 	return ERR_PTR(ret);
 }
 
-static void ion_buffer_destroy(struct kref *kref)
+static void ion_buffer_destroy(struct ion_buffer *buffer)
 {
-	struct ion_buffer *buffer = container_of(kref, struct ion_buffer, ref);
 	struct ion_device *dev = buffer->dev;
 
 	if (WARN_ON(buffer->kmap_cnt > 0))
 		buffer->heap->ops->unmap_kernel(buffer->heap, buffer);
 	buffer->heap->ops->unmap_dma(buffer->heap, buffer);
 	buffer->heap->ops->free(buffer);
-	mutex_lock(&dev->lock);
+	mutex_lock(&dev->buffer_lock);
 	rb_erase(&buffer->node, &dev->buffers);
-	mutex_unlock(&dev->lock);
+	mutex_unlock(&dev->buffer_lock);
 	if (buffer->flags & ION_FLAG_CACHED)
 		kfree(buffer->dirty);
 	kfree(buffer);
 }
 
+/*
+ * Dropping the last reference only queues the buffer, the free thread
+ * returns the memory to the heap so that a large free never stalls the
+ * caller or, through the locks above, other clients.  The free thread is
+ * SCHED_IDLE, so under memory pressure the free_shrinker drains the list.
+ */
+static void ion_buffer_release(struct kref *kref)
+{
+	struct ion_buffer *buffer = container_of(kref, struct ion_buffer, ref);
+	struct ion_device *dev = buffer->dev;
+
+	spin_lock(&dev->free_lock);
+	list_add_tail(&buffer->free_list, &dev->free_list);
+	dev->free_list_size += buffer->size;
+	spin_unlock(&dev->free_lock);
+	wake_up(&dev->free_wait);
+}
+
+/*
+ * Destroy queued buffers until at least @size bytes are freed, or all of
+ * them if @size is 0.  Returns the number of bytes freed.
+ */
+static size_t ion_device_drain_free_list(struct ion_device *dev, size_t size)
+{
+	struct ion_buffer *buffer;
+	size_t freed = 0;
+
+	spin_lock(&dev->free_lock);
+	while (!list_empty(&dev->free_list) && (!size || freed < size)) {
+		buffer = list_first_entry(&dev->free_list, struct ion_buffer,
+					  free_list);
+		list_del(&buffer->free_list);
+		dev->free_list_size -= buffer->size;
+		spin_unlock(&dev->free_lock);
+
+		freed += buffer->size;
+		ion_buffer_destroy(buffer);
+
+		spin_lock(&dev->free_lock);
+	}
+	spin_unlock(&dev->free_lock);
+
+	return freed;
+}
+
+/* Buffers released but not yet given back by the free thread. */
+static bool ion_buffer_deferred(struct ion_buffer *buffer)
+{
+	return !atomic_read(&buffer->ref.refcount);
+}
+
+static bool ion_device_free_list_empty(struct ion_device *dev)
+{
+	bool empty;
+
+	spin_lock(&dev->free_lock);
+	empty = list_empty(&dev->free_list);
+	spin_unlock(&dev->free_lock);
+
+	return empty;
+}
+
+static int ion_free_thread(void *data)
+{
+	struct ion_device *dev = data;
+	struct sched_param param = { .sched_priority = 0 };
+
+	sched_setscheduler(current, SCHED_IDLE, &param);
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(dev->free_wait,
+				!ion_device_free_list_empty(dev) ||
+				kthread_should_stop());
+		ion_device_drain_free_list(dev, 0);
+	}
+
+	return 0;
+}
+
+static int ion_device_free_shrink(struct shrinker *shrinker,
+				  struct shrink_control *sc)
+{
+	struct ion_device *dev = container_of(shrinker, struct ion_device,
+					      free_shrinker);
+	size_t size;
+
+	if (sc->nr_to_scan) {
+		if (!(sc->gfp_mask & __GFP_WAIT))
+			return -1;
+		ion_device_drain_free_list(dev,
+				(size_t)sc->nr_to_scan << PAGE_SHIFT);
+	}
+
+	spin_lock(&dev->free_lock);
+	size = dev->free_list_size;
+	spin_unlock(&dev->free_lock);
+
+	return size >> PAGE_SHIFT;
+}
+
 static void ion_buffer_get(struct ion_buffer *buffer)
 {
 	kref_get(&buffer->ref);
@@ -236,14 +366,14 @@ static void ion_buffer_get(struct ion_buffer *buffer)
 
 static int ion_buffer_put(struct ion_buffer *buffer)
 {
-	return kref_put(&buffer->ref, ion_buffer_destroy);
+	return kref_put(&buffer->ref, ion_buffer_release);
 }
 
 static void ion_buffer_add_to_handle(struct ion_buffer *buffer)
 {
-	mutex_lock(&buffer->dev->lock);
+	mutex_lock(&buffer->dev->buffer_lock);
 	buffer->handle_count++;
-	mutex_unlock(&buffer->dev->lock);
+	mutex_unlock(&buffer->dev->buffer_lock);
 }
 
 static void ion_buffer_remove_from_handle(struct ion_buffer *buffer)
@@ -257,7 +387,7 @@ static void ion_buffer_remove_from_handle(struct ion_buffer *buffer)
 	 * The taskcomm and pid can provide a debug hint as to where this fd
 	 * is in the system
 	 */
-	mutex_lock(&buffer->dev->lock);
+	mutex_lock(&buffer->dev->buffer_lock);
 	buffer->handle_count--;
 	BUG_ON(buffer->handle_count < 0);
 	if (!buffer->handle_count) {
@@ -267,7 +397,7 @@ static void ion_buffer_remove_from_handle(struct ion_buffer *buffer)
 		get_task_comm(buffer->task_comm, task);
 		buffer->pid = task_pid_nr(task);
 	}
-	mutex_unlock(&buffer->dev->lock);
+	mutex_unlock(&buffer->dev->buffer_lock);
 }
 
 static struct ion_handle *ion_handle_create(struct ion_client *client,
@@ -378,6 +508,16 @@ static void ion_handle_add(struct ion_client *client, struct ion_handle *handle)
 	rb_insert_color(&handle->node, &client->handles);
 }
 
+static void ion_alloc_latency_add(struct ion_device *dev, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket = 0;
+
+	if (us > 0)
+		bucket = min_t(int, fls64(us), ION_ALLOC_LATENCY_BUCKETS - 1);
+	atomic_inc(&dev->alloc_latency[bucket]);
+}
+
 struct ion_handle *ion_alloc(struct ion_client *client, size_t len,
 			     size_t align, unsigned int heap_mask,
 			     unsigned int flags)
@@ -385,7 +525,9 @@ struct ion_handle *ion_alloc(struct ion_client *client, size_t len,
 	struct rb_node *n;
 	struct ion_handle *handle;
 	struct ion_device *dev = client->dev;
-	struct ion_buffer *buffer = NULL;
+	struct ion_buffer *buffer;
+	bool drained = false;
+	ktime_t start;
 
 	pr_debug("%s: len %d align %d heap_mask %u flags %x\n", __func__, len,
 		 align, heap_mask, flags);
@@ -399,8 +541,11 @@ struct ion_handle *ion_alloc(struct ion_client *client, size_t len,
 		return ERR_PTR(-EINVAL);
 
 	len = PAGE_ALIGN(len);
+	start = ktime_get();
 
-	mutex_lock(&dev->lock);
+retry:
+	buffer = NULL;
+	down_read(&dev->heap_lock);
 	for (n = rb_first(&dev->heaps); n != NULL; n = rb_next(n)) {
 		struct ion_heap *heap = rb_entry(n, struct ion_heap, node);
 		/* if the client doesn't support this heap type */
@@ -413,7 +558,17 @@ struct ion_handle *ion_alloc(struct ion_client *client, size_t len,
 		if (!IS_ERR_OR_NULL(buffer))
 			break;
 	}
-	mutex_unlock(&dev->lock);
+	up_read(&dev->heap_lock);
+
+	/*
+	 * the memory we need may still be sitting on the free list, give it
+	 * back synchronously and try once more before failing
+	 */
+	if (IS_ERR_OR_NULL(buffer) && !drained) {
+		drained = true;
+		if (ion_device_drain_free_list(dev, 0))
+			goto retry;
+	}
 
 	if (buffer == NULL)
 		return ERR_PTR(-ENODEV);
@@ -421,6 +576,8 @@ struct ion_handle *ion_alloc(struct ion_client *client, size_t len,
 	if (IS_ERR(buffer))
 		return ERR_PTR(PTR_ERR(buffer));
 
+	ion_alloc_latency_add(dev, start);
+
 	handle = ion_handle_create(client, buffer);
 
 	/*
@@ -693,7 +850,7 @@ struct ion_client *ion_client_create(struct ion_device *dev,
 	client->task = task;
 	client->pid = pid;
 
-	mutex_lock(&dev->lock);
+	mutex_lock(&dev->client_lock);
 	p = &dev->clients.rb_node;
 	while (*p) {
 		parent = *p;
@@ -718,7 +875,7 @@ struct ion_client *ion_client_create(struct ion_device *dev,
 				    client,
 				    &debug_detailed_client_fops);
 
-	mutex_unlock(&dev->lock);
+	mutex_unlock(&dev->client_lock);
 
 	return client;
 }
@@ -734,13 +891,13 @@ void ion_client_destroy(struct ion_client *client)
 						     node);
 		ion_handle_destroy(&handle->ref);
 	}
-	mutex_lock(&dev->lock);
+	mutex_lock(&dev->client_lock);
 	if (client->task)
 		put_task_struct(client->task);
 	rb_erase(&client->node, &dev->clients);
 	debugfs_remove_recursive(client->debug_root);
 	debugfs_remove_recursive(client->debug_detailed);
-	mutex_unlock(&dev->lock);
+	mutex_unlock(&dev->client_lock);
 
 	kfree(client);
 }
@@ -1235,10 +1392,12 @@ static int ion_debug_heap_show(struct seq_file *s, void *unused)
 	struct rb_node *n;
 	size_t total_size = 0;
 	size_t total_orphaned_size = 0;
+	size_t deferred_size;
 
 	seq_printf(s, "%16.s %16.s %16.s\n", "client", "pid", "size");
 	seq_printf(s, "----------------------------------------------------\n");
 
+	mutex_lock(&dev->client_lock);
 	for (n = rb_first(&dev->clients); n; n = rb_next(n)) {
 		struct ion_client *client = rb_entry(n, struct ion_client,
 						     node);
@@ -1256,26 +1415,36 @@ static int ion_debug_heap_show(struct seq_file *s, void *unused)
 				   client->pid, size);
 		}
 	}
+	mutex_unlock(&dev->client_lock);
 	seq_printf(s, "----------------------------------------------------\n");
 	seq_printf(s, "orphaned allocations (info is from last known client):"
 		   "\n");
-	mutex_lock(&dev->lock);
+	mutex_lock(&dev->buffer_lock);
 	for (n = rb_first(&dev->buffers); n; n = rb_next(n)) {
 		struct ion_buffer *buffer = rb_entry(n, struct ion_buffer,
 						     node);
 		if (buffer->heap->type == heap->type)
 			total_size += buffer->size;
-		if (!buffer->handle_count) {
+		if (!buffer->handle_count && !ion_buffer_deferred(buffer)) {
 			seq_printf(s, "%16.s %16u %16u\n", buffer->task_comm,
 				   buffer->pid, buffer->size);
 			total_orphaned_size += buffer->size;
 		}
 	}
-	mutex_unlock(&dev->lock);
+	mutex_unlock(&dev->buffer_lock);
+	spin_lock(&dev->free_lock);
+	deferred_size = dev->free_list_size;
+	spin_unlock(&dev->free_lock);
 	seq_printf(s, "----------------------------------------------------\n");
 	seq_printf(s, "%16.s %16u\n", "total orphaned",
 		   total_orphaned_size);
 	seq_printf(s, "%16.s %16u\n", "total ", total_size);
+	seq_printf(s, "%16.s %16u\n", "deferred free", deferred_size);
+
+	if (heap->debug_show) {
+		seq_printf(s, "----------------------------------------------------\n");
+		heap->debug_show(heap, s, unused);
+	}
 
 	return 0;
 }
@@ -1316,11 +1485,13 @@ static int ion_debug_detailed_heap_show(struct seq_file *s, void *unused)
 	struct rb_node *n;
 
 	seq_printf(s, "%16.s %16.s\n", "buffer size", "refcount");
+	mutex_lock(&dev->client_lock);
 	for (n = rb_first(&dev->clients); n; n = rb_next(n)) {
 		struct ion_client *client = rb_entry(n, struct ion_client,
 						     node);
 		ion_debug_detailed_show(client, heap, s);
 	}
+	mutex_unlock(&dev->client_lock);
 
 	return 0;
 }
@@ -1338,6 +1509,42 @@ static const struct file_operations debug_detailed_heap_fops = {
 	.release = single_release,
 };
 
+static int ion_debug_alloc_latency_show(struct seq_file *s, void *unused)
+{
+	struct ion_device *dev = s->private;
+	int i;
+
+	seq_printf(s, "%16.s %16.s\n", "usecs", "count");
+	for (i = 0; i < ION_ALLOC_LATENCY_BUCKETS; i++) {
+		char range[32];
+
+		if (!i)
+			snprintf(range, sizeof(range), "< 1");
+		else if (i == ION_ALLOC_LATENCY_BUCKETS - 1)
+			snprintf(range, sizeof(range), ">= %u", 1U << (i - 1));
+		else
+			snprintf(range, sizeof(range), "%u - %u",
+				 1U << (i - 1), 1U << i);
+		seq_printf(s, "%16s %16d\n", range,
+			   atomic_read(&dev->alloc_latency[i]));
+	}
+
+	return 0;
+}
+
+static int ion_debug_alloc_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ion_debug_alloc_latency_show,
+			   inode->i_private);
+}
+
+static const struct file_operations debug_alloc_latency_fops = {
+	.open = ion_debug_alloc_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 {
 	struct rb_node **p = &dev->heaps.rb_node;
@@ -1350,7 +1557,7 @@ void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 		       __func__);
 
 	heap->dev = dev;
-	mutex_lock(&dev->lock);
+	down_write(&dev->heap_lock);
 	while (*p) {
 		parent = *p;
 		entry = rb_entry(parent, struct ion_heap, node);
@@ -1374,7 +1581,7 @@ void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 	debugfs_create_file(heap->name, 0664, dev->debug_detailed, heap,
 			    &debug_detailed_heap_fops);
 end:
-	mutex_unlock(&dev->lock);
+	up_write(&dev->heap_lock);
 }
 
 struct ion_device *ion_device_create(long (*custom_ioctl)
@@ -1407,16 +1614,42 @@ struct ion_device *ion_device_create(long (*custom_ioctl)
 	if (IS_ERR_OR_NULL(idev->debug_detailed))
 		pr_err("ion: failed to create detailed debug files.\n");
 
+	debugfs_create_file("alloc_latency", 0444, idev->debug_root, idev,
+			    &debug_alloc_latency_fops);
+
 	idev->custom_ioctl = custom_ioctl;
 	idev->buffers = RB_ROOT;
-	mutex_init(&idev->lock);
+	mutex_init(&idev->buffer_lock);
 	idev->heaps = RB_ROOT;
+	init_rwsem(&idev->heap_lock);
 	idev->clients = RB_ROOT;
+	mutex_init(&idev->client_lock);
+	INIT_LIST_HEAD(&idev->free_list);
+	spin_lock_init(&idev->free_lock);
+	init_waitqueue_head(&idev->free_wait);
+
+	idev->free_task = kthread_run(ion_free_thread, idev, "ion_free");
+	if (IS_ERR(idev->free_task)) {
+		pr_err("ion: failed to start the free thread.\n");
+		debugfs_remove_recursive(idev->debug_root);
+		misc_deregister(&idev->dev);
+		ret = PTR_ERR(idev->free_task);
+		kfree(idev);
+		return ERR_PTR(ret);
+	}
+
+	idev->free_shrinker.shrink = ion_device_free_shrink;
+	idev->free_shrinker.seeks = DEFAULT_SEEKS;
+	register_shrinker(&idev->free_shrinker);
+
 	return idev;
 }
 
 void ion_device_destroy(struct ion_device *dev)
 {
+	unregister_shrinker(&dev->free_shrinker);
+	kthread_stop(dev->free_task);
+	ion_device_drain_free_list(dev, 0);
 	misc_deregister(&dev->dev);
 	/* XXX need to free the heaps and clients ? */
 	kfree(dev);
@@ -0,0 +1,276 @@
+/*
+ * drivers/gpu/ion/ion_page_pool.c
+ *
+ * Copyright (C) 2011 Google, Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/err.h>
+#include <linux/highmem.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include "ion_priv.h"
+
+/*
+ * All pools share one low priority thread that zeroes freed pages and
+ * one shrinker that hands pooled pages back to the page allocator.
+ */
+static LIST_HEAD(ion_page_pools);
+static DEFINE_MUTEX(ion_page_pools_lock);
+static DECLARE_WAIT_QUEUE_HEAD(ion_page_pool_zero_wait);
+static atomic_t ion_page_pool_dirty_pages = ATOMIC_INIT(0);
+static struct task_struct *ion_page_pool_zero_task;
+
+static void ion_page_pool_zero(struct ion_page_pool *pool, struct page *page)
+{
+	ktime_t start = ktime_get();
+	int i;
+
+	for (i = 0; i < (1 << pool->order); i++)
+		clear_highpage(page + i);
+
+	spin_lock(&pool->lock);
+	pool->zeroed += 1 << pool->order;
+	pool->zero_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+	spin_unlock(&pool->lock);
+}
+
+static struct page *ion_page_pool_remove(struct ion_page_pool *pool,
+					 struct list_head *list, int *count)
+{
+	struct page *page;
+
+	page = list_first_entry(list, struct page, lru);
+	list_del(&page->lru);
+	(*count)--;
+	return page;
+}
+
+/* Zero one dirty page of @pool, returns false if there was none. */
+static bool ion_page_pool_zero_one(struct ion_page_pool *pool)
+{
+	struct page *page;
+
+	spin_lock(&pool->lock);
+	if (!pool->dirty_count) {
+		spin_unlock(&pool->lock);
+		return false;
+	}
+	page = ion_page_pool_remove(pool, &pool->dirty, &pool->dirty_count);
+	spin_unlock(&pool->lock);
+	atomic_dec(&ion_page_pool_dirty_pages);
+
+	ion_page_pool_zero(pool, page);
+
+	spin_lock(&pool->lock);
+	list_add_tail(&page->lru, &pool->items);
+	pool->count++;
+	spin_unlock(&pool->lock);
+
+	return true;
+}
+
+static int ion_page_pool_zero_thread(void *data)
+{
+	struct ion_page_pool *pool;
+	bool again;
+
+	set_user_nice(current, 19);
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(ion_page_pool_zero_wait,
+				atomic_read(&ion_page_pool_dirty_pages) ||
+				kthread_should_stop());
+
+		do {
+			again = false;
+			mutex_lock(&ion_page_pools_lock);
+			list_for_each_entry(pool, &ion_page_pools, list)
+				again |= ion_page_pool_zero_one(pool);
+			mutex_unlock(&ion_page_pools_lock);
+			cond_resched();
+		} while (again && !kthread_should_stop());
+	}
+
+	return 0;
+}
+
+struct page *ion_page_pool_alloc(struct ion_page_pool *pool)
+{
+	struct page *page = NULL;
+	bool dirty = false;
+
+	spin_lock(&pool->lock);
+	if (pool->count) {
+		page = ion_page_pool_remove(pool, &pool->items, &pool->count);
+		pool->hits++;
+	} else if (pool->dirty_count) {
+		page = ion_page_pool_remove(pool, &pool->dirty,
+					    &pool->dirty_count);
+		pool->sync_zeroed++;
+		dirty = true;
+	} else {
+		pool->misses++;
+	}
+	spin_unlock(&pool->lock);
+
+	if (dirty) {
+		atomic_dec(&ion_page_pool_dirty_pages);
+		ion_page_pool_zero(pool, page);
+	} else if (!page) {
+		page = alloc_pages(pool->gfp_mask | __GFP_ZERO, pool->order);
+	}
+
+	return page;
+}
+
+void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
+{
+	spin_lock(&pool->lock);
+	list_add_tail(&page->lru, &pool->dirty);
+	pool->dirty_count++;
+	spin_unlock(&pool->lock);
+
+	atomic_inc(&ion_page_pool_dirty_pages);
+	wake_up(&ion_page_pool_zero_wait);
+}
+
+/* Free up to @nr_to_scan pages, dirty ones first, and return the rest. */
+static int ion_page_pool_shrink(struct shrinker *shrinker,
+				struct shrink_control *sc)
+{
+	struct ion_page_pool *pool;
+	int nr_to_scan = sc->nr_to_scan;
+	int total = 0;
+
+	if (nr_to_scan && !(sc->gfp_mask & __GFP_WAIT))
+		return -1;
+
+	if (!mutex_trylock(&ion_page_pools_lock))
+		return nr_to_scan ? -1 : 0;
+
+	list_for_each_entry(pool, &ion_page_pools, list) {
+		spin_lock(&pool->lock);
+		while (nr_to_scan > 0 && (pool->dirty_count || pool->count)) {
+			struct page *page;
+
+			if (pool->dirty_count) {
+				page = ion_page_pool_remove(pool, &pool->dirty,
+							&pool->dirty_count);
+				atomic_dec(&ion_page_pool_dirty_pages);
+			} else {
+				page = ion_page_pool_remove(pool, &pool->items,
+							    &pool->count);
+			}
+			__free_pages(page, pool->order);
+			pool->shrunk += 1 << pool->order;
+			nr_to_scan -= 1 << pool->order;
+		}
+		total += (pool->count + pool->dirty_count) << pool->order;
+		spin_unlock(&pool->lock);
+	}
+
+	mutex_unlock(&ion_page_pools_lock);
+
+	return total;
+}
+
+static struct shrinker ion_page_pool_shrinker = {
+	.shrink = ion_page_pool_shrink,
+	.seeks = DEFAULT_SEEKS,
+};
+
+struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
+{
+	struct ion_page_pool *pool;
+
+	pool = kzalloc(sizeof(struct ion_page_pool), GFP_KERNEL);
+	if (!pool)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&pool->items);
+	INIT_LIST_HEAD(&pool->dirty);
+	spin_lock_init(&pool->lock);
+	pool->gfp_mask = gfp_mask;
+	pool->order = order;
+
+	mutex_lock(&ion_page_pools_lock);
+	if (!ion_page_pool_zero_task) {
+		struct task_struct *task;
+
+		task = kthread_run(ion_page_pool_zero_thread, NULL, "ion_zero");
+		if (IS_ERR(task)) {
+			mutex_unlock(&ion_page_pools_lock);
+			kfree(pool);
+			return ERR_CAST(task);
+		}
+		ion_page_pool_zero_task = task;
+		register_shrinker(&ion_page_pool_shrinker);
+	}
+	list_add_tail(&pool->list, &ion_page_pools);
+	mutex_unlock(&ion_page_pools_lock);
+
+	return pool;
+}
+
+void ion_page_pool_destroy(struct ion_page_pool *pool)
+{
+	struct page *page, *tmp;
+
+	mutex_lock(&ion_page_pools_lock);
+	list_del(&pool->list);
+	mutex_unlock(&ion_page_pools_lock);
+
+	list_for_each_entry_safe(page, tmp, &pool->dirty, lru) {
+		list_del(&page->lru);
+		atomic_dec(&ion_page_pool_dirty_pages);
+		__free_pages(page, pool->order);
+	}
+	list_for_each_entry_safe(page, tmp, &pool->items, lru) {
+		list_del(&page->lru);
+		__free_pages(page, pool->order);
+	}
+	kfree(pool);
+}
+
+void ion_page_pool_debug_show(struct ion_page_pool *pool, struct seq_file *s)
+{
+	unsigned long hits, sync_zeroed, misses, zeroed, shrunk;
+	int count, dirty_count;
+	u64 zero_ns;
+
+	spin_lock(&pool->lock);
+	count = pool->count;
+	dirty_count = pool->dirty_count;
+	hits = pool->hits;
+	sync_zeroed = pool->sync_zeroed;
+	misses = pool->misses;
+	zeroed = pool->zeroed;
+	shrunk = pool->shrunk;
+	zero_ns = pool->zero_ns;
+	spin_unlock(&pool->lock);
+
+	if (zeroed)
+		do_div(zero_ns, zeroed);
+
+	seq_printf(s, "%5u %8d %8d %10lu %10lu %10lu %10lu %10lu %8llu\n",
+		   pool->order, count, dirty_count, hits, sync_zeroed, misses,
+		   zeroed, shrunk, zero_ns);
+}
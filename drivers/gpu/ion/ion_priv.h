@@ -22,8 +22,13 @@
 #include <linux/mutex.h>
 #include <linux/rbtree.h>
 #include <linux/sched.h>
+#include <linux/shrinker.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
 #include <linux/ion.h>
 
+struct seq_file;
+
 struct ion_buffer *ion_handle_buffer(struct ion_handle *handle);
 
 /**
@@ -52,6 +57,8 @@ struct ion_buffer *ion_handle_buffer(struct ion_handle *handle);
  *			handle, used for debugging
  * @pid:		pid of last client to reference this buffer in a
  *			handle, used for debugging
+ * @free_list:		entry in the device's deferred free list once the
+ *			last reference has been dropped
 */
 struct ion_buffer {
 	struct kref ref;
@@ -75,6 +82,7 @@ struct ion_buffer {
 	int handle_count;
 	char task_comm[TASK_COMM_LEN];
 	pid_t pid;
+	struct list_head free_list;
 };
 
 /**
@@ -116,6 +124,8 @@ struct ion_heap_ops {
  *			MUST be unique
  * @name:		used for debugging
  * @priv:		heap private data
+ * @debug_show:		called when heap debug file is read to add any
+ *			heap specific debug info to output
  *
  * Represents a pool of memory from which buffers can be made.  In some
  * systems the only heap is regular system memory allocated via vmalloc.
@@ -130,6 +140,7 @@ struct ion_heap {
 	int id;
 	const char *name;
 	void *priv;
+	int (*debug_show)(struct ion_heap *heap, struct seq_file *, void *);
 };
 
 /**
@@ -203,6 +214,54 @@ static inline struct ion_heap *ion_cma_heap_create(struct ion_platform_heap *)
 static inline void ion_cma_heap_destroy(struct ion_heap *) {};
 #endif
 
+/**
+ * struct ion_page_pool - pagepool struct
+ * @count:		number of zeroed items in the pool
+ * @dirty_count:	number of freed items still waiting to be zeroed
+ * @items:		list of zeroed items
+ * @dirty:		list of items waiting to be zeroed
+ * @lock:		lock protecting this struct and especially the counts
+ *			and item lists
+ * @gfp_mask:		gfp_mask to use from alloc
+ * @order:		order of pages in the pool
+ * @list:		entry in the global list of pools
+ * @hits:		allocations served with an already zeroed item
+ * @sync_zeroed:	allocations that had to zero a dirty item inline
+ * @misses:		allocations that fell back to the page allocator
+ * @zeroed:		pages zeroed by the pool
+ * @zero_ns:		time spent zeroing them
+ * @shrunk:		pages handed back to the system by the shrinker
+ *
+ * Allows you to keep a pool of pre allocated pages to use from your heap.
+ * Keeping a pool of pages that is ready for dma, ie any cached mapping have
+ * been invalidated from the cache, provides a significant peformance benefit
+ * on many systems.  Freed pages are zeroed by a low priority thread before
+ * they are handed out again, and a shrinker returns them to the system
+ * under memory pressure.
+ */
+struct ion_page_pool {
+	int count;
+	int dirty_count;
+	struct list_head items;
+	struct list_head dirty;
+	spinlock_t lock;
+	gfp_t gfp_mask;
+	unsigned int order;
+	struct list_head list;
+	unsigned long hits;
+	unsigned long sync_zeroed;
+	unsigned long misses;
+	unsigned long zeroed;
+	u64 zero_ns;
+	unsigned long shrunk;
+};
+
+struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order);
+void ion_page_pool_destroy(struct ion_page_pool *);
+struct page *ion_page_pool_alloc(struct ion_page_pool *);
+void ion_page_pool_free(struct ion_page_pool *, struct page *);
+void ion_page_pool_debug_show(struct ion_page_pool *, struct seq_file *);
+
 /**
  * The carveout heap returns physical addresses, since 0 may be a valid
  * physical address, this is used to indicate allocation failed
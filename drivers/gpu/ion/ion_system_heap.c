@@ -21,6 +21,7 @@
 #include <linux/ion.h>
 #include <linux/mm.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include "ion_priv.h"
@@ -32,8 +33,26 @@ struct page_info {
 };
 
 static unsigned int orders[] = {8, 4, 0};
+static const int num_orders = ARRAY_SIZE(orders);
 
-static struct page_info *alloc_largest_available(unsigned long size,
+static int order_to_index(unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < num_orders; i++)
+		if (order == orders[i])
+			return i;
+	BUG();
+	return -1;
+}
+
+struct ion_system_heap {
+	struct ion_heap heap;
+	struct ion_page_pool *pools[ARRAY_SIZE(orders)];
+};
+
+static struct page_info *alloc_largest_available(struct ion_system_heap *heap,
+						 unsigned long size,
 						 bool split_pages,
 						 unsigned int max_order)
 {
@@ -41,18 +60,21 @@ static struct page_info *alloc_largest_available(unsigned long size,
 	struct page_info *info;
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(orders); i++) {
+	for (i = 0; i < num_orders; i++) {
 		if (size < (1 << orders[i]) * PAGE_SIZE)
 			continue;
 		if (max_order < orders[i])
 			continue;
-		page = alloc_pages(GFP_HIGHUSER | __GFP_ZERO |
-				   __GFP_NOWARN | __GFP_NORETRY, orders[i]);
+		page = ion_page_pool_alloc(heap->pools[i]);
 		if (!page)
 			continue;
+		info = kmalloc(sizeof(struct page_info), GFP_KERNEL);
+		if (!info) {
+			ion_page_pool_free(heap->pools[i], page);
+			return NULL;
+		}
 		if (split_pages)
 			split_page(page, orders[i]);
-		info = kmalloc(sizeof(struct page_info *), GFP_KERNEL);
 		info->page = page;
 		info->order = orders[i];
 		return info;
@@ -60,11 +82,20 @@ static struct page_info *alloc_largest_available(unsigned long size,
 	return NULL;
 }
 
+static void free_buffer_page(struct ion_system_heap *heap, struct page *page,
+			     unsigned int order)
+{
+	ion_page_pool_free(heap->pools[order_to_index(order)], page);
+}
+
 static int ion_system_heap_allocate(struct ion_heap *heap,
 				     struct ion_buffer *buffer,
 				     unsigned long size, unsigned long align,
 				     unsigned long flags)
 {
+	struct ion_system_heap *sys_heap = container_of(heap,
+							struct ion_system_heap,
+							heap);
 	struct sg_table *table;
 	struct scatterlist *sg;
 	int ret;
@@ -79,8 +110,8 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 
 	INIT_LIST_HEAD(&pages);
 	while (size_remaining > 0) {
-		info = alloc_largest_available(size_remaining, split_pages,
-					       max_order);
+		info = alloc_largest_available(sys_heap, size_remaining,
+					       split_pages, max_order);
 		if (!info)
 			goto err;
 		list_add_tail(&info->list, &pages);
@@ -128,12 +159,12 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 err1:
 	kfree(table);
 err:
-	list_for_each_entry(info, &pages, list) {
+	list_for_each_entry_safe(info, tmp_info, &pages, list) {
 		if (split_pages)
 			for (i = 0; i < (1 << info->order); i++)
-				__free_page(info->page + i);
+				free_buffer_page(sys_heap, info->page + i, 0);
 		else
-			__free_pages(info->page, info->order);
+			free_buffer_page(sys_heap, info->page, info->order);
 
 		kfree(info);
 	}
@@ -142,12 +173,17 @@ err:
 
 void ion_system_heap_free(struct ion_buffer *buffer)
 {
+	struct ion_system_heap *sys_heap = container_of(buffer->heap,
+							struct ion_system_heap,
+							heap);
 	int i;
 	struct scatterlist *sg;
 	struct sg_table *table = buffer->priv_virt;
 
+	/* pages go back to the pools, which zero them in the background */
 	for_each_sg(table->sgl, sg, table->nents, i)
-		__free_pages(sg_page(sg), get_order(sg_dma_len(sg)));
+		free_buffer_page(sys_heap, sg_page(sg),
+				 get_order(sg_dma_len(sg)));
 	if (buffer->sg_table)
 		sg_free_table(buffer->sg_table);
 	kfree(buffer->sg_table);
@@ -238,21 +274,63 @@ static struct ion_heap_ops vmalloc_ops = {
 	.map_user = ion_system_heap_map_user,
 };
 
+static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
+				      void *unused)
+{
+	struct ion_system_heap *sys_heap = container_of(heap,
+							struct ion_system_heap,
+							heap);
+	int i;
+
+	seq_printf(s, "%5s %8s %8s %10s %10s %10s %10s %10s %8s\n",
+		   "order", "zeroed", "dirty", "hits", "sync_zero", "misses",
+		   "zero_pgs", "shrunk", "ns/page");
+	for (i = 0; i < num_orders; i++)
+		ion_page_pool_debug_show(sys_heap->pools[i], s);
+	return 0;
+}
+
 struct ion_heap *ion_system_heap_create(struct ion_platform_heap *unused)
 {
-	struct ion_heap *heap;
+	struct ion_system_heap *heap;
+	int i;
 
-	heap = kzalloc(sizeof(struct ion_heap), GFP_KERNEL);
+	heap = kzalloc(sizeof(struct ion_system_heap), GFP_KERNEL);
 	if (!heap)
 		return ERR_PTR(-ENOMEM);
-	heap->ops = &vmalloc_ops;
-	heap->type = ION_HEAP_TYPE_SYSTEM;
-	return heap;
+	heap->heap.ops = &vmalloc_ops;
+	heap->heap.type = ION_HEAP_TYPE_SYSTEM;
+	heap->heap.debug_show = ion_system_heap_debug_show;
+
+	for (i = 0; i < num_orders; i++) {
+		struct ion_page_pool *pool;
+		gfp_t gfp_flags = GFP_HIGHUSER | __GFP_NOWARN | __GFP_NORETRY;
+
+		pool = ion_page_pool_create(gfp_flags, orders[i]);
+		if (IS_ERR(pool))
+			goto err_create_pool;
+		heap->pools[i] = pool;
+	}
+	return &heap->heap;
+
+err_create_pool:
+	for (i = 0; i < num_orders; i++)
+		if (heap->pools[i])
+			ion_page_pool_destroy(heap->pools[i]);
+	kfree(heap);
+	return ERR_PTR(-ENOMEM);
 }
 
 void ion_system_heap_destroy(struct ion_heap *heap)
 {
-	kfree(heap);
+	struct ion_system_heap *sys_heap = container_of(heap,
+							struct ion_system_heap,
+							heap);
+	int i;
+
+	for (i = 0; i < num_orders; i++)
+		ion_page_pool_destroy(sys_heap->pools[i]);
+	kfree(sys_heap);
 }
 
 static int ion_system_contig_heap_allocate(struct ion_heap *heap,
@@ -21,6 +21,8 @@
 #include <linux/percpu.h>
 #include <linux/atomic.h>
 #include <linux/scatterlist.h>
+#include <linux/kthread.h>
+#include <linux/rbtree.h>
 #include <asm/page.h>
 #include <asm/unaligned.h>
 #include <crypto/hash.h>
@@ -43,7 +45,9 @@ struct convert_context {
 	unsigned int idx_in;
 	unsigned int idx_out;
 	sector_t sector;
+	unsigned int sectors_left;
 	atomic_t pending;
+	struct ablkcipher_request *req;
 };
 
 /*
@@ -60,6 +64,8 @@ struct dm_crypt_io {
 	int error;
 	sector_t sector;
 	struct dm_crypt_io *base_io;
+	struct rb_node rb_node;
+	mempool_t *pool;	/* NULL if allocated from _crypt_io_pool */
 };
 
 struct dm_crypt_request {
@@ -102,13 +108,12 @@ struct iv_lmk_private {
  * Crypt: maps a linear range of a block device
  * and encrypts / decrypts at the same time.
  */
-enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID };
+enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID, DM_CRYPT_PARALLEL };
 
 /*
  * Duplicated per-CPU state for cipher.
  */
 struct crypt_cpu {
-	struct ablkcipher_request *req;
 	/* ESSIV: struct crypto_cipher *essiv_tfm */
 	void *iv_private;
 	struct crypto_ablkcipher *tfms[0];
@@ -131,9 +136,23 @@ struct crypt_config {
 	mempool_t *page_pool;
 	struct bio_set *bs;
 
+	/*
+	 * parallel_crypt: reserve for the ios of write fragments, so that
+	 * parallel writes can't take the io_pool reserve from crypt_map()
+	 */
+	mempool_t *split_io_pool;
+
 	struct workqueue_struct *io_queue;
 	struct workqueue_struct *crypt_queue;
 
+	/*
+	 * parallel_crypt: encrypted write clones sorted by sector,
+	 * submitted by write_thread
+	 */
+	struct task_struct *write_thread;
+	wait_queue_head_t write_thread_wait;
+	struct rb_root write_tree;
+
 	char *cipher;
 	char *cipher_string;
 
@@ -177,15 +196,26 @@ struct crypt_config {
 #define MIN_IOS        16
 #define MIN_POOL_PAGES 32
 
+/*
+ * parallel_crypt: bios larger than this are split into chunks of this
+ * size which are converted on different CPUs.
+ */
+#define DM_CRYPT_SPLIT_SECTORS	128
+
 static struct kmem_cache *_crypt_io_pool;
 
 static void clone_init(struct dm_crypt_io *, struct bio *);
 static void kcryptd_queue_crypt(struct dm_crypt_io *io);
 static u8 *iv_of_dmreq(struct crypt_config *cc, struct dm_crypt_request *dmreq);
 
+/*
+ * The per-CPU copies only exist for cache locality; every copy is usable
+ * from any CPU.  kcryptd workers are unbound with parallel_crypt and may
+ * migrate at any time.
+ */
 static struct crypt_cpu *this_crypt_config(struct crypt_config *cc)
 {
-	return this_cpu_ptr(cc->cpu);
+	return __this_cpu_ptr(cc->cpu);
 }
 
 /*
@@ -665,9 +695,41 @@ static void crypt_convert_init(struct crypt_config *cc,
 	ctx->idx_in = bio_in ? bio_in->bi_idx : 0;
 	ctx->idx_out = bio_out ? bio_out->bi_idx : 0;
 	ctx->sector = sector + cc->iv_offset;
+	ctx->sectors_left = bio_in ? bio_sectors(bio_in) : 0;
 	init_completion(&ctx->restart);
 }
 
+/*
+ * Skip the first @sectors of the input bio, and of the output bio too
+ * when converting in place.
+ */
+static void crypt_convert_seek(struct convert_context *ctx,
+			       unsigned int sectors)
+{
+	unsigned int bytes = sectors << SECTOR_SHIFT;
+	struct bio_vec *bv;
+	unsigned int n;
+
+	ctx->sector += sectors;
+	ctx->sectors_left -= sectors;
+
+	while (bytes) {
+		bv = bio_iovec_idx(ctx->bio_in, ctx->idx_in);
+		n = min(bytes, bv->bv_len - ctx->offset_in);
+		ctx->offset_in += n;
+		bytes -= n;
+		if (ctx->offset_in >= bv->bv_len) {
+			ctx->offset_in = 0;
+			ctx->idx_in++;
+		}
+	}
+
+	if (ctx->bio_out == ctx->bio_in) {
+		ctx->idx_out = ctx->idx_in;
+		ctx->offset_out = ctx->offset_in;
+	}
+}
+
 static struct dm_crypt_request *dmreq_of_req(struct crypt_config *cc,
 					     struct ablkcipher_request *req)
 {
@@ -751,13 +813,26 @@ static void crypt_alloc_req(struct crypt_config *cc,
 	struct crypt_cpu *this_cc = this_crypt_config(cc);
 	unsigned key_index = ctx->sector & (cc->tfms_count - 1);
 
-	if (!this_cc->req)
-		this_cc->req = mempool_alloc(cc->req_pool, GFP_NOIO);
+	if (!ctx->req)
+		ctx->req = mempool_alloc(cc->req_pool, GFP_NOIO);
 
-	ablkcipher_request_set_tfm(this_cc->req, this_cc->tfms[key_index]);
-	ablkcipher_request_set_callback(this_cc->req,
+	ablkcipher_request_set_tfm(ctx->req, this_cc->tfms[key_index]);
+	ablkcipher_request_set_callback(ctx->req,
 	    CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
-	    kcryptd_async_done, dmreq_of_req(cc, this_cc->req));
+	    kcryptd_async_done, dmreq_of_req(cc, ctx->req));
+}
+
+/*
+ * Give back a request left over by a synchronous conversion, so that it
+ * is not held for the time the io spends on the underlying device.
+ */
+static void crypt_free_req(struct crypt_config *cc,
+			   struct convert_context *ctx)
+{
+	if (ctx->req) {
+		mempool_free(ctx->req, cc->req_pool);
+		ctx->req = NULL;
+	}
 }
 
 /*
@@ -766,19 +841,20 @@ static void crypt_alloc_req(struct crypt_config *cc,
 static int crypt_convert(struct crypt_config *cc,
 			 struct convert_context *ctx)
 {
-	struct crypt_cpu *this_cc = this_crypt_config(cc);
 	int r;
 
 	atomic_set(&ctx->pending, 1);
 
-	while(ctx->idx_in < ctx->bio_in->bi_vcnt &&
+	while(ctx->sectors_left &&
+	      ctx->idx_in < ctx->bio_in->bi_vcnt &&
 	      ctx->idx_out < ctx->bio_out->bi_vcnt) {
 
 		crypt_alloc_req(cc, ctx);
 
 		atomic_inc(&ctx->pending);
 
-		r = crypt_convert_block(cc, ctx, this_cc->req);
+		r = crypt_convert_block(cc, ctx, ctx->req);
+		ctx->sectors_left--;
 
 		switch (r) {
 		/* async */
@@ -787,7 +863,7 @@ static int crypt_convert(struct crypt_config *cc,
 			INIT_COMPLETION(ctx->restart);
 			/* fall through*/
 		case -EINPROGRESS:
-			this_cc->req = NULL;
+			ctx->req = NULL;
 			ctx->sector++;
 			continue;
 
@@ -801,10 +877,12 @@ static int crypt_convert(struct crypt_config *cc,
 		/* error */
 		default:
 			atomic_dec(&ctx->pending);
+			crypt_free_req(cc, ctx);
 			return r;
 		}
 	}
 
+	crypt_free_req(cc, ctx);
 	return 0;
 }
 
@@ -884,18 +962,29 @@ static void crypt_free_buffer_pages(struct crypt_config *cc, struct bio *clone)
 	}
 }
 
+/*
+ * Allocate an io from @pool, or straight from _crypt_io_pool without a
+ * reserve if @pool is NULL.
+ */
 static struct dm_crypt_io *crypt_io_alloc(struct dm_target *ti,
-					  struct bio *bio, sector_t sector)
+					  struct bio *bio, sector_t sector,
+					  mempool_t *pool, gfp_t gfp_mask)
 {
-	struct crypt_config *cc = ti->private;
 	struct dm_crypt_io *io;
 
-	io = mempool_alloc(cc->io_pool, GFP_NOIO);
+	if (pool)
+		io = mempool_alloc(pool, gfp_mask);
+	else
+		io = kmem_cache_alloc(_crypt_io_pool, gfp_mask);
+	if (!io)
+		return NULL;
+	io->pool = pool;
 	io->target = ti;
 	io->base_bio = bio;
 	io->sector = sector;
 	io->error = 0;
 	io->base_io = NULL;
+	io->ctx.req = NULL;
 	atomic_set(&io->pending, 0);
 
 	return io;
@@ -913,7 +1002,6 @@ static void crypt_inc_pending(struct dm_crypt_io *io)
  */
 static void crypt_dec_pending(struct dm_crypt_io *io)
 {
-	struct crypt_config *cc = io->target->private;
 	struct bio *base_bio = io->base_bio;
 	struct dm_crypt_io *base_io = io->base_io;
 	int error = io->error;
@@ -921,7 +1009,10 @@ static void crypt_dec_pending(struct dm_crypt_io *io)
 	if (!atomic_dec_and_test(&io->pending))
 		return;
 
-	mempool_free(io, cc->io_pool);
+	if (io->pool)
+		mempool_free(io, io->pool);
+	else
+		kmem_cache_free(_crypt_io_pool, io);
 
 	if (likely(!base_io))
 		bio_endio(base_bio, error);
@@ -1044,6 +1135,92 @@ static void kcryptd_queue_io(struct dm_crypt_io *io)
 	queue_work(cc->io_queue, &io->work);
 }
 
+/*
+ * parallel_crypt: chunks of a write finish encryption in no particular
+ * order, so they are collected in a tree sorted by sector and submitted
+ * by a single thread.  This keeps the write stream ordered for the
+ * underlying device and takes submission off the crypt CPUs.
+ */
+static int dmcrypt_write(void *data)
+{
+	struct crypt_config *cc = data;
+	struct dm_crypt_io *io;
+
+	while (1) {
+		struct rb_root write_tree;
+		struct blk_plug plug;
+
+		DECLARE_WAITQUEUE(wait, current);
+
+		spin_lock_irq(&cc->write_thread_wait.lock);
+continue_locked:
+
+		if (!RB_EMPTY_ROOT(&cc->write_tree))
+			goto pop_from_list;
+
+		__set_current_state(TASK_INTERRUPTIBLE);
+		__add_wait_queue(&cc->write_thread_wait, &wait);
+
+		spin_unlock_irq(&cc->write_thread_wait.lock);
+
+		if (unlikely(kthread_should_stop())) {
+			set_task_state(current, TASK_RUNNING);
+			remove_wait_queue(&cc->write_thread_wait, &wait);
+			break;
+		}
+
+		schedule();
+
+		set_task_state(current, TASK_RUNNING);
+		spin_lock_irq(&cc->write_thread_wait.lock);
+		__remove_wait_queue(&cc->write_thread_wait, &wait);
+		goto continue_locked;
+
+pop_from_list:
+		write_tree = cc->write_tree;
+		cc->write_tree = RB_ROOT;
+		spin_unlock_irq(&cc->write_thread_wait.lock);
+
+		BUG_ON(rb_parent(write_tree.rb_node));
+
+		blk_start_plug(&plug);
+		do {
+			io = rb_entry(rb_first(&write_tree),
+				      struct dm_crypt_io, rb_node);
+			rb_erase(&io->rb_node, &write_tree);
+			generic_make_request(io->ctx.bio_out);
+		} while (!RB_EMPTY_ROOT(&write_tree));
+		blk_finish_plug(&plug);
+	}
+
+	return 0;
+}
+
+static void kcryptd_queue_write_sorted(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->target->private;
+	struct rb_node **rbp, *parent;
+	unsigned long flags;
+	sector_t sector = io->ctx.bio_out->bi_sector;
+
+	spin_lock_irqsave(&cc->write_thread_wait.lock, flags);
+	rbp = &cc->write_tree.rb_node;
+	parent = NULL;
+	while (*rbp) {
+		parent = *rbp;
+		if (sector < rb_entry(parent, struct dm_crypt_io,
+				      rb_node)->ctx.bio_out->bi_sector)
+			rbp = &(*rbp)->rb_left;
+		else
+			rbp = &(*rbp)->rb_right;
+	}
+	rb_link_node(&io->rb_node, parent, rbp);
+	rb_insert_color(&io->rb_node, &cc->write_tree);
+
+	wake_up_locked(&cc->write_thread_wait);
+	spin_unlock_irqrestore(&cc->write_thread_wait.lock, flags);
+}
+
 static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 {
 	struct bio *clone = io->ctx.bio_out;
@@ -1061,28 +1238,38 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 
 	clone->bi_sector = cc->start + io->sector;
 
-	if (async)
+	if (test_bit(DM_CRYPT_PARALLEL, &cc->flags))
+		kcryptd_queue_write_sorted(io);
+	else if (async)
 		kcryptd_queue_io(io);
 	else
 		generic_make_request(clone);
 }
 
-static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
+/*
+ * Convert the part of the bio described by io->ctx, which must have been
+ * set up by the caller.
+ */
+static void kcryptd_crypt_write_ctx(struct dm_crypt_io *io)
 {
 	struct crypt_config *cc = io->target->private;
 	struct bio *clone;
-	struct dm_crypt_io *new_io;
+	struct dm_crypt_io *new_io, *base_io;
+	mempool_t *pool = cc->io_pool;
+	unsigned int idx_in, offset_in, sectors_left;
 	int crypt_finished;
 	unsigned out_of_pages = 0;
-	unsigned remaining = io->base_bio->bi_size;
+	unsigned remaining = io->ctx.sectors_left << SECTOR_SHIFT;
 	sector_t sector = io->sector;
 	int r;
 
+	if (test_bit(DM_CRYPT_PARALLEL, &cc->flags))
+		pool = cc->split_io_pool;
+
 	/*
 	 * Prevent io from disappearing until this function completes.
 	 */
 	crypt_inc_pending(io);
-	crypt_convert_init(cc, &io->ctx, NULL, io->base_bio, sector);
 
 	/*
 	 * The allocated buffers can be smaller than the whole bio,
@@ -1133,28 +1320,41 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 		/*
 		 * With async crypto it is unsafe to share the crypto context
 		 * between fragments, so switch to a new dm_crypt_io structure.
+		 * The same goes for parallel_crypt, where the io stays on the
+		 * write tree until the write thread has submitted its clone.
 		 */
-		if (unlikely(!crypt_finished && remaining)) {
-			new_io = crypt_io_alloc(io->target, io->base_bio,
-						sector);
-			crypt_inc_pending(new_io);
-			crypt_convert_init(cc, &new_io->ctx, NULL,
-					   io->base_bio, sector);
-			new_io->ctx.idx_in = io->ctx.idx_in;
-			new_io->ctx.offset_in = io->ctx.offset_in;
+		if (unlikely((!crypt_finished ||
+			      test_bit(DM_CRYPT_PARALLEL, &cc->flags)) &&
+			     remaining)) {
+			idx_in = io->ctx.idx_in;
+			offset_in = io->ctx.offset_in;
+			sectors_left = io->ctx.sectors_left;
 
 			/*
 			 * Fragments after the first use the base_io
-			 * pending count.
+			 * pending count.  Let go of the previous fragment
+			 * before waiting for the pool, so that no worker
+			 * holds a reserved io while it waits for another.
 			 */
-			if (!io->base_io)
-				new_io->base_io = io;
+			base_io = io->base_io;
+			if (!base_io)
+				base_io = io;
 			else {
-				new_io->base_io = io->base_io;
-				crypt_inc_pending(io->base_io);
+				crypt_inc_pending(base_io);
 				crypt_dec_pending(io);
 			}
 
+			new_io = crypt_io_alloc(base_io->target,
+						base_io->base_bio, sector,
+						pool, GFP_NOIO);
+			crypt_inc_pending(new_io);
+			crypt_convert_init(cc, &new_io->ctx, NULL,
+					   base_io->base_bio, sector);
+			new_io->ctx.idx_in = idx_in;
+			new_io->ctx.offset_in = offset_in;
+			new_io->ctx.sectors_left = sectors_left;
+			new_io->base_io = base_io;
+
 			io = new_io;
 		}
 	}
@@ -1167,16 +1367,17 @@ static void kcryptd_crypt_read_done(struct dm_crypt_io *io)
 	crypt_dec_pending(io);
 }
 
-static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
+/*
+ * Convert the part of the bio described by io->ctx, which must have been
+ * set up by the caller.
+ */
+static void kcryptd_crypt_read_ctx(struct dm_crypt_io *io)
 {
 	struct crypt_config *cc = io->target->private;
 	int r = 0;
 
 	crypt_inc_pending(io);
 
-	crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
-			   io->sector);
-
 	r = crypt_convert(cc, &io->ctx);
 	if (r < 0)
 		io->error = -EIO;
@@ -1217,6 +1418,102 @@ static void kcryptd_async_done(struct crypto_async_request *async_req,
 		kcryptd_crypt_write_io_submit(io, 1);
 }
 
+static void kcryptd_crypt_chunk(struct work_struct *work)
+{
+	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
+
+	if (bio_data_dir(io->base_bio) == READ)
+		kcryptd_crypt_read_ctx(io);
+	else
+		kcryptd_crypt_write_ctx(io);
+}
+
+/*
+ * parallel_crypt: hand out the bio in DM_CRYPT_SPLIT_SECTORS chunks, each
+ * with its own convert_context and crypto requests, to the unbound
+ * crypt_queue.  The chunks complete through their base_io.
+ *
+ * This runs on a crypt_queue worker itself, so never wait for memory
+ * here.  The chunks are allocated without a reserve: the io_pool reserve
+ * is left to crypt_map() and split_io_pool to the write fragments.  Once
+ * an allocation fails the rest of the bio is converted inline by @io.
+ */
+static int kcryptd_crypt_split(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->target->private;
+	unsigned int sectors = io->ctx.sectors_left;
+	unsigned int offset, len;
+	struct dm_crypt_io *chunk;
+	int read = bio_data_dir(io->base_bio) == READ;
+
+	if (!test_bit(DM_CRYPT_PARALLEL, &cc->flags) ||
+	    sectors <= DM_CRYPT_SPLIT_SECTORS || num_online_cpus() == 1)
+		return 0;
+
+	crypt_inc_pending(io);
+
+	for (offset = 0; offset < sectors; offset += len) {
+		len = min_t(unsigned int, sectors - offset,
+			    DM_CRYPT_SPLIT_SECTORS);
+
+		chunk = crypt_io_alloc(io->target, io->base_bio,
+				       io->sector + offset, NULL, GFP_NOWAIT);
+		if (!chunk)
+			break;
+		chunk->base_io = io;
+		crypt_inc_pending(io);
+
+		if (read) {
+			crypt_convert_init(cc, &chunk->ctx, io->base_bio,
+					   io->base_bio, io->sector);
+			/* dropped by kcryptd_crypt_read_done() */
+			crypt_inc_pending(chunk);
+		} else
+			crypt_convert_init(cc, &chunk->ctx, NULL,
+					   io->base_bio, io->sector);
+		crypt_convert_seek(&chunk->ctx, offset);
+		chunk->ctx.sectors_left = len;
+
+		INIT_WORK(&chunk->work, kcryptd_crypt_chunk);
+		queue_work(cc->crypt_queue, &chunk->work);
+	}
+
+	if (offset < sectors) {
+		crypt_convert_seek(&io->ctx, offset);
+		io->sector += offset;
+		if (read)
+			kcryptd_crypt_read_ctx(io);
+		else
+			kcryptd_crypt_write_ctx(io);
+	} else if (read)
+		/* the reference held by the completed clone */
+		kcryptd_crypt_read_done(io);
+	crypt_dec_pending(io);
+
+	return 1;
+}
+
+static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->target->private;
+
+	crypt_convert_init(cc, &io->ctx, NULL, io->base_bio, io->sector);
+
+	if (!kcryptd_crypt_split(io))
+		kcryptd_crypt_write_ctx(io);
+}
+
+static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->target->private;
+
+	crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
+			   io->sector);
+
+	if (!kcryptd_crypt_split(io))
+		kcryptd_crypt_read_ctx(io);
+}
+
 static void kcryptd_crypt(struct work_struct *work)
 {
 	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
@@ -1347,7 +1644,6 @@ static int crypt_wipe_key(struct crypt_config *cc)
 static void crypt_dtr(struct dm_target *ti)
 {
 	struct crypt_config *cc = ti->private;
-	struct crypt_cpu *cpu_cc;
 	int cpu;
 
 	ti->private = NULL;
@@ -1355,18 +1651,17 @@ static void crypt_dtr(struct dm_target *ti)
 	if (!cc)
 		return;
 
+	if (cc->write_thread)
+		kthread_stop(cc->write_thread);
+
 	if (cc->io_queue)
 		destroy_workqueue(cc->io_queue);
 	if (cc->crypt_queue)
 		destroy_workqueue(cc->crypt_queue);
 
 	if (cc->cpu)
-		for_each_possible_cpu(cpu) {
-			cpu_cc = per_cpu_ptr(cc->cpu, cpu);
-			if (cpu_cc->req)
-				mempool_free(cpu_cc->req, cc->req_pool);
+		for_each_possible_cpu(cpu)
 			crypt_free_tfms(cc, cpu);
-		}
 
 	if (cc->bs)
 		bioset_free(cc->bs);
@@ -1377,6 +1672,8 @@ static void crypt_dtr(struct dm_target *ti)
 		mempool_destroy(cc->req_pool);
 	if (cc->io_pool)
 		mempool_destroy(cc->io_pool);
+	if (cc->split_io_pool)
+		mempool_destroy(cc->split_io_pool);
 
 	if (cc->iv_gen_ops && cc->iv_gen_ops->dtr)
 		cc->iv_gen_ops->dtr(cc);
@@ -1571,7 +1868,7 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	char dummy;
 
 	static struct dm_arg _args[] = {
-		{0, 1, "Invalid number of feature args"},
+		{0, 2, "Invalid number of feature args"},
 	};
 
 	if (argc < 5) {
@@ -1655,15 +1952,23 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		if (ret)
 			goto bad;
 
-		opt_string = dm_shift_arg(&as);
+		while (opt_params--) {
+			opt_string = dm_shift_arg(&as);
+			if (!opt_string) {
+				ret = -EINVAL;
+				ti->error = "Not enough feature arguments";
+				goto bad;
+			}
 
-		if (opt_params == 1 && opt_string &&
-		    !strcasecmp(opt_string, "allow_discards"))
-			ti->num_discard_requests = 1;
-		else if (opt_params) {
-			ret = -EINVAL;
-			ti->error = "Invalid feature arguments";
-			goto bad;
+			if (!strcasecmp(opt_string, "allow_discards"))
+				ti->num_discard_requests = 1;
+			else if (!strcasecmp(opt_string, "parallel_crypt"))
+				set_bit(DM_CRYPT_PARALLEL, &cc->flags);
+			else {
+				ret = -EINVAL;
+				ti->error = "Invalid feature arguments";
+				goto bad;
+			}
 		}
 	}
 
@@ -1677,16 +1982,45 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		goto bad;
 	}
 
-	cc->crypt_queue = alloc_workqueue("kcryptd",
-					  WQ_NON_REENTRANT|
-					  WQ_CPU_INTENSIVE|
-					  WQ_MEM_RECLAIM,
-					  1);
+	if (test_bit(DM_CRYPT_PARALLEL, &cc->flags))
+		cc->crypt_queue = alloc_workqueue("kcryptd",
+						  WQ_CPU_INTENSIVE|
+						  WQ_MEM_RECLAIM|
+						  WQ_UNBOUND,
+						  num_online_cpus());
+	else
+		cc->crypt_queue = alloc_workqueue("kcryptd",
+						  WQ_NON_REENTRANT|
+						  WQ_CPU_INTENSIVE|
+						  WQ_MEM_RECLAIM,
+						  1);
 	if (!cc->crypt_queue) {
 		ti->error = "Couldn't create kcryptd queue";
 		goto bad;
 	}
 
+	if (test_bit(DM_CRYPT_PARALLEL, &cc->flags)) {
+		cc->split_io_pool = mempool_create_slab_pool(MIN_IOS,
+							     _crypt_io_pool);
+		if (!cc->split_io_pool) {
+			ti->error = "Cannot allocate parallel crypt io mempool";
+			goto bad;
+		}
+
+		init_waitqueue_head(&cc->write_thread_wait);
+		cc->write_tree = RB_ROOT;
+
+		cc->write_thread = kthread_create(dmcrypt_write, cc,
+						  "dmcrypt_write");
+		if (IS_ERR(cc->write_thread)) {
+			ret = PTR_ERR(cc->write_thread);
+			cc->write_thread = NULL;
+			ti->error = "Couldn't spawn write thread";
+			goto bad;
+		}
+		wake_up_process(cc->write_thread);
+	}
+
 	ti->num_flush_requests = 1;
 	ti->discard_zeroes_data_unsupported = 1;
 
@@ -1701,7 +2035,7 @@ static int crypt_map(struct dm_target *ti, struct bio *bio,
 		     union map_info *map_context)
 {
 	struct dm_crypt_io *io;
-	struct crypt_config *cc;
+	struct crypt_config *cc = ti->private;
 
 	/*
 	 * If bio is REQ_FLUSH or REQ_DISCARD, just bypass crypt queues.
@@ -1709,14 +2043,14 @@ static int crypt_map(struct dm_target *ti, struct bio *bio,
 	 * - for REQ_DISCARD caller must use flush if IO ordering matters
 	 */
 	if (unlikely(bio->bi_rw & (REQ_FLUSH | REQ_DISCARD))) {
-		cc = ti->private;
 		bio->bi_bdev = cc->dev->bdev;
 		if (bio_sectors(bio))
 			bio->bi_sector = cc->start + dm_target_offset(ti, bio->bi_sector);
 		return DM_MAPIO_REMAPPED;
 	}
 
-	io = crypt_io_alloc(ti, bio, dm_target_offset(ti, bio->bi_sector));
+	io = crypt_io_alloc(ti, bio, dm_target_offset(ti, bio->bi_sector),
+			    cc->io_pool, GFP_NOIO);
 
 	if (bio_data_dir(io->base_bio) == READ) {
 		if (kcryptd_io_read(io, GFP_NOWAIT))
@@ -1732,6 +2066,7 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 {
 	struct crypt_config *cc = ti->private;
 	unsigned i, sz = 0;
+	int num_feature_args = 0;
 
 	switch (type) {
 	case STATUSTYPE_INFO:
@@ -1750,8 +2085,15 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		DMEMIT(" %llu %s %llu", (unsigned long long)cc->iv_offset,
 				cc->dev->name, (unsigned long long)cc->start);
 
-		if (ti->num_discard_requests)
-			DMEMIT(" 1 allow_discards");
+		num_feature_args += !!ti->num_discard_requests;
+		num_feature_args += test_bit(DM_CRYPT_PARALLEL, &cc->flags);
+		if (num_feature_args) {
+			DMEMIT(" %d", num_feature_args);
+			if (ti->num_discard_requests)
+				DMEMIT(" allow_discards");
+			if (test_bit(DM_CRYPT_PARALLEL, &cc->flags))
+				DMEMIT(" parallel_crypt");
+		}
 
 		break;
 	}
@@ -1848,7 +2190,7 @@ static int crypt_iterate_devices(struct dm_target *ti,
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 11, 0},
+	.version = {1, 12, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
@@ -1413,6 +1413,71 @@ static struct attribute_group ab8505_attr_group = {
 	.attrs	= ab8505_sysfs_entries,
 };
 
+/*
+ * Children which use another child, mostly the gpadc, from their suspend
+ * or resume callbacks.  Only these children have been audited, so only
+ * they are suspended and resumed asynchronously, once ordered.
+ */
+static const struct {
+	const char *consumer;
+	const char *supplier;
+} ab8500_pm_deps[] = {
+	{ "ab8500-charger",	"ab8500-gpadc" },
+	{ "ab8500-btemp",	"ab8500-gpadc" },
+	{ "ab8500-fg",		"ab8500-gpadc" },
+	{ "ab8500-acc-det",	"ab8500-gpadc" },
+	{ "abx500-temp",	"ab8500-gpadc" },
+	{ "abx500-chargalg",	"ab8500-charger" },
+	{ "abx500-chargalg",	"ab8500-btemp" },
+	{ "abx500-chargalg",	"ab8500-fg" },
+};
+
+static int ab8500_match_child(struct device *dev, void *name)
+{
+	return !strcmp(to_platform_device(dev)->name, name);
+}
+
+static int ab8500_child_async(struct device *dev, void *unused)
+{
+	const char *name = to_platform_device(dev)->name;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ab8500_pm_deps); i++) {
+		if (!strcmp(name, ab8500_pm_deps[i].consumer) ||
+		    !strcmp(name, ab8500_pm_deps[i].supplier)) {
+			device_enable_async_suspend(dev);
+			break;
+		}
+	}
+	return 0;
+}
+
+static void __devinit ab8500_setup_async_pm(struct ab8500 *ab8500)
+{
+	struct device *consumer, *supplier;
+	int i, ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(ab8500_pm_deps) && !ret; i++) {
+		consumer = device_find_child(ab8500->dev,
+				(void *)ab8500_pm_deps[i].consumer,
+				ab8500_match_child);
+		supplier = device_find_child(ab8500->dev,
+				(void *)ab8500_pm_deps[i].supplier,
+				ab8500_match_child);
+		if (consumer && supplier)
+			ret = device_pm_add_dependency(consumer, supplier);
+		put_device(consumer);
+		put_device(supplier);
+	}
+
+	if (ret) {
+		dev_warn(ab8500->dev, "no async PM, dependency error %d\n",
+			 ret);
+		return;
+	}
+	device_for_each_child(ab8500->dev, NULL, ab8500_child_async);
+}
+
 int __devinit ab8500_init(struct ab8500 *ab8500, enum ab8500_version version)
 {
 	static char *switch_off_status[] = {
@@ -1629,6 +1694,8 @@ int __devinit ab8500_init(struct ab8500 *ab8500, enum ab8500_version version)
 			dev_err(ab8500->dev, "error adding bm devices\n");
 	}
 
+	ab8500_setup_async_pm(ab8500);
+
 	ret = sysfs_create_group(&ab8500->dev->kobj, &ab8500_attr_group);
 
 	if (((is_ab8505(ab8500) || is_ab9540(ab8500)) &&
@@ -398,6 +398,22 @@ static void __devinit mmci_dma_setup(struct mmci_host *host)
 	dev_info(mmc_dev(host->mmc), "DMA channels RX %s, TX %s\n",
 		 rxname, txname);
 
+	/*
+	 * Suspending the DMA engine may cut its power, so have the PM core
+	 * suspend the host before and resume it after the engine, also if
+	 * either is handled asynchronously.  Else stay synchronous.  The
+	 * dependency is dropped with the device, not when the channels are
+	 * released, as mmci_dma_release() may be called in atomic context.
+	 */
+	if (host->dma_rx_channel &&
+	    device_pm_add_dependency(mmc_dev(host->mmc),
+				     host->dma_rx_channel->device->dev))
+		device_disable_async_suspend(mmc_dev(host->mmc));
+	if (host->dma_tx_channel && plat->dma_tx_param &&
+	    device_pm_add_dependency(mmc_dev(host->mmc),
+				     host->dma_tx_channel->device->dev))
+		device_disable_async_suspend(mmc_dev(host->mmc));
+
 	/*
 	 * Limit the maximum segment size in any SG entry according to
 	 * the parameters of the DMA engine device.
@@ -1770,6 +1786,7 @@ static int __devinit mmci_probe(struct amba_device *dev,
 		 amba_rev(dev), (unsigned long long)dev->res.start,
 		 dev->irq[0], dev->irq[1]);
 
+	device_enable_async_suspend(&dev->dev);
 	mmci_dma_setup(host);
 
 	pm_runtime_set_autosuspend_delay(&dev->dev, 50);
@@ -1156,6 +1156,12 @@ static struct regulator *create_regulator(struct regulator_dev *rdev,
 				  dev->kobj.name, err);
 			goto link_name_err;
 		}
+
+		/* suspend the consumer before and resume it after us */
+		err = device_pm_add_dependency(dev, &rdev->dev);
+		if (err)
+			rdev_dbg(rdev, "no PM dependency for %s: %d\n",
+				 dev_name(dev), err);
 	} else {
 		regulator->supply_name = kstrdup(supply_name, GFP_KERNEL);
 		if (regulator->supply_name == NULL)
@@ -1420,6 +1426,7 @@ void regulator_put(struct regulator *regulator)
 
 	/* remove any sysfs entries */
 	if (regulator->dev) {
+		device_pm_remove_dependency(regulator->dev, &rdev->dev);
 		sysfs_remove_link(&rdev->dev.kobj, regulator->supply_name);
 		device_remove_file(regulator->dev, &regulator->dev_attr);
 		kfree(regulator->dev_attr.attr.name);
@@ -454,5 +454,5 @@ static void __exit cw1200_sdio_exit(void)
 }
 
 
-module_init(cw1200_sdio_init);
+module_init_async(cw1200_sdio_init);
 module_exit(cw1200_sdio_exit);
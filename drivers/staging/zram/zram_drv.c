@@ -32,12 +32,15 @@
 #include <linux/lzo.h>
 #include <linux/string.h>
 #include <linux/vmalloc.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include "zram_drv.h"
 
 /* Globals */
 static int zram_major;
 struct zram *zram_devices;
+static struct workqueue_struct *zram_wq;
 
 /* Module params (documentation at end) */
 static unsigned int num_devices;
@@ -311,16 +314,88 @@ static int zram_read_before_write(struct zram *zram, char *mem, u32 index)
 	return 0;
 }
 
+/*
+ * Store the @clen bytes at @src compressed from @page as zram page
+ * @index.  Called with zram->lock held for writing.
+ */
+static int zram_store_page(struct zram *zram, u32 index, struct page *page,
+			   unsigned char *src, size_t clen)
+{
+	u32 store_offset;
+	void *handle;
+	struct zobj_header *zheader;
+	struct page *page_store;
+	unsigned char *cmem;
+
+	/*
+	 * Page is incompressible. Store it as-is (uncompressed)
+	 * since we do not want to return too many disk write
+	 * errors which has side effect of hanging the system.
+	 */
+	if (unlikely(clen > max_zpage_size)) {
+		clen = PAGE_SIZE;
+		page_store = alloc_page(GFP_NOIO | __GFP_HIGHMEM);
+		if (unlikely(!page_store)) {
+			pr_info("Error allocating memory for "
+				"incompressible page: %u\n", index);
+			return -ENOMEM;
+		}
+
+		store_offset = 0;
+		zram_set_flag(zram, index, ZRAM_UNCOMPRESSED);
+		zram_stat_inc(&zram->stats.pages_expand);
+		handle = page_store;
+		src = kmap_atomic(page);
+		cmem = kmap_atomic(page_store);
+		goto memstore;
+	}
+
+	handle = zs_malloc(zram->mem_pool, clen + sizeof(*zheader));
+	if (!handle) {
+		pr_info("Error allocating memory for compressed "
+			"page: %u, size=%zu\n", index, clen);
+		return -ENOMEM;
+	}
+	cmem = zs_map_object(zram->mem_pool, handle);
+
+memstore:
+#if 0
+	/* Back-reference needed for memory defragmentation */
+	if (!zram_test_flag(zram, index, ZRAM_UNCOMPRESSED)) {
+		zheader = (struct zobj_header *)cmem;
+		zheader->table_idx = index;
+		cmem += sizeof(*zheader);
+	}
+#endif
+
+	memcpy(cmem, src, clen);
+
+	if (unlikely(zram_test_flag(zram, index, ZRAM_UNCOMPRESSED))) {
+		kunmap_atomic(cmem);
+		kunmap_atomic(src);
+	} else {
+		zs_unmap_object(zram->mem_pool, handle);
+	}
+
+	zram->table[index].handle = handle;
+	zram->table[index].size = clen;
+
+	/* Update stats */
+	zram_stat64_add(zram, &zram->stats.compr_size, clen);
+	zram_stat_inc(&zram->stats.pages_stored);
+	if (clen <= PAGE_SIZE / 2)
+		zram_stat_inc(&zram->stats.good_compress);
+
+	return 0;
+}
+
 static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			   int offset)
 {
 	int ret;
-	u32 store_offset;
 	size_t clen;
-	void *handle;
-	struct zobj_header *zheader;
-	struct page *page, *page_store;
-	unsigned char *user_mem, *cmem, *src, *uncmem = NULL;
+	struct page *page;
+	unsigned char *user_mem, *src, *uncmem = NULL;
 
 	page = bvec->bv_page;
 	src = zram->compress_buffer;
@@ -381,68 +456,7 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 		goto out;
 	}
 
-	/*
-	 * Page is incompressible. Store it as-is (uncompressed)
-	 * since we do not want to return too many disk write
-	 * errors which has side effect of hanging the system.
-	 */
-	if (unlikely(clen > max_zpage_size)) {
-		clen = PAGE_SIZE;
-		page_store = alloc_page(GFP_NOIO | __GFP_HIGHMEM);
-		if (unlikely(!page_store)) {
-			pr_info("Error allocating memory for "
-				"incompressible page: %u\n", index);
-			ret = -ENOMEM;
-			goto out;
-		}
-
-		store_offset = 0;
-		zram_set_flag(zram, index, ZRAM_UNCOMPRESSED);
-		zram_stat_inc(&zram->stats.pages_expand);
-		handle = page_store;
-		src = kmap_atomic(page);
-		cmem = kmap_atomic(page_store);
-		goto memstore;
-	}
-
-	handle = zs_malloc(zram->mem_pool, clen + sizeof(*zheader));
-	if (!handle) {
-		pr_info("Error allocating memory for compressed "
-			"page: %u, size=%zu\n", index, clen);
-		ret = -ENOMEM;
-		goto out;
-	}
-	cmem = zs_map_object(zram->mem_pool, handle);
-
-memstore:
-#if 0
-	/* Back-reference needed for memory defragmentation */
-	if (!zram_test_flag(zram, index, ZRAM_UNCOMPRESSED)) {
-		zheader = (struct zobj_header *)cmem;
-		zheader->table_idx = index;
-		cmem += sizeof(*zheader);
-	}
-#endif
-
-	memcpy(cmem, src, clen);
-
-	if (unlikely(zram_test_flag(zram, index, ZRAM_UNCOMPRESSED))) {
-		kunmap_atomic(cmem);
-		kunmap_atomic(src);
-	} else {
-		zs_unmap_object(zram->mem_pool, handle);
-	}
-
-	zram->table[index].handle = handle;
-	zram->table[index].size = clen;
-
-	/* Update stats */
-	zram_stat64_add(zram, &zram->stats.compr_size, clen);
-	zram_stat_inc(&zram->stats.pages_stored);
-	if (clen <= PAGE_SIZE / 2)
-		zram_stat_inc(&zram->stats.good_compress);
-
-	return 0;
+	ret = zram_store_page(zram, index, page, src, clen);
 
 out:
 	if (ret)
@@ -468,6 +482,196 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 	return ret;
 }
 
+/* A write whose pages are spread over several compression streams */
+struct zram_write_ctl {
+	struct zram *zram;
+	struct bio *bio;
+	u32 index;		/* zram page of the first bio_vec */
+	int stride;		/* number of streams writing the bio */
+	atomic_t pending;	/* streams handed to zram_wq */
+	struct completion done;
+	unsigned int memalloc;	/* submitter's PF_MEMALLOC */
+	int ret;
+};
+
+static struct zram_strm *zram_strm_get(struct zram *zram, bool wait)
+{
+	struct zram_strm *strm;
+
+	spin_lock(&zram->strm_lock);
+	while (list_empty(&zram->strm_list)) {
+		spin_unlock(&zram->strm_lock);
+		if (!wait)
+			return NULL;
+		wait_event(zram->strm_wait, !list_empty(&zram->strm_list));
+		spin_lock(&zram->strm_lock);
+	}
+	strm = list_first_entry(&zram->strm_list, struct zram_strm, list);
+	list_del(&strm->list);
+	spin_unlock(&zram->strm_lock);
+
+	return strm;
+}
+
+static void zram_strm_put(struct zram *zram, struct zram_strm *strm)
+{
+	spin_lock(&zram->strm_lock);
+	list_add(&strm->list, &zram->strm_list);
+	spin_unlock(&zram->strm_lock);
+	wake_up(&zram->strm_wait);
+}
+
+/*
+ * Like zram_bvec_write() for a whole page, but compresses into @strm
+ * and only takes zram->lock to store the result.
+ */
+static int zram_strm_write(struct zram *zram, struct zram_strm *strm,
+			   struct page *page, u32 index)
+{
+	unsigned char *user_mem;
+	size_t clen = 0;
+	bool zero;
+	int ret = 0;
+
+	user_mem = kmap_atomic(page);
+	zero = page_zero_filled(user_mem);
+	if (!zero)
+		ret = lzo1x_1_compress(user_mem, PAGE_SIZE, strm->buffer,
+				       &clen, strm->workmem);
+	kunmap_atomic(user_mem);
+
+	if (unlikely(ret != LZO_E_OK)) {
+		pr_err("Compression failed! err=%d\n", ret);
+		goto out;
+	}
+
+	down_write(&zram->lock);
+	if (zram->table[index].handle ||
+	    zram_test_flag(zram, index, ZRAM_ZERO))
+		zram_free_page(zram, index);
+
+	if (zero) {
+		zram_stat_inc(&zram->stats.pages_zero);
+		zram_set_flag(zram, index, ZRAM_ZERO);
+	} else {
+		ret = zram_store_page(zram, index, page, strm->buffer, clen);
+	}
+	up_write(&zram->lock);
+
+out:
+	if (ret)
+		zram_stat64_inc(zram, &zram->stats.failed_writes);
+	return ret;
+}
+
+/* Write every ctl->stride'th page of the bio, starting with @first */
+static int zram_write_stride(struct zram_write_ctl *ctl,
+			     struct zram_strm *strm, int first)
+{
+	struct bio *bio = ctl->bio;
+	struct bio_vec *bvec;
+	int i, ret;
+
+	for (i = first; i < bio->bi_vcnt - bio->bi_idx; i += ctl->stride) {
+		bvec = bio_iovec_idx(bio, bio->bi_idx + i);
+		ret = zram_strm_write(ctl->zram, strm, bvec->bv_page,
+				      ctl->index + i);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void zram_write_work(struct work_struct *work)
+{
+	struct zram_strm *strm = container_of(work, struct zram_strm, work);
+	struct zram_write_ctl *ctl = strm->ctl;
+	struct zram *zram = ctl->zram;
+	unsigned int memalloc = current->flags & PF_MEMALLOC;
+	int ret;
+
+	/*
+	 * Swap-out comes from reclaim, which may dip into the reserves
+	 * to store the compressed pages.  So may its helpers, or they
+	 * fail under exactly the memory pressure that causes the write.
+	 */
+	current->flags |= ctl->memalloc;
+	ret = zram_write_stride(ctl, strm, strm->first);
+	current->flags = (current->flags & ~PF_MEMALLOC) | memalloc;
+	if (ret)
+		ctl->ret = ret;
+
+	zram_strm_put(zram, strm);
+	if (atomic_dec_and_test(&ctl->pending))
+		complete(&ctl->done);
+}
+
+/*
+ * Write a bio of whole pages on as many CPUs as there are idle
+ * compression streams, but no more than are online: the caller writes
+ * one share of the pages and hands the others to zram_wq.
+ */
+static int zram_write_pages(struct zram *zram, struct bio *bio, u32 index)
+{
+	int nr_pages = bio->bi_vcnt - bio->bi_idx;
+	struct zram_strm *strm, *next, *mine;
+	struct zram_write_ctl ctl;
+	LIST_HEAD(helpers);
+	int ret;
+
+	ctl.zram = zram;
+	ctl.bio = bio;
+	ctl.index = index;
+	ctl.stride = 1;
+	ctl.memalloc = current->flags & PF_MEMALLOC;
+	ctl.ret = 0;
+	init_completion(&ctl.done);
+
+	mine = zram_strm_get(zram, true);
+	while (ctl.stride < nr_pages && ctl.stride < num_online_cpus()) {
+		strm = zram_strm_get(zram, false);
+		if (!strm)
+			break;
+		strm->ctl = &ctl;
+		strm->first = ctl.stride++;
+		list_add_tail(&strm->list, &helpers);
+	}
+
+	atomic_set(&ctl.pending, ctl.stride - 1);
+	list_for_each_entry_safe(strm, next, &helpers, list) {
+		list_del(&strm->list);
+		queue_work(zram_wq, &strm->work);
+	}
+
+	ret = zram_write_stride(&ctl, mine, 0);
+	zram_strm_put(zram, mine);
+
+	if (ctl.stride > 1) {
+		wait_for_completion(&ctl.done);
+		zram_stat64_add(zram, &zram->stats.parallel_writes, nr_pages);
+	}
+
+	return ret ? ret : ctl.ret;
+}
+
+/* Can zram_write_pages() write @bio? */
+static bool zram_bio_whole_pages(struct zram *zram, struct bio *bio,
+				 int offset)
+{
+	struct bio_vec *bvec;
+	int i;
+
+	if (zram->nr_strm < 2 || offset || bio->bi_vcnt - bio->bi_idx < 2)
+		return false;
+
+	bio_for_each_segment(bvec, bio, i)
+		if (bvec->bv_offset || bvec->bv_len != PAGE_SIZE)
+			return false;
+
+	return true;
+}
+
 static void update_position(u32 *index, int *offset, struct bio_vec *bvec)
 {
 	if (*offset + bvec->bv_len >= PAGE_SIZE)
@@ -493,6 +697,12 @@ static void __zram_make_request(struct zram *zram, struct bio *bio, int rw)
 	index = bio->bi_sector >> SECTORS_PER_PAGE_SHIFT;
 	offset = (bio->bi_sector & (SECTORS_PER_PAGE - 1)) << SECTOR_SHIFT;
 
+	if (rw == WRITE && zram_bio_whole_pages(zram, bio, offset)) {
+		if (zram_write_pages(zram, bio, index) < 0)
+			goto out;
+		goto done;
+	}
+
 	bio_for_each_segment(bvec, bio, i) {
 		int max_transfer_size = PAGE_SIZE - offset;
 
@@ -522,6 +732,7 @@ static void __zram_make_request(struct zram *zram, struct bio *bio, int rw)
 		update_position(&index, &offset, bvec);
 	}
 
+done:
 	set_bit(BIO_UPTODATE, &bio->bi_flags);
 	bio_endio(bio, 0);
 	return;
@@ -577,6 +788,53 @@ error:
 	bio_io_error(bio);
 }
 
+static void zram_free_strms(struct zram *zram)
+{
+	struct zram_strm *strm, *next;
+
+	list_for_each_entry_safe(strm, next, &zram->strm_list, list) {
+		kfree(strm->workmem);
+		free_pages((unsigned long)strm->buffer, 1);
+		kfree(strm);
+	}
+	INIT_LIST_HEAD(&zram->strm_list);
+	zram->nr_strm = 0;
+}
+
+/*
+ * One compression stream per possible CPU, none if there is just one.
+ * CPUs may come and go after the device is set up, so
+ * zram_write_pages() limits itself to the online ones instead.
+ */
+static int zram_alloc_strms(struct zram *zram)
+{
+	struct zram_strm *strm;
+	int i;
+
+	if (nr_cpu_ids < 2)
+		return 0;
+
+	for (i = 0; i < nr_cpu_ids; i++) {
+		strm = kzalloc(sizeof(*strm), GFP_KERNEL);
+		if (!strm)
+			return -ENOMEM;
+		strm->workmem = kzalloc(LZO1X_MEM_COMPRESS, GFP_KERNEL);
+		strm->buffer =
+			(void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 1);
+		if (!strm->workmem || !strm->buffer) {
+			kfree(strm->workmem);
+			free_pages((unsigned long)strm->buffer, 1);
+			kfree(strm);
+			return -ENOMEM;
+		}
+		INIT_WORK(&strm->work, zram_write_work);
+		list_add(&strm->list, &zram->strm_list);
+		zram->nr_strm++;
+	}
+
+	return 0;
+}
+
 void __zram_reset_device(struct zram *zram)
 {
 	size_t index;
@@ -586,6 +844,7 @@ void __zram_reset_device(struct zram *zram)
 	/* Free various per-device buffers */
 	kfree(zram->compress_workmem);
 	free_pages((unsigned long)zram->compress_buffer, 1);
+	zram_free_strms(zram);
 
 	zram->compress_workmem = NULL;
 	zram->compress_buffer = NULL;
@@ -650,6 +909,12 @@ int zram_init_device(struct zram *zram)
 		goto fail_no_table;
 	}
 
+	if (zram_alloc_strms(zram)) {
+		pr_err("Error allocating compression streams\n");
+		ret = -ENOMEM;
+		goto fail_no_table;
+	}
+
 	num_pages = zram->disksize >> PAGE_SHIFT;
 	zram->table = vzalloc(num_pages * sizeof(*zram->table));
 	if (!zram->table) {
@@ -708,6 +973,9 @@ static int create_device(struct zram *zram, int device_id)
 	init_rwsem(&zram->lock);
 	init_rwsem(&zram->init_lock);
 	spin_lock_init(&zram->stat64_lock);
+	INIT_LIST_HEAD(&zram->strm_list);
+	spin_lock_init(&zram->strm_lock);
+	init_waitqueue_head(&zram->strm_wait);
 
 	zram->queue = blk_alloc_queue(GFP_KERNEL);
 	if (!zram->queue) {
@@ -795,11 +1063,17 @@ static int __init zram_init(void)
 		goto out;
 	}
 
+	zram_wq = alloc_workqueue("zram", WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!zram_wq) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	zram_major = register_blkdev(0, "zram");
 	if (zram_major <= 0) {
 		pr_warning("Unable to get major number\n");
 		ret = -EBUSY;
-		goto out;
+		goto destroy_wq;
 	}
 
 	if (!num_devices) {
@@ -829,6 +1103,8 @@ free_devices:
 	kfree(zram_devices);
 unregister:
 	unregister_blkdev(zram_major, "zram");
+destroy_wq:
+	destroy_workqueue(zram_wq);
 out:
 	return ret;
 }
@@ -847,6 +1123,7 @@ static void __exit zram_exit(void)
 	}
 
 	unregister_blkdev(zram_major, "zram");
+	destroy_workqueue(zram_wq);
 
 	kfree(zram_devices);
 	pr_debug("Cleanup done!\n");
@@ -17,6 +17,8 @@
 
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include "../zsmalloc/zsmalloc.h"
 
@@ -95,12 +97,30 @@ struct zram_stats {
 	u64 failed_writes;	/* can happen when memory is too low */
 	u64 invalid_io;		/* non-page-aligned I/O requests */
 	u64 notify_free;	/* no. of swap slot free notifications */
+	u64 parallel_writes;	/* pages compressed by parallel writers */
 	u32 pages_zero;		/* no. of zero filled pages */
 	u32 pages_stored;	/* no. of pages currently stored */
 	u32 good_compress;	/* % of pages with compression ratio<=50% */
 	u32 pages_expand;	/* % of incompressible pages */
 };
 
+struct zram_write_ctl;
+
+/*
+ * A compression stream: working memory to compress pages without
+ * holding zram->lock.  Writes of more than one page spread their
+ * pages over as many streams as they can get, see zram_write_pages().
+ */
+struct zram_strm {
+	struct list_head list;
+	void *workmem;
+	void *buffer;
+	/* set while the stream is handed to a worker */
+	struct work_struct work;
+	struct zram_write_ctl *ctl;
+	int first;
+};
+
 struct zram {
 	struct zs_pool *mem_pool;
 	void *compress_workmem;
@@ -109,6 +129,11 @@ struct zram {
 	spinlock_t stat64_lock;	/* protect 64-bit stats */
 	struct rw_semaphore lock; /* protect compression buffers and table
 				   * against concurrent read and writes */
+	/* Idle compression streams, one per possible CPU */
+	struct list_head strm_list;
+	spinlock_t strm_lock;
+	wait_queue_head_t strm_wait;
+	int nr_strm;
 	struct request_queue *queue;
 	struct gendisk *disk;
 	int init_done;
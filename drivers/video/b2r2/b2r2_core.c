@@ -3110,7 +3110,7 @@ static int __init b2r2_init(void)
 	printk(KERN_INFO "%s\n", __func__);
 	return platform_driver_probe(&platform_b2r2_driver, b2r2_probe);
 }
-module_init(b2r2_init);
+module_init_async(b2r2_init);
 
 /**
  * b2r2_exit() - Module exit function for the B2R2 core module
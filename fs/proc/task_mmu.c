@@ -52,7 +52,10 @@ void task_mem(struct seq_file *m, struct mm_struct *mm)
 		"VmExe:\t%8lu kB\n"
 		"VmLib:\t%8lu kB\n"
 		"VmPTE:\t%8lu kB\n"
-		"VmSwap:\t%8lu kB\n",
+		"VmSwap:\t%8lu kB\n"
+		"SwapIns:\t%8lu\n"
+		"SwapInTime:\t%8llu us\n"
+		"Refaults:\t%8lu\n",
 		hiwater_vm << (PAGE_SHIFT-10),
 		(total_vm - mm->reserved_vm) << (PAGE_SHIFT-10),
 		mm->locked_vm << (PAGE_SHIFT-10),
@@ -62,7 +65,10 @@ void task_mem(struct seq_file *m, struct mm_struct *mm)
 		data << (PAGE_SHIFT-10),
 		mm->stack_vm << (PAGE_SHIFT-10), text, lib,
 		(PTRS_PER_PTE*sizeof(pte_t)*mm->nr_ptes) >> 10,
-		swap << (PAGE_SHIFT-10));
+		swap << (PAGE_SHIFT-10),
+		atomic_long_read(&mm->nr_swapins),
+		(unsigned long long)atomic64_read(&mm->swapin_time),
+		atomic_long_read(&mm->nr_refaults));
 }
 
 unsigned long task_vsize(struct mm_struct *mm)
@@ -521,6 +527,15 @@ static int show_smap(struct seq_file *m, void *v, int is_pid)
 		   (vma->vm_flags & VM_LOCKED) ?
 			(unsigned long)(mss.pss >> (10 + PSS_SHIFT)) : 0);
 
+#ifdef CONFIG_KSM
+	if (vma->vm_flags & VM_MERGEABLE)
+		seq_printf(m,
+			   "KsmScanned:     %8lu kB\n"
+			   "KsmMerged:      %8lu kB\n",
+			   vma->ksm_scanned << (PAGE_SHIFT - 10),
+			   vma->ksm_merged << (PAGE_SHIFT - 10));
+#endif
+
 	if (m->count < m->size)  /* vma is copied successfully */
 		m->version = (vma != get_gate_vma(task->mm))
 			? vma->vm_start : 0;
@@ -633,7 +633,11 @@
 		INIT_CALLS_LEVEL(rootfs)				\
 		INIT_CALLS_LEVEL(6)					\
 		INIT_CALLS_LEVEL(7)					\
-		VMLINUX_SYMBOL(__initcall_end) = .;
+		VMLINUX_SYMBOL(__initcall_end) = .;			\
+		. = ALIGN(8);						\
+		VMLINUX_SYMBOL(__initcall_async_start) = .;		\
+		*(.initcall_async.init)					\
+		VMLINUX_SYMBOL(__initcall_async_end) = .;
 
 #define CON_INITCALL							\
 		VMLINUX_SYMBOL(__con_initcall_start) = .;		\
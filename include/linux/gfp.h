@@ -366,7 +366,7 @@ extern void free_hot_cold_page_list(struct list_head *list, int cold);
 #define free_page(addr) free_pages((addr), 0)
 
 void page_alloc_init(void);
-void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp);
+void drain_zone_pages(struct zone *zone, struct per_cpu_pageset *pset);
 void drain_all_pages(void);
 void drain_local_pages(void *dummy);
 
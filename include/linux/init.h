@@ -212,6 +212,45 @@ extern bool initcall_debug;
 
 #define __initcall(fn) device_initcall(fn)
 
+/*
+ * Async initcalls are run through kernel/async.c, in parallel with the
+ * rest of their level; the next level still waits for them.  Nothing
+ * later in the level may rely on them, except other async initcalls
+ * which list their names as dependencies: those wait for them to
+ * return.  Only async initcalls earlier in link order can be waited
+ * for; plain initcalls which come earlier have always returned already.
+ *
+ * Booting with async_initcalls=0 runs them in order, like all others.
+ */
+struct async_initcall {
+	initcall_t	*call;		/* entry in the initcall table */
+	const char	*name;
+	const char	**deps;		/* names of initcalls it waits for */
+	int		nr_deps;
+};
+
+#define __define_initcall_async(level,fn,id,...)			\
+	__define_initcall(level,fn,id);					\
+	static const char *__initcall_deps_##fn##id[] __initdata =	\
+		{ __VA_ARGS__ };					\
+	static struct async_initcall __async_initcall_##fn##id __used	\
+	__attribute__((__section__(".initcall_async.init"))) = {	\
+		.call	 = &__initcall_##fn##id,			\
+		.name	 = #fn,						\
+		.deps	 = __initcall_deps_##fn##id,			\
+		.nr_deps = sizeof(__initcall_deps_##fn##id) /		\
+			   sizeof(__initcall_deps_##fn##id[0]),		\
+	}
+
+#define subsys_initcall_async(fn, ...)	\
+	__define_initcall_async("4",fn,4,##__VA_ARGS__)
+#define fs_initcall_async(fn, ...)	\
+	__define_initcall_async("5",fn,5,##__VA_ARGS__)
+#define device_initcall_async(fn, ...)	\
+	__define_initcall_async("6",fn,6,##__VA_ARGS__)
+#define late_initcall_async(fn, ...)	\
+	__define_initcall_async("7",fn,7,##__VA_ARGS__)
+
 #define __exitcall(fn) \
 	static exitcall_t __exitcall_##fn __exit_call = fn
 
@@ -266,6 +305,16 @@ void __init parse_early_options(char *cmdline);
  */
 #define module_init(x)	__initcall(x);
 
+/**
+ * module_init_async() - driver initialization entry point, run async
+ * @x: function to be run at kernel boot time or module insertion
+ * @...: names of async initcalls @x has to wait for
+ *
+ * Like module_init(), but if builtin, @x is run in parallel with other
+ * initcalls, see device_initcall_async().
+ */
+#define module_init_async(x, ...)	device_initcall_async(x, ##__VA_ARGS__);
+
 /**
  * module_exit() - driver exit entry point
  * @x: function to be run when driver is removed
@@ -292,6 +341,12 @@ void __init parse_early_options(char *cmdline);
 
 #define security_initcall(fn)		module_init(fn)
 
+#define subsys_initcall_async(fn, ...)	module_init(fn)
+#define fs_initcall_async(fn, ...)	module_init(fn)
+#define device_initcall_async(fn, ...)	module_init(fn)
+#define late_initcall_async(fn, ...)	module_init(fn)
+#define module_init_async(fn, ...)	module_init(fn)
+
 /* Each module must use one module_init(). */
 #define module_init(initfn)					\
 	static inline initcall_t __inittest(void)		\
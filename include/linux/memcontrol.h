@@ -32,6 +32,11 @@ enum mem_cgroup_page_stat_item {
 	MEMCG_NR_FILE_MAPPED, /* # of pages charged as file rss */
 };
 
+enum mem_cgroup_page_event_item {
+	MEMCG_PSWPOUT,		/* # of pages written to swap */
+	MEMCG_WORKINGSET_REFAULT, /* # of refaults of evicted file pages */
+};
+
 struct mem_cgroup_reclaim_cookie {
 	struct zone *zone;
 	int priority;
@@ -191,6 +196,9 @@ unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 u64 mem_cgroup_get_limit(struct mem_cgroup *memcg);
 
 void mem_cgroup_count_vm_event(struct mm_struct *mm, enum vm_event_item idx);
+void mem_cgroup_count_page_event(struct page *page,
+				 enum mem_cgroup_page_event_item idx);
+void mem_cgroup_count_swapin(struct mm_struct *mm, unsigned long usecs);
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 void mem_cgroup_split_huge_fixup(struct page *head);
 #endif
@@ -411,6 +419,16 @@ static inline
 void mem_cgroup_count_vm_event(struct mm_struct *mm, enum vm_event_item idx)
 {
 }
+
+static inline void mem_cgroup_count_page_event(struct page *page,
+				enum mem_cgroup_page_event_item idx)
+{
+}
+
+static inline
+void mem_cgroup_count_swapin(struct mm_struct *mm, unsigned long usecs)
+{
+}
 static inline void mem_cgroup_replace_page_cache(struct page *oldpage,
 				struct page *newpage)
 {
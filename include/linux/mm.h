@@ -1447,6 +1447,18 @@ unsigned long ra_submit(struct file_ra_state *ra,
 			struct address_space *mapping,
 			struct file *filp);
 
+#ifdef CONFIG_LAUNCH_READAHEAD
+extern int sysctl_launch_readahead_secs;
+void launch_readahead_fault(struct vm_area_struct *vma, struct file *file,
+			    pgoff_t offset, bool major);
+#else
+static inline void launch_readahead_fault(struct vm_area_struct *vma,
+					  struct file *file, pgoff_t offset,
+					  bool major)
+{
+}
+#endif
+
 /* Generic expand stack which grows the stack according to GROWS{UP,DOWN} */
 extern int expand_stack(struct vm_area_struct *vma, unsigned long address);
 
@@ -262,6 +262,10 @@ struct vm_area_struct {
 #ifdef CONFIG_NUMA
 	struct mempolicy *vm_policy;	/* NUMA policy for the VMA */
 #endif
+#ifdef CONFIG_KSM
+	unsigned long ksm_scanned;	/* pages ksmd has looked at */
+	unsigned long ksm_merged;	/* pages ksmd has merged */
+#endif
 };
 
 struct core_thread {
@@ -398,6 +402,13 @@ struct mm_struct {
 #ifdef CONFIG_CPUMASK_OFFSTACK
 	struct cpumask cpumask_allocation;
 #endif
+#ifdef CONFIG_LAUNCH_READAHEAD
+	unsigned long launch_start;	/* jiffies when the mm was created */
+#endif
+	/* Faults that had to wait for swap or for an evicted file page */
+	atomic_long_t nr_swapins;
+	atomic64_t swapin_time;		/* usecs waited for swap-ins */
+	atomic_long_t nr_refaults;
 };
 
 static inline void mm_init_cpumask(struct mm_struct *mm)
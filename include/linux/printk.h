@@ -105,6 +105,8 @@ int printk(const char *fmt, ...);
  */
 __printf(1, 2) __cold int printk_sched(const char *fmt, ...);
 
+extern void printk_force_sync(void);
+
 /*
  * Please don't use printk_ratelimit(), because it shares ratelimiting state
  * with all other unrelated printk_ratelimit() callsites.  Instead use
@@ -137,6 +139,9 @@ int printk_sched(const char *s, ...)
 {
 	return 0;
 }
+static inline void printk_force_sync(void)
+{
+}
 static inline int printk_ratelimit(void)
 {
 	return 0;
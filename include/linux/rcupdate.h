@@ -69,6 +69,15 @@ extern void do_trace_rcu_torture_read(char *rcutorturename,
 #endif
 #endif
 
+#ifdef CONFIG_RCU_NOCB_CPU
+extern bool rcu_nocb_enable(bool enable);
+#else /* #ifdef CONFIG_RCU_NOCB_CPU */
+static inline bool rcu_nocb_enable(bool enable)
+{
+	return false;
+}
+#endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
+
 #define UINT_CMP_GE(a, b)	(UINT_MAX / 2 >= (a) - (b))
 #define UINT_CMP_LT(a, b)	(UINT_MAX / 2 < (a) - (b))
 #define ULONG_CMP_GE(a, b)	(ULONG_MAX / 2 >= (a) - (b))
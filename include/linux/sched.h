@@ -1209,6 +1209,17 @@ struct sched_statistics {
 };
 #endif
 
+/*
+ * Decayed runnable average of a sched_entity or a cpu: the time it was
+ * runnable, and the time it was tracked, in ~1us units, with each 1ms
+ * period in the past weighted y times less than the next, y^32 = 0.5.
+ */
+struct sched_avg {
+	u32 runnable_avg_sum, runnable_avg_period;
+	u64 last_runnable_update;
+	unsigned long load_avg_contrib;
+};
+
 struct sched_entity {
 	struct load_weight	load;		/* for load-balancing */
 	struct rb_node		run_node;
@@ -1233,6 +1244,11 @@ struct sched_entity {
 	/* rq "owned" by this entity/group: */
 	struct cfs_rq		*my_q;
 #endif
+
+#ifdef CONFIG_SMP
+	/* load of this entity, as used by load balancing */
+	struct sched_avg	avg;
+#endif
 };
 
 struct sched_rt_entity {
@@ -33,7 +33,7 @@
  */
 
 
-#define TASKSTATS_VERSION	8
+#define TASKSTATS_VERSION	9
 #define TS_COMM_LEN		32	/* should be >= TASK_COMM_LEN
 					 * in linux/sched.h */
 
@@ -163,6 +163,15 @@ struct taskstats {
 	/* Delay waiting for memory reclaim */
 	__u64	freepages_count;
 	__u64	freepages_delay_total;
+
+	/* version 8 ends here */
+
+	/* Current memory usage, in KB */
+	__u64	cur_rss;		/* RSS usage */
+	__u64	cur_vm;			/* Virtual memory usage */
+
+	__u32	ac_tgid;		/* Thread group ID */
+	__u32	ac_pad2;
 };
 
 
@@ -200,6 +209,7 @@ enum {
 	TASKSTATS_CMD_ATTR_TGID,
 	TASKSTATS_CMD_ATTR_REGISTER_CPUMASK,
 	TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK,
+	TASKSTATS_CMD_ATTR_CGROUP_FD,	/* restrict a dump to a cgroup */
 	__TASKSTATS_CMD_ATTR_MAX,
 };
 
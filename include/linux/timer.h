@@ -229,6 +229,15 @@ extern void set_timer_slack(struct timer_list *time, int slack_hz);
  */
 extern unsigned long get_next_timer_interrupt(unsigned long now);
 
+#ifdef CONFIG_NO_HZ
+/*
+ * Timers with slack are expired on a multiple of this many usecs,
+ * 0 disables coalescing:
+ */
+extern unsigned int sysctl_timer_coalesce_us;
+#define TIMER_COALESCE_US_MAX	1000000
+#endif
+
 /*
  * Timer-statistics info:
  */
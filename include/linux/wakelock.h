@@ -26,6 +26,9 @@
  * interrupts will not entered from idle until the wake_locks are released.
  */
 
+/* Hold time histogram buckets: < 1ms, then powers of two up to >= 16s */
+#define WAKE_LOCK_HIST_BUCKETS	16
+
 enum {
 	WAKE_LOCK_SUSPEND, /* Prevent suspend */
 	WAKE_LOCK_IDLE,    /* Prevent low power idle */
@@ -47,6 +50,7 @@ struct wake_lock {
 		ktime_t         prevent_suspend_time;
 		ktime_t         max_time;
 		ktime_t         last_time;
+		unsigned int    hist[WAKE_LOCK_HIST_BUCKETS];
 	} stat;
 #endif
 #endif
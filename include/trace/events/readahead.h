@@ -0,0 +1,66 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM readahead
+
+#if !defined(_TRACE_READAHEAD_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_READAHEAD_H
+
+#include <linux/fs.h>
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(mm_launch_fault,
+
+	TP_PROTO(struct inode *inode, pgoff_t index, bool major),
+
+	TP_ARGS(inode, index, major),
+
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(unsigned long, ino)
+		__field(pgoff_t, index)
+		__field(bool, major)
+	),
+
+	TP_fast_assign(
+		__entry->dev = inode->i_sb->s_dev;
+		__entry->ino = inode->i_ino;
+		__entry->index = index;
+		__entry->major = major;
+	),
+
+	TP_printk("dev=%d:%d ino=%lu index=%lu %s",
+		MAJOR(__entry->dev), MINOR(__entry->dev),
+		__entry->ino, __entry->index,
+		__entry->major ? "major" : "minor")
+);
+
+TRACE_EVENT(mm_launch_readahead,
+
+	TP_PROTO(struct inode *inode, unsigned int nr_extents,
+		unsigned long nr_pages),
+
+	TP_ARGS(inode, nr_extents, nr_pages),
+
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(unsigned long, ino)
+		__field(unsigned int, nr_extents)
+		__field(unsigned long, nr_pages)
+	),
+
+	TP_fast_assign(
+		__entry->dev = inode->i_sb->s_dev;
+		__entry->ino = inode->i_ino;
+		__entry->nr_extents = nr_extents;
+		__entry->nr_pages = nr_pages;
+	),
+
+	TP_printk("dev=%d:%d ino=%lu nr_extents=%u nr_pages=%lu",
+		MAJOR(__entry->dev), MINOR(__entry->dev),
+		__entry->ino, __entry->nr_extents, __entry->nr_pages)
+);
+
+#endif /* _TRACE_READAHEAD_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
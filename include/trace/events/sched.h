@@ -426,6 +426,70 @@ TRACE_EVENT(sched_pi_setprio,
 			__entry->oldprio, __entry->newprio)
 );
 
+#ifdef CONFIG_SMP
+/*
+ * Tracepoint for the decayed runnable average of a task, updated about
+ * once per ms while it runs and whenever it is enqueued or dequeued.
+ */
+TRACE_EVENT(sched_load_avg_task,
+
+	TP_PROTO(struct task_struct *tsk, struct sched_avg *avg),
+
+	TP_ARGS(tsk, avg),
+
+	TP_STRUCT__entry(
+		__array( char,	comm,	TASK_COMM_LEN	)
+		__field( pid_t,	pid			)
+		__field( int,	cpu			)
+		__field( u32,	runnable_avg_sum	)
+		__field( u32,	runnable_avg_period	)
+		__field( unsigned long,	load_avg_contrib	)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->comm, tsk->comm, TASK_COMM_LEN);
+		__entry->pid			= tsk->pid;
+		__entry->cpu			= task_cpu(tsk);
+		__entry->runnable_avg_sum	= avg->runnable_avg_sum;
+		__entry->runnable_avg_period	= avg->runnable_avg_period;
+		__entry->load_avg_contrib	= avg->load_avg_contrib;
+	),
+
+	TP_printk("comm=%s pid=%d cpu=%d sum=%u period=%u load=%lu",
+			__entry->comm, __entry->pid, __entry->cpu,
+			__entry->runnable_avg_sum, __entry->runnable_avg_period,
+			__entry->load_avg_contrib)
+);
+
+/*
+ * Tracepoint for the utilization of a cpu: the decayed fraction of time
+ * it had runnable tasks, scaled to 1024, and the load of its CFS tasks.
+ * cpufreq governors can attach to this to follow per cpu utilization.
+ */
+TRACE_EVENT(sched_load_avg_cpu,
+
+	TP_PROTO(int cpu, struct sched_avg *avg, unsigned long load),
+
+	TP_ARGS(cpu, avg, load),
+
+	TP_STRUCT__entry(
+		__field( int,		cpu		)
+		__field( u32,		util		)
+		__field( unsigned long,	load		)
+	),
+
+	TP_fast_assign(
+		__entry->cpu	= cpu;
+		__entry->util	= (avg->runnable_avg_sum << 10) /
+				  (avg->runnable_avg_period + 1);
+		__entry->load	= load;
+	),
+
+	TP_printk("cpu=%d util=%u load=%lu",
+			__entry->cpu, __entry->util, __entry->load)
+);
+#endif /* CONFIG_SMP */
+
 #endif /* _TRACE_SCHED_H */
 
 /* This part must be outside protection */
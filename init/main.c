@@ -663,8 +663,6 @@ static void __init do_ctors(void)
 bool initcall_debug;
 core_param(initcall_debug, initcall_debug, bool, 0644);
 
-static char msgbuf[64];
-
 static int __init_or_module do_one_initcall_debug(initcall_t fn)
 {
 	ktime_t calltime, delta, rettime;
@@ -686,6 +684,7 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	char msgbuf[64];
 	int ret;
 
 	boottime_mark_symbolic(fn);
@@ -726,6 +725,7 @@ extern initcall_t __initcall5_start[];
 extern initcall_t __initcall6_start[];
 extern initcall_t __initcall7_start[];
 extern initcall_t __initcall_end[];
+extern struct async_initcall __initcall_async_start[], __initcall_async_end[];
 
 static initcall_t *initcall_levels[] __initdata = {
 	__initcall0_start,
@@ -750,10 +750,126 @@ static char *initcall_level_names[] __initdata = {
 	"late parameters",
 };
 
+static bool async_initcalls = true;
+core_param(async_initcalls, async_initcalls, bool, 0444);
+
+/*
+ * What became of every initcall from level 0 on.  pred is the initcall
+ * which held it up last, on the init task or, for an async one, through
+ * a dependency; following it back from the initcall which returned last
+ * gives the critical path through all levels.
+ */
+struct initcall_record {
+	struct async_initcall *async;
+	ktime_t		queued;
+	ktime_t		start;
+	ktime_t		end;
+	int		pred;
+	bool		done;
+};
+
+static struct initcall_record *initcall_records __initdata;
+static int initcall_last __initdata = -1;
+static DECLARE_WAIT_QUEUE_HEAD(initcall_wq);
+static LIST_HEAD(initcall_domain);
+
+static int __init initcall_index(initcall_t *fn)
+{
+	return fn - __initcall0_start;
+}
+
+static void __init init_initcall_records(void)
+{
+	int nr = initcall_index(__initcall_end);
+	struct async_initcall *a;
+	int i;
+
+	initcall_records = kcalloc(nr, sizeof(*initcall_records), GFP_KERNEL);
+	if (!initcall_records) {
+		pr_warn("initcalls: no memory, running all of them in order\n");
+		return;
+	}
+
+	for (a = __initcall_async_start; a < __initcall_async_end; a++) {
+		i = initcall_index(a->call);
+		if (i >= 0 && i < nr)
+			initcall_records[i].async = a;
+	}
+}
+
+static struct initcall_record * __init find_async_initcall(const char *name)
+{
+	struct async_initcall *a;
+
+	for (a = __initcall_async_start; a < __initcall_async_end; a++)
+		if (!strcmp(a->name, name))
+			return &initcall_records[initcall_index(a->call)];
+	return NULL;
+}
+
+static void __init do_one_initcall_async(void *data, async_cookie_t cookie)
+{
+	struct initcall_record *r = data, *dep;
+	const char *name = r->async->name;
+	int i;
+
+	for (i = 0; i < r->async->nr_deps; i++) {
+		/* plain initcalls which come earlier returned already */
+		dep = find_async_initcall(r->async->deps[i]);
+		if (!dep)
+			continue;
+		if (dep >= r) {
+			pr_warn("initcall %s: %s comes later, not waiting for it\n",
+				name, r->async->deps[i]);
+			continue;
+		}
+		wait_event(initcall_wq, dep->done);
+		smp_rmb();	/* dep->end */
+		/* held up by the dependency rather than the init task? */
+		if (dep->end.tv64 > r->queued.tv64 &&
+		    (r->pred < 0 ||
+		     dep->end.tv64 > initcall_records[r->pred].end.tv64))
+			r->pred = dep - initcall_records;
+	}
+
+	r->start = ktime_get();
+	do_one_initcall(*r->async->call);
+	r->end = ktime_get();
+
+	smp_wmb();	/* r->end before r->done */
+	r->done = true;
+	wake_up_all(&initcall_wq);
+}
+
+static void __init do_initcall(initcall_t *fn)
+{
+	struct initcall_record *r;
+
+	if (!initcall_records) {
+		do_one_initcall(*fn);
+		return;
+	}
+
+	r = &initcall_records[initcall_index(fn)];
+	r->pred = initcall_last;
+	if (r->async && async_initcalls) {
+		r->queued = ktime_get();
+		async_schedule_domain(do_one_initcall_async, r, &initcall_domain);
+		return;
+	}
+
+	r->start = ktime_get();
+	do_one_initcall(*fn);
+	r->end = ktime_get();
+	r->done = true;
+	initcall_last = r - initcall_records;
+}
+
 static void __init do_initcall_level(int level)
 {
 	extern const struct kernel_param __start___param[], __stop___param[];
 	initcall_t *fn;
+	int i;
 
 	strcpy(static_command_line, saved_command_line);
 	parse_args(initcall_level_names[level],
@@ -763,15 +879,84 @@ static void __init do_initcall_level(int level)
 		   repair_env_string);
 
 	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
-		do_one_initcall(*fn);
+		do_initcall(fn);
+
+	/* The next level may depend on anything of this one */
+	async_synchronize_full_domain(&initcall_domain);
+	if (!initcall_records)
+		return;
+	for (i = initcall_index(initcall_levels[level]);
+	     i < initcall_index(initcall_levels[level+1]); i++)
+		if (initcall_last < 0 || initcall_records[i].end.tv64 >
+					initcall_records[initcall_last].end.tv64)
+			initcall_last = i;
+}
+
+static s64 __init initcall_us(int i)
+{
+	return ktime_us_delta(initcall_records[i].end,
+			      initcall_records[i].start);
+}
+
+static const char * __init initcall_async_tag(int i)
+{
+	return initcall_records[i].queued.tv64 ? " async" : "";
+}
+
+/*
+ * With initcall_debug, sum up where do_initcalls() spent its time: the
+ * slowest initcalls, and the chain of initcalls, each one held up by
+ * the one before, which ended with the last one to return.
+ */
+static void __init initcall_report(ktime_t calltime)
+{
+	int nr = initcall_index(__initcall_end);
+	s64 total = 0, path = 0;
+	int top[10], n = 0;
+	int i, j;
+
+	for (i = 0; i < nr; i++)
+		total += initcall_us(i);
+	printk(KERN_DEBUG "initcalls: %lld usecs, %lld usecs spent in initcalls\n",
+	       ktime_us_delta(ktime_get(), calltime), total);
+
+	printk(KERN_DEBUG "initcalls: critical path, last first:\n");
+	for (i = initcall_last; i >= 0; i = initcall_records[i].pred) {
+		path += initcall_us(i);
+		printk(KERN_DEBUG "  %pF %lld usecs%s\n", __initcall0_start[i],
+		       initcall_us(i), initcall_async_tag(i));
+	}
+	printk(KERN_DEBUG "initcalls: %lld usecs on the critical path\n", path);
+
+	for (i = 0; i < nr; i++) {
+		for (j = n; j > 0 && initcall_us(i) > initcall_us(top[j-1]); j--)
+			if (j < ARRAY_SIZE(top))
+				top[j] = top[j-1];
+		if (j < ARRAY_SIZE(top)) {
+			top[j] = i;
+			n = min_t(int, n + 1, ARRAY_SIZE(top));
+		}
+	}
+	printk(KERN_DEBUG "initcalls: slowest:\n");
+	for (j = 0; j < n; j++)
+		printk(KERN_DEBUG "  %pF %lld usecs%s\n", __initcall0_start[top[j]],
+		       initcall_us(top[j]), initcall_async_tag(top[j]));
 }
 
 static void __init do_initcalls(void)
 {
+	ktime_t calltime = ktime_get();
 	int level;
 
+	init_initcall_records();
+
 	for (level = 0; level < ARRAY_SIZE(initcall_levels) - 1; level++)
 		do_initcall_level(level);
+
+	if (initcall_debug && initcall_records)
+		initcall_report(calltime);
+	kfree(initcall_records);
+	initcall_records = NULL;
 }
 
 /*
@@ -3252,6 +3252,44 @@ err:
 	return ret;
 }
 
+/**
+ * cgroupstats_has_task - check whether a task is attached to a cgroup
+ * @dentry: A dentry entry belonging to the cgroup
+ * @tsk: the task in question
+ *
+ * Returns 1 if @tsk is attached to the cgroup of @dentry, 0 if it isn't
+ * and -EINVAL if @dentry is not a cgroup directory.  Doesn't sleep or
+ * take cgroup_mutex, so that taskstats can filter the tasks it dumps
+ * under rcu_read_lock().
+ */
+int cgroupstats_has_task(struct dentry *dentry, struct task_struct *tsk)
+{
+	struct cg_cgroup_link *link;
+	struct cgroup *cgrp;
+	struct css_set *cg;
+	int ret = 0;
+
+	if (dentry->d_sb->s_op != &cgroup_ops ||
+	    !S_ISDIR(dentry->d_inode->i_mode))
+		return -EINVAL;
+
+	cgrp = dentry->d_fsdata;
+
+	rcu_read_lock();
+	read_lock(&css_set_lock);
+	cg = rcu_dereference(tsk->cgroups);
+	list_for_each_entry(link, &cg->cg_links, cg_link_list) {
+		if (link->cgrp == cgrp) {
+			ret = 1;
+			break;
+		}
+	}
+	read_unlock(&css_set_lock);
+	rcu_read_unlock();
+
+	return ret;
+}
+
 
 /*
  * seq_file methods for the tasks/procs files. The seq_file position is the
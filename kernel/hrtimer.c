@@ -950,6 +950,34 @@ remove_hrtimer(struct hrtimer *timer, struct hrtimer_clock_base *base)
 	return 0;
 }
 
+#ifdef CONFIG_NO_HZ
+/*
+ * Pull the hard expiry of a timer with slack back to the last multiple
+ * of the coalescing window inside [tim, tim + delta_ns], so that timers
+ * with overlapping ranges on all CPUs expire at the same time and share
+ * a single wakeup.  Returns the new delta.
+ */
+static unsigned long hrtimer_coalesce(ktime_t tim, unsigned long delta_ns)
+{
+	u64 hard;
+	u32 rem;
+
+	if (!sysctl_timer_coalesce_us || !delta_ns)
+		return delta_ns;
+
+	hard = ktime_to_ns(ktime_add_ns(tim, delta_ns));
+	rem = do_div(hard, sysctl_timer_coalesce_us * NSEC_PER_USEC);
+
+	return rem <= delta_ns ? delta_ns - rem : delta_ns;
+}
+#else
+static inline unsigned long hrtimer_coalesce(ktime_t tim,
+					     unsigned long delta_ns)
+{
+	return delta_ns;
+}
+#endif
+
 int __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 		unsigned long delta_ns, const enum hrtimer_mode mode,
 		int wakeup)
@@ -980,6 +1008,7 @@ int __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 #endif
 	}
 
+	delta_ns = hrtimer_coalesce(tim, delta_ns);
 	hrtimer_set_expires_range_ns(timer, tim, delta_ns);
 
 	timer_stats_hrtimer_set_start_info(timer);
@@ -7,12 +7,16 @@
  */
 
 #include <linux/irq.h>
+#include <linux/kernel_stat.h>
 #include <linux/module.h>
 #include <linux/interrupt.h>
 #include <linux/syscore_ops.h>
 
 #include "internals.h"
 
+/* Set when check_wakeup_irqs() took a snapshot of the wakeup irq counts */
+static bool wakeup_irqs_armed;
+
 /**
  * suspend_device_irqs - disable all currently enabled interrupt lines
  *
@@ -81,6 +85,37 @@ static int __init irq_pm_init_ops(void)
 
 device_initcall(irq_pm_init_ops);
 
+/*
+ * Attribute the resume to the wakeup interrupts which fired since
+ * check_wakeup_irqs().  The level and fasteoi flow handlers account an
+ * interrupt in kstat_irqs even while the line is still disabled for
+ * suspend, but the edge handlers only mark it IRQS_PENDING for the
+ * resend.  check_wakeup_irqs() refuses to suspend with a wakeup
+ * interrupt pending, so a pending one must have fired since.
+ */
+static void account_wakeup_irqs(void)
+{
+	struct irq_desc *desc;
+	int irq;
+
+	if (!wakeup_irqs_armed)
+		return;
+	wakeup_irqs_armed = false;
+
+	for_each_irq_desc(irq, desc) {
+		if (!irqd_is_wakeup_set(&desc->irq_data))
+			continue;
+		if (kstat_irqs(irq) == desc->wakeup_kstat &&
+		    !(desc->istate & IRQS_PENDING))
+			continue;
+
+		desc->wakeups++;
+		pr_info("Resume caused by IRQ %d %s\n", irq,
+			desc->action && desc->action->name ?
+			desc->action->name : "");
+	}
+}
+
 /**
  * resume_device_irqs - enable interrupt lines disabled by suspend_device_irqs()
  *
@@ -90,6 +125,7 @@ device_initcall(irq_pm_init_ops);
  */
 void resume_device_irqs(void)
 {
+	account_wakeup_irqs();
 	resume_irqs(false);
 }
 EXPORT_SYMBOL_GPL(resume_device_irqs);
@@ -111,6 +147,7 @@ int check_wakeup_irqs(void)
 					desc->action->name : "");
 				return -EBUSY;
 			}
+			desc->wakeup_kstat = kstat_irqs(irq);
 			continue;
 		}
 		/*
@@ -125,6 +162,7 @@ int check_wakeup_irqs(void)
 		    irq_desc_get_chip(desc)->flags & IRQCHIP_MASK_ON_SUSPEND)
 			mask_irq(desc);
 	}
+	wakeup_irqs_armed = true;
 
 	return 0;
 }
@@ -266,6 +266,28 @@ static const struct file_operations irq_spurious_proc_fops = {
 	.release	= single_release,
 };
 
+#ifdef CONFIG_PM_SLEEP
+static int irq_wakeups_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long) m->private);
+
+	seq_printf(m, "%u\n", desc->wakeups);
+	return 0;
+}
+
+static int irq_wakeups_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_wakeups_proc_show, PDE(inode)->data);
+}
+
+static const struct file_operations irq_wakeups_proc_fops = {
+	.open		= irq_wakeups_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
 #define MAX_NAMELEN 128
 
 static int name_unique(unsigned int irq, struct irqaction *new_action)
@@ -341,6 +363,12 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 
 	proc_create_data("spurious", 0444, desc->dir,
 			 &irq_spurious_proc_fops, (void *)(long)irq);
+
+#ifdef CONFIG_PM_SLEEP
+	/* create /proc/irq/<irq>/wakeups */
+	proc_create_data("wakeups", 0444, desc->dir,
+			 &irq_wakeups_proc_fops, (void *)(long)irq);
+#endif
 }
 
 void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
@@ -356,6 +384,9 @@ void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
 	remove_proc_entry("node", desc->dir);
 #endif
 	remove_proc_entry("spurious", desc->dir);
+#ifdef CONFIG_PM_SLEEP
+	remove_proc_entry("wakeups", desc->dir);
+#endif
 
 	memset(name, 0, MAX_NAMELEN);
 	sprintf(name, "%u", irq);
@@ -83,6 +83,22 @@ int get_expired_time(struct wake_lock *lock, ktime_t *expire_time)
 }
 
 
+/* Time from start to end, clamped to 0 as now is sampled outside list_lock */
+static ktime_t stat_delta(ktime_t end, ktime_t start)
+{
+	ktime_t delta = ktime_sub(end, start);
+
+	return delta.tv64 < 0 ? ktime_set(0, 0) : delta;
+}
+
+static void wake_lock_hist_add(struct wake_lock *lock, ktime_t duration)
+{
+	s64 ms = ktime_to_ms(duration);
+	int bucket = ms > 0 ? fls64(ms) : 0;
+
+	lock->stat.hist[min(bucket, WAKE_LOCK_HIST_BUCKETS - 1)]++;
+}
+
 static int print_lock_stat(struct seq_file *m, struct wake_lock *lock)
 {
 	int lock_count = lock->stat.count;
@@ -141,45 +157,80 @@ static int wakelock_stats_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
-static void wake_unlock_stat_locked(struct wake_lock *lock, int expired)
+static int wakelock_hist_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+	struct wake_lock *lock;
+	int type, i;
+
+	seq_puts(m, "name\t<1ms");
+	for (i = 1; i < WAKE_LOCK_HIST_BUCKETS; i++)
+		seq_printf(m, "\t%ums", 1U << (i - 1));
+	seq_putc(m, '\n');
+
+	spin_lock_irqsave(&list_lock, irqflags);
+	list_for_each_entry(lock, &inactive_locks, link) {
+		seq_printf(m, "\"%s\"", lock->name);
+		for (i = 0; i < WAKE_LOCK_HIST_BUCKETS; i++)
+			seq_printf(m, "\t%u", lock->stat.hist[i]);
+		seq_putc(m, '\n');
+	}
+	for (type = 0; type < WAKE_LOCK_TYPE_COUNT; type++) {
+		list_for_each_entry(lock, &active_wake_locks[type], link) {
+			seq_printf(m, "\"%s\"", lock->name);
+			for (i = 0; i < WAKE_LOCK_HIST_BUCKETS; i++)
+				seq_printf(m, "\t%u", lock->stat.hist[i]);
+			seq_putc(m, '\n');
+		}
+	}
+	spin_unlock_irqrestore(&list_lock, irqflags);
+	return 0;
+}
+
+/*
+ * now is sampled by the caller before taking list_lock, to keep the
+ * clock read out of the critical section.
+ */
+static void wake_unlock_stat_locked(struct wake_lock *lock, int expired,
+				    ktime_t now)
 {
 	ktime_t duration;
-	ktime_t now;
+	ktime_t end;
 	if (!(lock->flags & WAKE_LOCK_ACTIVE))
 		return;
-	if (get_expired_time(lock, &now))
+	if (get_expired_time(lock, &end))
 		expired = 1;
 	else
-		now = ktime_get();
+		end = now;
 	lock->stat.count++;
 	if (expired)
 		lock->stat.expire_count++;
-	duration = ktime_sub(now, lock->stat.last_time);
+	duration = stat_delta(end, lock->stat.last_time);
 	lock->stat.total_time = ktime_add(lock->stat.total_time, duration);
 	if (ktime_to_ns(duration) > ktime_to_ns(lock->stat.max_time))
 		lock->stat.max_time = duration;
-	lock->stat.last_time = ktime_get();
+	wake_lock_hist_add(lock, duration);
+	lock->stat.last_time = now;
 	if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
-		duration = ktime_sub(now, last_sleep_time_update);
+		duration = stat_delta(end, last_sleep_time_update);
 		lock->stat.prevent_suspend_time = ktime_add(
 			lock->stat.prevent_suspend_time, duration);
 		lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
 	}
 }
 
-static void update_sleep_wait_stats_locked(int done)
+static void update_sleep_wait_stats_locked(int done, ktime_t now)
 {
 	struct wake_lock *lock;
-	ktime_t now, etime, elapsed, add;
+	ktime_t etime, elapsed, add;
 	int expired;
 
-	now = ktime_get();
-	elapsed = ktime_sub(now, last_sleep_time_update);
+	elapsed = stat_delta(now, last_sleep_time_update);
 	list_for_each_entry(lock, &active_wake_locks[WAKE_LOCK_SUSPEND], link) {
 		expired = get_expired_time(lock, &etime);
 		if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
 			if (expired)
-				add = ktime_sub(etime, last_sleep_time_update);
+				add = stat_delta(etime, last_sleep_time_update);
 			else
 				add = elapsed;
 			lock->stat.prevent_suspend_time = ktime_add(
@@ -190,7 +241,8 @@ static void update_sleep_wait_stats_locked(int done)
 		else
 			lock->flags |= WAKE_LOCK_PREVENTING_SUSPEND;
 	}
-	last_sleep_time_update = now;
+	if (now.tv64 > last_sleep_time_update.tv64)
+		last_sleep_time_update = now;
 }
 #endif
 
@@ -198,7 +250,7 @@ static void update_sleep_wait_stats_locked(int done)
 static void expire_wake_lock(struct wake_lock *lock)
 {
 #ifdef CONFIG_WAKELOCK_STAT
-	wake_unlock_stat_locked(lock, 1);
+	wake_unlock_stat_locked(lock, 1, ktime_get());
 #endif
 	lock->flags &= ~(WAKE_LOCK_ACTIVE | WAKE_LOCK_AUTO_EXPIRE);
 	list_del(&lock->link);
@@ -375,6 +427,7 @@ void wake_lock_init(struct wake_lock *lock, int type, const char *name)
 	lock->stat.prevent_suspend_time = ktime_set(0, 0);
 	lock->stat.max_time = ktime_set(0, 0);
 	lock->stat.last_time = ktime_set(0, 0);
+	memset(lock->stat.hist, 0, sizeof(lock->stat.hist));
 #endif
 	lock->flags = (type & WAKE_LOCK_TYPE_MASK) | WAKE_LOCK_INITIALIZED;
 
@@ -388,6 +441,9 @@ EXPORT_SYMBOL(wake_lock_init);
 void wake_lock_destroy(struct wake_lock *lock)
 {
 	unsigned long irqflags;
+#ifdef CONFIG_WAKELOCK_STAT
+	int i;
+#endif
 	if (debug_mask & DEBUG_WAKE_LOCK)
 		pr_info("wake_lock_destroy name=%s\n", lock->name);
 	spin_lock_irqsave(&list_lock, irqflags);
@@ -405,6 +461,8 @@ void wake_lock_destroy(struct wake_lock *lock)
 		deleted_wake_locks.stat.max_time =
 			ktime_add(deleted_wake_locks.stat.max_time,
 				  lock->stat.max_time);
+		for (i = 0; i < WAKE_LOCK_HIST_BUCKETS; i++)
+			deleted_wake_locks.stat.hist[i] += lock->stat.hist[i];
 	}
 #endif
 	list_del(&lock->link);
@@ -418,6 +476,9 @@ static void wake_lock_internal(
 	int type;
 	unsigned long irqflags;
 	long expire_in;
+#ifdef CONFIG_WAKELOCK_STAT
+	ktime_t now = ktime_get();
+#endif
 
 	spin_lock_irqsave(&list_lock, irqflags);
 	type = lock->flags & WAKE_LOCK_TYPE_MASK;
@@ -432,14 +493,14 @@ static void wake_lock_internal(
 	}
 	if ((lock->flags & WAKE_LOCK_AUTO_EXPIRE) &&
 	    (long)(lock->expires - jiffies) <= 0) {
-		wake_unlock_stat_locked(lock, 0);
-		lock->stat.last_time = ktime_get();
+		wake_unlock_stat_locked(lock, 0, now);
+		lock->stat.last_time = now;
 	}
 #endif
 	if (!(lock->flags & WAKE_LOCK_ACTIVE)) {
 		lock->flags |= WAKE_LOCK_ACTIVE;
 #ifdef CONFIG_WAKELOCK_STAT
-		lock->stat.last_time = ktime_get();
+		lock->stat.last_time = now;
 #endif
 	}
 	list_del(&lock->link);
@@ -462,9 +523,9 @@ static void wake_lock_internal(
 		current_event_num++;
 #ifdef CONFIG_WAKELOCK_STAT
 		if (lock == &main_wake_lock)
-			update_sleep_wait_stats_locked(1);
+			update_sleep_wait_stats_locked(1, now);
 		else if (!wake_lock_active(&main_wake_lock))
-			update_sleep_wait_stats_locked(0);
+			update_sleep_wait_stats_locked(0, now);
 #endif
 		if (has_timeout)
 			expire_in = has_wake_lock_locked(type);
@@ -503,10 +564,13 @@ void wake_unlock(struct wake_lock *lock)
 {
 	int type;
 	unsigned long irqflags;
+#ifdef CONFIG_WAKELOCK_STAT
+	ktime_t now = ktime_get();
+#endif
 	spin_lock_irqsave(&list_lock, irqflags);
 	type = lock->flags & WAKE_LOCK_TYPE_MASK;
 #ifdef CONFIG_WAKELOCK_STAT
-	wake_unlock_stat_locked(lock, 0);
+	wake_unlock_stat_locked(lock, 0, now);
 #endif
 	if (debug_mask & DEBUG_WAKE_LOCK)
 		pr_info("wake_unlock: %s\n", lock->name);
@@ -532,7 +596,7 @@ void wake_unlock(struct wake_lock *lock)
 			if (debug_mask & DEBUG_SUSPEND)
 				print_active_locks(WAKE_LOCK_SUSPEND);
 #ifdef CONFIG_WAKELOCK_STAT
-			update_sleep_wait_stats_locked(0);
+			update_sleep_wait_stats_locked(0, now);
 #endif
 		}
 	}
@@ -559,6 +623,19 @@ static const struct file_operations wakelock_stats_fops = {
 	.release = single_release,
 };
 
+static int wakelock_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wakelock_hist_show, NULL);
+}
+
+static const struct file_operations wakelock_hist_fops = {
+	.owner = THIS_MODULE,
+	.open = wakelock_hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int __init wakelocks_init(void)
 {
 	int ret;
@@ -596,6 +673,7 @@ static int __init wakelocks_init(void)
 
 #ifdef CONFIG_WAKELOCK_STAT
 	proc_create("wakelocks", S_IRUGO, NULL, &wakelock_stats_fops);
+	proc_create("wakelock_histogram", S_IRUGO, NULL, &wakelock_hist_fops);
 #endif
 
 	return 0;
@@ -617,6 +695,7 @@ err_platform_device_register:
 static void  __exit wakelocks_exit(void)
 {
 #ifdef CONFIG_WAKELOCK_STAT
+	remove_proc_entry("wakelock_histogram", NULL);
 	remove_proc_entry("wakelocks", NULL);
 #endif
 	destroy_workqueue(suspend_work_queue);
@@ -41,6 +41,9 @@
 #include <linux/cpu.h>
 #include <linux/notifier.h>
 #include <linux/rculist.h>
+#include <linux/kthread.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <trace/stm.h>
 
 #include <asm/uaccess.h>
@@ -150,8 +153,43 @@ EXPORT_SYMBOL(console_set_on_cmdline);
 /* Flag: console code may call schedule() */
 static int console_may_schedule;
 
+/*
+ * With printk.async, printk() only stores messages in log_buf and leaves
+ * writing them to the consoles to the printk kthread, so that the caller
+ * does not get stuck behind a slow (serial) console with interrupts off.
+ */
+static struct task_struct *printk_kthread;
+static DECLARE_WAIT_QUEUE_HEAD(printk_kthread_wait);
+
+/* Chars the printk kthread writes out before it enables interrupts again */
+#define PRINTK_KTHREAD_CHUNK	128
+
 #ifdef CONFIG_PRINTK
 
+#if defined(CONFIG_PRINTK_ASYNC)
+static bool printk_async = 1;
+#else
+static bool printk_async = 0;
+#endif
+module_param_named(async, printk_async, bool, S_IRUGO | S_IWUSR);
+
+/* Set once the system goes down and the printk kthread can't be relied on */
+static bool printk_sync_forced;
+
+/* Statistics of the printk kthread, protected by logbuf_lock */
+static struct {
+	unsigned long deferred;		/* printk()s left to the kthread */
+	unsigned long dropped;		/* chars overwritten before printed */
+	unsigned long flushes;		/* kthread runs */
+	u64 latency_max;		/* ns from printk() to console */
+	u64 latency_total;
+} printk_stats;
+
+/* local_clock() of the oldest printk() the kthread hasn't flushed yet */
+static u64 printk_deferred_since;
+
+static void printk_kthread_kick(void);
+
 static char __log_buf[__LOG_BUF_LEN];
 static char *log_buf = __log_buf;
 static int log_buf_len = __LOG_BUF_LEN;
@@ -735,8 +773,10 @@ static void emit_log_char(char c)
 	log_end++;
 	if (log_end - log_start > log_buf_len)
 		log_start = log_end - log_buf_len;
-	if (log_end - con_start > log_buf_len)
+	if (log_end - con_start > log_buf_len) {
 		con_start = log_end - log_buf_len;
+		printk_stats.dropped++;
+	}
 	if (logged_chars < log_buf_len)
 		logged_chars++;
 }
@@ -879,6 +919,21 @@ static int console_trylock_for_printk(unsigned int cpu)
 		up(&console_sem);
 	return retval;
 }
+
+/*
+ * Should this printk() leave the console output to the printk kthread?
+ * Oopses, panics and shutdown messages are always printed right away:
+ * nothing guarantees that the kthread still gets to run afterwards.
+ */
+static inline bool printk_offload(void)
+{
+	if (!printk_async || !printk_kthread)
+		return false;
+	if (oops_in_progress || printk_sync_forced)
+		return false;
+	return system_state == SYSTEM_BOOTING || system_state == SYSTEM_RUNNING;
+}
+
 static const char recursion_bug_msg [] =
 		KERN_CRIT "BUG: recent printk recursion!\n";
 static int recursion_bug;
@@ -1034,8 +1089,17 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 	 * The console_trylock_for_printk() function
 	 * will release 'logbuf_lock' regardless of whether it
 	 * actually gets the semaphore or not.
+	 *
+	 * In async mode, just kick the printk kthread instead.
 	 */
-	if (console_trylock_for_printk(this_cpu))
+	if (printk_offload()) {
+		if (!printk_deferred_since)
+			printk_deferred_since = local_clock();
+		printk_stats.deferred++;
+		printk_cpu = UINT_MAX;
+		raw_spin_unlock(&logbuf_lock);
+		printk_kthread_kick();
+	} else if (console_trylock_for_printk(this_cpu))
 		console_unlock();
 	else if (oops_in_progress) {
 		/* force releasing / acquiring console lock to print oops */
@@ -1297,6 +1361,7 @@ int is_console_locked(void)
 
 #define PRINTK_PENDING_WAKEUP	0x01
 #define PRINTK_PENDING_SCHED	0x02
+#define PRINTK_PENDING_OUTPUT	0x04
 
 static DEFINE_PER_CPU(int, printk_pending);
 static DEFINE_PER_CPU(char [PRINTK_BUF_SIZE], printk_sched_buf);
@@ -1311,6 +1376,8 @@ void printk_tick(void)
 		}
 		if (pending & PRINTK_PENDING_WAKEUP)
 			wake_up_interruptible(&log_wait);
+		if (pending & PRINTK_PENDING_OUTPUT)
+			wake_up_interruptible(&printk_kthread_wait);
 	}
 }
 
@@ -1327,6 +1394,15 @@ void wake_up_klogd(void)
 		this_cpu_or(printk_pending, PRINTK_PENDING_WAKEUP);
 }
 
+/*
+ * Like klogd, the printk kthread is woken from the next tick: printk()
+ * may be called with scheduler locks held.
+ */
+static void printk_kthread_kick(void)
+{
+	this_cpu_or(printk_pending, PRINTK_PENDING_OUTPUT);
+}
+
 /**
  * console_unlock - unlock the console system
  *
@@ -1362,12 +1438,21 @@ again:
 			break;			/* Nothing to print */
 		_con_start = con_start;
 		_log_end = log_end;
-		con_start = log_end;		/* Flush */
+		/*
+		 * Nobody waits for the printk kthread, so it can as well
+		 * let interrupts in between every few lines.
+		 */
+		if (current == printk_kthread &&
+		    _log_end - _con_start > PRINTK_KTHREAD_CHUNK)
+			_log_end = _con_start + PRINTK_KTHREAD_CHUNK;
+		con_start = _log_end;		/* Flush */
 		raw_spin_unlock(&logbuf_lock);
 		stop_critical_timings();	/* don't trace print latency */
 		call_console_drivers(_con_start, _log_end);
 		start_critical_timings();
 		local_irq_restore(flags);
+		if (current == printk_kthread)
+			cond_resched();
 	}
 	console_locked = 0;
 
@@ -1717,6 +1802,114 @@ late_initcall(printk_late_init);
 
 #if defined CONFIG_PRINTK
 
+/**
+ * printk_force_sync - stop leaving console output to the printk kthread
+ *
+ * Called on panic: from now on every printk() writes to the consoles
+ * itself, whatever printk.async says.
+ */
+void printk_force_sync(void)
+{
+	printk_sync_forced = true;
+}
+
+static bool printk_output_pending(void)
+{
+	return con_start != log_end && !console_suspended;
+}
+
+static int printk_kthread_func(void *unused)
+{
+	unsigned long flags;
+	u64 since, latency;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(printk_kthread_wait,
+					 printk_output_pending() ||
+					 kthread_should_stop());
+
+		raw_spin_lock_irqsave(&logbuf_lock, flags);
+		since = printk_deferred_since;
+		printk_deferred_since = 0;
+		raw_spin_unlock_irqrestore(&logbuf_lock, flags);
+
+		console_lock();
+		console_unlock();
+
+		raw_spin_lock_irqsave(&logbuf_lock, flags);
+		if (since) {
+			printk_stats.flushes++;
+			latency = local_clock() - since;
+			printk_stats.latency_total += latency;
+			if (latency > printk_stats.latency_max)
+				printk_stats.latency_max = latency;
+		}
+		raw_spin_unlock_irqrestore(&logbuf_lock, flags);
+	}
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *task;
+
+	task = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(task)) {
+		printk(KERN_ERR "printk: unable to create printing thread\n");
+		return PTR_ERR(task);
+	}
+	printk_kthread = task;
+	return 0;
+}
+early_initcall(printk_kthread_init);
+
+#ifdef CONFIG_DEBUG_FS
+static int printk_stats_show(struct seq_file *m, void *v)
+{
+	unsigned long deferred, dropped, flushes;
+	u64 latency_max, latency_total;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&logbuf_lock, flags);
+	deferred = printk_stats.deferred;
+	dropped = printk_stats.dropped;
+	flushes = printk_stats.flushes;
+	latency_max = printk_stats.latency_max;
+	latency_total = printk_stats.latency_total;
+	raw_spin_unlock_irqrestore(&logbuf_lock, flags);
+
+	seq_printf(m, "async %d\n", printk_async);
+	seq_printf(m, "deferred %lu\n", deferred);
+	seq_printf(m, "dropped_chars %lu\n", dropped);
+	seq_printf(m, "flushes %lu\n", flushes);
+	seq_printf(m, "flush_latency_max_us %llu\n",
+		   div_u64(latency_max, NSEC_PER_USEC));
+	seq_printf(m, "flush_latency_avg_us %llu\n", flushes ?
+		   div_u64(div_u64(latency_total, flushes), NSEC_PER_USEC) : 0);
+	return 0;
+}
+
+static int printk_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, printk_stats_show, NULL);
+}
+
+static const struct file_operations printk_stats_fops = {
+	.open		= printk_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init printk_stats_init(void)
+{
+	debugfs_create_file("printk_stats", S_IRUSR, NULL, NULL,
+			    &printk_stats_fops);
+	return 0;
+}
+late_initcall(printk_stats_init);
+#endif /* CONFIG_DEBUG_FS */
+
 int printk_sched(const char *fmt, ...)
 {
 	unsigned long flags;
@@ -72,6 +72,7 @@ static int stall_cpu_holdoff = 10; /* Time to wait until stall (s).  */
 static int test_boost = 1;	/* Test RCU prio boost: 0=no, 1=maybe, 2=yes. */
 static int test_boost_interval = 7; /* Interval between boost tests, seconds. */
 static int test_boost_duration = 4; /* Duration of each boost test, seconds. */
+static int nocb_toggle;		/* Time between callback-offload toggles (s). */
 static char *torture_type = "rcu"; /* What RCU implementation to torture. */
 
 module_param(nreaders, int, 0444);
@@ -112,6 +113,8 @@ module_param(test_boost_interval, int, 0444);
 MODULE_PARM_DESC(test_boost_interval, "Interval between boost tests, seconds.");
 module_param(test_boost_duration, int, 0444);
 MODULE_PARM_DESC(test_boost_duration, "Duration of each boost test, seconds.");
+module_param(nocb_toggle, int, 0444);
+MODULE_PARM_DESC(nocb_toggle, "Time between RCU callback-offload toggles (s), 0=disable");
 module_param(torture_type, charp, 0444);
 MODULE_PARM_DESC(torture_type, "Type of RCU to torture (rcu, rcu_bh, srcu)");
 
@@ -133,6 +136,8 @@ static struct task_struct *stats_task;
 static struct task_struct *shuffler_task;
 static struct task_struct *stutter_task;
 static struct task_struct *fqs_task;
+static struct task_struct *nocb_toggle_task;
+static bool nocb_saved;		/* Callback offloading before the test. */
 static struct task_struct *boost_tasks[NR_CPUS];
 static struct task_struct *shutdown_task;
 #ifdef CONFIG_HOTPLUG_CPU
@@ -893,6 +898,31 @@ rcu_torture_fqs(void *arg)
 	return 0;
 }
 
+/*
+ * RCU torture callback-offload kthread.  Periodically switches the
+ * offloading of RCU callbacks to the rcuo kthreads on and off, so that
+ * callbacks are invoked by the rcuo kthreads and in softirq in turn.
+ * This only has an effect on CPUs given by the rcu_nocbs= boot parameter.
+ */
+static int
+rcu_torture_nocb_toggle(void *arg)
+{
+	bool enable = false;
+
+	VERBOSE_PRINTK_STRING("rcu_torture_nocb_toggle task started");
+	do {
+		schedule_timeout_interruptible(nocb_toggle * HZ);
+		rcu_nocb_enable(enable);
+		enable = !enable;
+		rcu_stutter_wait("rcu_torture_nocb_toggle");
+	} while (!kthread_should_stop() && fullstop == FULLSTOP_DONTSTOP);
+	VERBOSE_PRINTK_STRING("rcu_torture_nocb_toggle task stopping");
+	rcutorture_shutdown_absorb("rcu_torture_nocb_toggle");
+	while (!kthread_should_stop())
+		schedule_timeout_uninterruptible(1);
+	return 0;
+}
+
 /*
  * RCU torture writer kthread.  Repeatedly substitutes a new structure
  * for that pointed to by rcu_torture_current, freeing the old structure
@@ -1310,13 +1340,13 @@ rcu_torture_print_module_parms(struct rcu_torture_ops *cur_ops, char *tag)
 		"fqs_duration=%d fqs_holdoff=%d fqs_stutter=%d "
 		"test_boost=%d/%d test_boost_interval=%d "
 		"test_boost_duration=%d shutdown_secs=%d "
-		"onoff_interval=%d onoff_holdoff=%d\n",
+		"onoff_interval=%d onoff_holdoff=%d nocb_toggle=%d\n",
 		torture_type, tag, nrealreaders, nfakewriters,
 		stat_interval, verbose, test_no_idle_hz, shuffle_interval,
 		stutter, irqreader, fqs_duration, fqs_holdoff, fqs_stutter,
 		test_boost, cur_ops->can_boost,
 		test_boost_interval, test_boost_duration, shutdown_secs,
-		onoff_interval, onoff_holdoff);
+		onoff_interval, onoff_holdoff, nocb_toggle);
 }
 
 static struct notifier_block rcutorture_shutdown_nb = {
@@ -1655,6 +1685,12 @@ rcu_torture_cleanup(void)
 		kthread_stop(fqs_task);
 	}
 	fqs_task = NULL;
+	if (nocb_toggle_task) {
+		VERBOSE_PRINTK_STRING("Stopping rcu_torture_nocb_toggle task");
+		kthread_stop(nocb_toggle_task);
+		rcu_nocb_enable(nocb_saved);
+	}
+	nocb_toggle_task = NULL;
 	if ((test_boost == 1 && cur_ops->can_boost) ||
 	    test_boost == 2) {
 		unregister_cpu_notifier(&rcutorture_cpu_nb);
@@ -1866,6 +1902,21 @@ rcu_torture_init(void)
 			goto unwind;
 		}
 	}
+	if (nocb_toggle < 0)
+		nocb_toggle = 0;
+	if (nocb_toggle) {
+		/* Create the callback-offload toggling thread */
+		nocb_saved = rcu_nocb_enable(true);
+		nocb_toggle_task = kthread_run(rcu_torture_nocb_toggle, NULL,
+					       "rcu_torture_nocb_toggle");
+		if (IS_ERR(nocb_toggle_task)) {
+			firsterr = PTR_ERR(nocb_toggle_task);
+			VERBOSE_PRINTK_ERRSTRING("Failed to create nocb_toggle");
+			nocb_toggle_task = NULL;
+			rcu_nocb_enable(nocb_saved);
+			goto unwind;
+		}
+	}
 	if (test_boost_interval < 1)
 		test_boost_interval = 1;
 	if (test_boost_duration < 2)
@@ -1477,6 +1477,7 @@ static void rcu_do_batch(struct rcu_state *rsp, struct rcu_data *rdp)
 	unsigned long flags;
 	struct rcu_head *next, *list, **tail;
 	long bl, count, count_lazy;
+	bool offloaded;
 
 	/* If no callbacks are ready, just return.*/
 	if (!cpu_has_callbacks_ready_to_invoke(rdp)) {
@@ -1504,8 +1505,11 @@ static void rcu_do_batch(struct rcu_state *rsp, struct rcu_data *rdp)
 			rdp->nxttail[count] = &rdp->nxtlist;
 	local_irq_restore(flags);
 
-	/* Invoke callbacks. */
+	/* Invoke callbacks, unless this CPU's rcuo kthread is to do so. */
 	count = count_lazy = 0;
+	offloaded = rcu_nocb_adopt_cbs(rdp, list, tail, &count, &count_lazy);
+	if (offloaded)
+		list = NULL;
 	while (list) {
 		next = list->next;
 		prefetch(next);
@@ -1528,7 +1532,8 @@ static void rcu_do_batch(struct rcu_state *rsp, struct rcu_data *rdp)
 	/* Update count, and requeue any remaining callbacks. */
 	rdp->qlen_lazy -= count_lazy;
 	rdp->qlen -= count;
-	rdp->n_cbs_invoked += count;
+	if (!offloaded)
+		rdp->n_cbs_invoked += count;
 	if (list != NULL) {
 		*tail = rdp->nxtlist;
 		rdp->nxtlist = list;
@@ -2219,6 +2224,7 @@ static void _rcu_barrier(struct rcu_state *rsp,
 	 */
 	atomic_set(&rcu_barrier_cpu_count, 1);
 	on_each_cpu(rcu_barrier_func, (void *)call_rcu_func, 1);
+	rcu_nocb_barrier(rsp);
 	if (atomic_dec_and_test(&rcu_barrier_cpu_count))
 		complete(&rcu_barrier_completion);
 	wait_for_completion(&rcu_barrier_completion);
@@ -2267,6 +2273,7 @@ rcu_boot_init_percpu_data(int cpu, struct rcu_state *rsp)
 	WARN_ON_ONCE(atomic_read(&rdp->dynticks->dynticks) != 1);
 	rdp->cpu = cpu;
 	rdp->rsp = rsp;
+	rcu_boot_init_nocb_percpu_data(rdp);
 	raw_spin_unlock_irqrestore(&rnp->lock, flags);
 }
 
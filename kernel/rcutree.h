@@ -301,6 +301,18 @@ struct rcu_data {
 	unsigned long n_rp_need_fqs;
 	unsigned long n_rp_need_nothing;
 
+#ifdef CONFIG_RCU_NOCB_CPU
+	/* 6) Callback offloading. */
+	struct rcu_head *nocb_head;	/* CBs waiting for kthread. */
+	struct rcu_head **nocb_tail;
+	atomic_long_t nocb_q_count;	/* # CBs handed over, not yet invoked. */
+	raw_spinlock_t nocb_lock;	/* Protects ->nocb_head and ->nocb_tail. */
+	wait_queue_head_t nocb_wq;	/* For the kthread to sleep on. */
+	struct task_struct *nocb_kthread;
+	unsigned long n_nocb_invoked;	/* # CBs invoked by the kthread. */
+	struct rcu_head nocb_barrier_head; /* For rcu_barrier() to entrain. */
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU */
+
 	int cpu;
 	struct rcu_state *rsp;
 };
@@ -476,5 +488,10 @@ static void print_cpu_stall_info(struct rcu_state *rsp, int cpu);
 static void print_cpu_stall_info_end(void);
 static void zero_cpu_stall_ticks(struct rcu_data *rdp);
 static void increment_cpu_stall_ticks(void);
+static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp);
+static bool rcu_nocb_adopt_cbs(struct rcu_data *rdp, struct rcu_head *list,
+			       struct rcu_head **tail,
+			       long *count, long *count_lazy);
+static void rcu_nocb_barrier(struct rcu_state *rsp);
 
 #endif /* #ifndef RCU_TREE_NONCORE */
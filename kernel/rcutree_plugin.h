@@ -2299,3 +2299,242 @@ static void increment_cpu_stall_ticks(void)
 }
 
 #endif /* #else #ifdef CONFIG_RCU_CPU_STALL_INFO */
+
+#ifdef CONFIG_RCU_NOCB_CPU
+
+/*
+ * Offload callback invocation for the CPUs in rcu_nocb_mask.
+ *
+ * Grace-period processing and callback advancement stay on the CPU,
+ * but once a batch of callbacks is ready to invoke, rcu_do_batch()
+ * hands the whole batch to a per-CPU, per-flavor "rcuo" kthread in
+ * O(1) time (apart from counting it).  The kthread is not bound to
+ * any CPU, so it can be affined to housekeeping CPUs and given a
+ * priority that suits the workload.
+ */
+static cpumask_var_t rcu_nocb_mask;	/* CPUs to have callbacks offloaded. */
+static bool have_rcu_nocb_mask;		/* Was rcu_nocb_mask allocated? */
+static bool rcu_nocb_enabled = 1;	/* Offload rcu_nocb_mask CPUs? */
+module_param(rcu_nocb_enabled, bool, 0644);
+
+/* Parse the boot-time rcu_nocbs= CPU list from the kernel parameters. */
+static int __init rcu_nocb_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_mask);
+	have_rcu_nocb_mask = true;
+	cpulist_parse(str, rcu_nocb_mask);
+	return 1;
+}
+__setup("rcu_nocbs=", rcu_nocb_setup);
+
+/**
+ * rcu_nocb_enable - switch offloading of RCU callbacks on or off
+ * @enable: whether to offload the callbacks of the rcu_nocbs= CPUs
+ *
+ * Returns the previous setting.  Callbacks that were handed over to
+ * the rcuo kthreads before offloading was switched off are invoked
+ * before any later ones, so this may be called at any time.
+ */
+bool rcu_nocb_enable(bool enable)
+{
+	return xchg(&rcu_nocb_enabled, enable);
+}
+EXPORT_SYMBOL_GPL(rcu_nocb_enable);
+
+/* Is the specified CPU's callback invocation to be offloaded? */
+static bool is_nocb_cpu(int cpu)
+{
+	if (have_rcu_nocb_mask)
+		return cpumask_test_cpu(cpu, rcu_nocb_mask);
+	return false;
+}
+
+/*
+ * Hand the ready callbacks from @list through @tail over to the rcuo
+ * kthread if the current CPU's callbacks are offloaded, counting them
+ * in @count and @count_lazy for rcu_do_batch().  Returns true if the
+ * callbacks were handed over, false if the caller is to invoke them.
+ *
+ * As long as callbacks handed over earlier have not been invoked yet,
+ * keep handing over new ones even if offloading was switched off
+ * meanwhile, so that the callbacks are still invoked in order.  In
+ * particular, rcu_barrier() relies on that.
+ */
+static bool rcu_nocb_adopt_cbs(struct rcu_data *rdp, struct rcu_head *list,
+			       struct rcu_head **tail,
+			       long *count, long *count_lazy)
+{
+	struct rcu_head *rhp;
+	unsigned long flags;
+
+	if (!rdp->nocb_kthread)
+		return false;
+	if (!atomic_long_read(&rdp->nocb_q_count) &&
+	    !(ACCESS_ONCE(rcu_nocb_enabled) && is_nocb_cpu(rdp->cpu)))
+		return false;
+
+	for (rhp = list; rhp; rhp = rhp->next) {
+		(*count)++;
+		if (__is_kfree_rcu_offset((unsigned long)rhp->func))
+			(*count_lazy)++;
+	}
+	atomic_long_add(*count, &rdp->nocb_q_count);
+
+	raw_spin_lock_irqsave(&rdp->nocb_lock, flags);
+	*rdp->nocb_tail = list;
+	rdp->nocb_tail = tail;
+	raw_spin_unlock_irqrestore(&rdp->nocb_lock, flags);
+	wake_up(&rdp->nocb_wq);
+	return true;
+}
+
+/*
+ * Per-CPU, per-flavor kthread invoking the callbacks that the CPU
+ * handed over.  Callbacks expect to run with bottom halves disabled,
+ * as they would in softirq context.
+ */
+static int rcu_nocb_kthread(void *arg)
+{
+	struct rcu_data *rdp = arg;
+	struct rcu_head *list, *next;
+	unsigned long flags;
+	long c;
+
+	for (;;) {
+		wait_event_interruptible(rdp->nocb_wq,
+					 ACCESS_ONCE(rdp->nocb_head));
+
+		raw_spin_lock_irqsave(&rdp->nocb_lock, flags);
+		list = rdp->nocb_head;
+		rdp->nocb_head = NULL;
+		rdp->nocb_tail = &rdp->nocb_head;
+		raw_spin_unlock_irqrestore(&rdp->nocb_lock, flags);
+		if (!list)
+			continue;
+
+		trace_rcu_batch_start(rdp->rsp->name, 0,
+				      atomic_long_read(&rdp->nocb_q_count), -1);
+		c = 0;
+		while (list) {
+			next = list->next;
+			prefetch(next);
+			debug_rcu_head_unqueue(list);
+			local_bh_disable();
+			__rcu_reclaim(rdp->rsp->name, list);
+			local_bh_enable();
+			list = next;
+			c++;
+			cond_resched();
+		}
+		trace_rcu_batch_end(rdp->rsp->name, c, 0, 0, 0, 1);
+		rdp->n_nocb_invoked += c;
+		atomic_long_sub(c, &rdp->nocb_q_count);
+	}
+	return 0;
+}
+
+/*
+ * Callbacks already handed over to an rcuo kthread are no longer on
+ * any CPU's list, so the barrier callbacks that _rcu_barrier() queues
+ * on the online CPUs need not be invoked after them.  This is in
+ * particular the case for CPUs that went offline before their kthread
+ * got to the callbacks.  Therefore entrain a barrier callback behind
+ * the callbacks pending in each of the rcuo kthreads' queues.
+ */
+static void rcu_nocb_barrier(struct rcu_state *rsp)
+{
+	struct rcu_data *rdp;
+	struct rcu_head *rhp;
+	unsigned long flags;
+	bool queued;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		rdp = per_cpu_ptr(rsp->rda, cpu);
+		if (!rdp->nocb_kthread)
+			continue;
+		queued = false;
+		raw_spin_lock_irqsave(&rdp->nocb_lock, flags);
+		if (atomic_long_read(&rdp->nocb_q_count)) {
+			rhp = &rdp->nocb_barrier_head;
+			rhp->func = rcu_barrier_callback;
+			rhp->next = NULL;
+			debug_rcu_head_queue(rhp);
+			atomic_inc(&rcu_barrier_cpu_count);
+			atomic_long_inc(&rdp->nocb_q_count);
+			*rdp->nocb_tail = rhp;
+			rdp->nocb_tail = &rhp->next;
+			queued = true;
+		}
+		raw_spin_unlock_irqrestore(&rdp->nocb_lock, flags);
+		if (queued)
+			wake_up(&rdp->nocb_wq);
+	}
+}
+
+/* Initialize the offloading state of a CPU's per-CPU RCU data. */
+static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp)
+{
+	rdp->nocb_head = NULL;
+	rdp->nocb_tail = &rdp->nocb_head;
+	atomic_long_set(&rdp->nocb_q_count, 0);
+	raw_spin_lock_init(&rdp->nocb_lock);
+	init_waitqueue_head(&rdp->nocb_wq);
+}
+
+/* Create the rcuo kthreads for the specified RCU flavor. */
+static void __init rcu_spawn_nocb_kthreads(struct rcu_state *rsp, char abbr)
+{
+	struct rcu_data *rdp;
+	struct task_struct *t;
+	int cpu;
+
+	for_each_cpu(cpu, rcu_nocb_mask) {
+		if (!cpu_possible(cpu))
+			continue;
+		rdp = per_cpu_ptr(rsp->rda, cpu);
+		t = kthread_run(rcu_nocb_kthread, rdp, "rcuo%c/%d", abbr, cpu);
+		if (IS_ERR(t)) {
+			printk(KERN_ERR "RCU: could not create rcuo%c/%d\n",
+			       abbr, cpu);
+			continue;
+		}
+		ACCESS_ONCE(rdp->nocb_kthread) = t;
+	}
+}
+
+static int __init rcu_spawn_all_nocb_kthreads(void)
+{
+	char buf[64];
+
+	if (!have_rcu_nocb_mask)
+		return 0;
+	cpulist_scnprintf(buf, sizeof(buf), rcu_nocb_mask);
+	printk(KERN_INFO "RCU: offloading callbacks of CPUs %s\n", buf);
+	rcu_spawn_nocb_kthreads(&rcu_sched_state, 's');
+	rcu_spawn_nocb_kthreads(&rcu_bh_state, 'b');
+#ifdef CONFIG_TREE_PREEMPT_RCU
+	rcu_spawn_nocb_kthreads(&rcu_preempt_state, 'p');
+#endif /* #ifdef CONFIG_TREE_PREEMPT_RCU */
+	return 0;
+}
+early_initcall(rcu_spawn_all_nocb_kthreads);
+
+#else /* #ifdef CONFIG_RCU_NOCB_CPU */
+
+static bool rcu_nocb_adopt_cbs(struct rcu_data *rdp, struct rcu_head *list,
+			       struct rcu_head **tail,
+			       long *count, long *count_lazy)
+{
+	return false;
+}
+
+static void rcu_nocb_barrier(struct rcu_state *rsp)
+{
+}
+
+static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp)
+{
+}
+
+#endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
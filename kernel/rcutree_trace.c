@@ -57,6 +57,16 @@ static char convert_kthread_status(unsigned int kthread_status)
 
 #endif /* #ifdef CONFIG_RCU_BOOST */
 
+/* Callbacks invoked on behalf of this CPU, by itself or its rcuo kthread. */
+static unsigned long rcu_cbs_invoked(struct rcu_data *rdp)
+{
+#ifdef CONFIG_RCU_NOCB_CPU
+	return rdp->n_cbs_invoked + rdp->n_nocb_invoked;
+#else /* #ifdef CONFIG_RCU_NOCB_CPU */
+	return rdp->n_cbs_invoked;
+#endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
+}
+
 static void print_one_rcu_data(struct seq_file *m, struct rcu_data *rdp)
 {
 	if (!rdp->beenonline)
@@ -90,9 +100,13 @@ static void print_one_rcu_data(struct seq_file *m, struct rcu_data *rdp)
 		   per_cpu(rcu_cpu_kthread_cpu, rdp->cpu),
 		   per_cpu(rcu_cpu_kthread_loops, rdp->cpu) & 0xffff);
 #endif /* #ifdef CONFIG_RCU_BOOST */
+#ifdef CONFIG_RCU_NOCB_CPU
+	seq_printf(m, " nq=%ld nci=%lu",
+		   atomic_long_read(&rdp->nocb_q_count), rdp->n_nocb_invoked);
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 	seq_printf(m, " b=%ld", rdp->blimit);
 	seq_printf(m, " ci=%lu co=%lu ca=%lu\n",
-		   rdp->n_cbs_invoked, rdp->n_cbs_orphaned, rdp->n_cbs_adopted);
+		   rcu_cbs_invoked(rdp), rdp->n_cbs_orphaned, rdp->n_cbs_adopted);
 }
 
 #define PRINT_RCU_DATA(name, func, m) \
@@ -161,7 +175,7 @@ static void print_one_rcu_data_csv(struct seq_file *m, struct rcu_data *rdp)
 #endif /* #ifdef CONFIG_RCU_BOOST */
 	seq_printf(m, ",%ld", rdp->blimit);
 	seq_printf(m, ",%lu,%lu,%lu\n",
-		   rdp->n_cbs_invoked, rdp->n_cbs_orphaned, rdp->n_cbs_adopted);
+		   rcu_cbs_invoked(rdp), rdp->n_cbs_orphaned, rdp->n_cbs_adopted);
 }
 
 static int show_rcudata_csv(struct seq_file *m, void *unused)
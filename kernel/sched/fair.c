@@ -971,6 +971,259 @@ static inline void update_entity_shares_tick(struct cfs_rq *cfs_rq)
 }
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
+#ifdef CONFIG_SMP
+/*
+ * Per-entity load tracking
+ *
+ * The time an entity is runnable is accumulated in ~1ms (1024us)
+ * periods, with the contribution of each period decayed geometrically
+ * by y per period of age, where y^32 = 0.5: a period that ended 32ms ago
+ * counts half as much as the current one.  The same is done for the time
+ * the entity was tracked at all, so their ratio is the recent runnable
+ * fraction, and multiplied by the entity's weight it is the load it puts
+ * on its cfs_rq.  Unlike cfs_rq->load.weight, which counts every queued
+ * entity in full, this tells a task that wakes up briefly from one that
+ * keeps the cpu busy.
+ *
+ * The sums converge to LOAD_AVG_MAX, and after LOAD_AVG_MAX_N periods of
+ * continuous runnability they have stopped growing.
+ *
+ * Time is taken from rq->clock rather than clock_task, whose offset
+ * differs from cpu to cpu, so that the time a task slept on one cpu can
+ * be measured when it wakes up on another.
+ */
+#define LOAD_AVG_PERIOD 32
+#define LOAD_AVG_MAX 47742
+#define LOAD_AVG_MAX_N 345
+
+/* Precomputed fixed inverse multiplies for multiplication by y^n */
+static const u32 runnable_avg_yN_inv[] = {
+	0xffffffff, 0xfa83b2da, 0xf5257d14, 0xefe4b99a, 0xeac0c6e6, 0xe5b906e6,
+	0xe0ccdeeb, 0xdbfbb796, 0xd744fcc9, 0xd2a81d91, 0xce248c14, 0xc9b9bd85,
+	0xc5672a10, 0xc12c4cc9, 0xbd08a39e, 0xb8fbaf46, 0xb504f333, 0xb123f581,
+	0xad583ee9, 0xa9a15ab4, 0xa5fed6a9, 0xa2704302, 0x9ef5325f, 0x9b8d39b9,
+	0x9837f050, 0x94f4efa8, 0x91c3d373, 0x8ea4398a, 0x8b95c1e3, 0x88980e80,
+	0x85aac367, 0x82cd8698,
+};
+
+/*
+ * Precomputed \Sum y^k { 1<=k<=n }.  These are floor(true_value) to
+ * prevent over-estimates when re-combining.
+ */
+static const u32 runnable_avg_yN_sum[] = {
+	    0, 1002, 1982, 2941, 3880, 4798, 5697, 6576, 7437, 8279, 9103,
+	 9909,10698,11470,12226,12966,13690,14398,15091,15769,16433,17082,
+	17718,18340,18949,19545,20128,20699,21257,21803,22338,22861,23373,
+};
+
+/* Approximate val * y^n, where y^32 ~= 0.5 (~1 scheduling period) */
+static __always_inline u64 decay_load(u64 val, u64 n)
+{
+	unsigned int local_n;
+
+	if (!n)
+		return val;
+	else if (unlikely(n > LOAD_AVG_PERIOD * 63))
+		return 0;
+
+	/* after bounds checking we can collapse to 32-bit */
+	local_n = n;
+
+	/* y^32 = 0.5, so halve val once per LOAD_AVG_PERIOD */
+	if (unlikely(local_n >= LOAD_AVG_PERIOD)) {
+		val >>= local_n / LOAD_AVG_PERIOD;
+		local_n %= LOAD_AVG_PERIOD;
+	}
+
+	val *= runnable_avg_yN_inv[local_n];
+	return val >> 32;
+}
+
+/*
+ * The contribution of n full periods of runnability:
+ * 1024 * \Sum y^k { 1<=k<=n }
+ */
+static u32 __compute_runnable_contrib(u64 n)
+{
+	u32 contrib = 0;
+
+	if (likely(n <= LOAD_AVG_PERIOD))
+		return runnable_avg_yN_sum[n];
+	else if (unlikely(n >= LOAD_AVG_MAX_N))
+		return LOAD_AVG_MAX;
+
+	/* \Sum y^k over 32 periods at a time, halving it each time */
+	do {
+		contrib /= 2;
+		contrib += runnable_avg_yN_sum[LOAD_AVG_PERIOD];
+		n -= LOAD_AVG_PERIOD;
+	} while (n > LOAD_AVG_PERIOD);
+
+	contrib = decay_load(contrib, n);
+	return contrib + runnable_avg_yN_sum[n];
+}
+
+/*
+ * Account the time since the last update as runnable or not, decaying
+ * the sums by however many period boundaries were crossed.  Returns
+ * true if at least one was.
+ */
+static bool __update_entity_runnable_avg(u64 now, struct sched_avg *sa,
+					 int runnable)
+{
+	u64 delta, periods;
+	u32 runnable_contrib;
+	int delta_w;
+	bool decayed = false;
+
+	delta = now - sa->last_runnable_update;
+	/*
+	 * This should only happen when time goes backwards, which it
+	 * unfortunately does across cpus, e.g. after a migration.
+	 */
+	if ((s64)delta < 0) {
+		sa->last_runnable_update = now;
+		return false;
+	}
+
+	/* use 1024ns as the unit of measurement since it's a shift */
+	delta >>= 10;
+	if (!delta)
+		return false;
+	sa->last_runnable_update = now;
+
+	/* time already accumulated in the current period */
+	delta_w = sa->runnable_avg_period % 1024;
+	if (delta + delta_w >= 1024) {
+		decayed = true;
+
+		/* complete the current period first */
+		delta_w = 1024 - delta_w;
+		if (runnable)
+			sa->runnable_avg_sum += delta_w;
+		sa->runnable_avg_period += delta_w;
+		delta -= delta_w;
+
+		/* then decay by the completed and the skipped periods */
+		periods = delta / 1024;
+		delta %= 1024;
+
+		sa->runnable_avg_sum = decay_load(sa->runnable_avg_sum,
+						  periods + 1);
+		sa->runnable_avg_period = decay_load(sa->runnable_avg_period,
+						     periods + 1);
+
+		/* and add the skipped full periods, if any */
+		runnable_contrib = __compute_runnable_contrib(periods);
+		if (runnable)
+			sa->runnable_avg_sum += runnable_contrib;
+		sa->runnable_avg_period += runnable_contrib;
+	}
+
+	/* the remainder starts the new current period */
+	if (runnable)
+		sa->runnable_avg_sum += delta;
+	sa->runnable_avg_period += delta;
+
+	return decayed;
+}
+
+/* Recompute se's load contribution, returns how much it changed. */
+static long __update_entity_load_avg_contrib(struct sched_entity *se)
+{
+	long old_contrib = se->avg.load_avg_contrib;
+	u64 contrib;
+
+	contrib = (u64)se->avg.runnable_avg_sum *
+		  scale_load_down(se->load.weight);
+	contrib = div_u64(contrib, se->avg.runnable_avg_period + 1);
+	se->avg.load_avg_contrib = scale_load(contrib);
+
+	if (entity_is_task(se))
+		trace_sched_load_avg_task(task_of(se), &se->avg);
+
+	return (long)se->avg.load_avg_contrib - old_contrib;
+}
+
+/* Update se's runnable average, and its cfs_rq's load if it is queued. */
+static void update_entity_load_avg(struct sched_entity *se)
+{
+	struct cfs_rq *cfs_rq = cfs_rq_of(se);
+	long contrib_delta;
+
+	if (!__update_entity_runnable_avg(rq_of(cfs_rq)->clock,
+					  &se->avg, se->on_rq))
+		return;
+
+	contrib_delta = __update_entity_load_avg_contrib(se);
+	if (se->on_rq)
+		cfs_rq->runnable_load_avg += contrib_delta;
+}
+
+static void enqueue_entity_load_avg(struct cfs_rq *cfs_rq,
+				    struct sched_entity *se)
+{
+	/* the time since the last update was spent asleep or migrating */
+	__update_entity_runnable_avg(rq_of(cfs_rq)->clock, &se->avg, 0);
+	__update_entity_load_avg_contrib(se);
+	cfs_rq->runnable_load_avg += se->avg.load_avg_contrib;
+}
+
+static void dequeue_entity_load_avg(struct cfs_rq *cfs_rq,
+				    struct sched_entity *se)
+{
+	update_entity_load_avg(se);
+	cfs_rq->runnable_load_avg -= min(cfs_rq->runnable_load_avg,
+					 se->avg.load_avg_contrib);
+}
+
+/* Track how much of the time @rq had anything to run. */
+static void update_rq_runnable_avg(struct rq *rq, int runnable)
+{
+	if (__update_entity_runnable_avg(rq->clock, &rq->avg, runnable))
+		trace_sched_load_avg_cpu(cpu_of(rq), &rq->avg,
+					 rq->cfs.runnable_load_avg);
+}
+
+/*
+ * A new task starts out as if it had been running for a slice, so that
+ * forking a batch of tasks does not make a cpu look idle to the balancer.
+ */
+static void init_task_runnable_average(struct cfs_rq *cfs_rq,
+				       struct task_struct *p)
+{
+	u32 slice = sched_slice(cfs_rq, &p->se) >> 10;
+
+	p->se.avg.runnable_avg_sum = slice;
+	p->se.avg.runnable_avg_period = slice;
+	p->se.avg.last_runnable_update = rq_of(cfs_rq)->clock;
+	__update_entity_load_avg_contrib(&p->se);
+}
+#else
+static inline void update_entity_load_avg(struct sched_entity *se)
+{
+}
+
+static inline void enqueue_entity_load_avg(struct cfs_rq *cfs_rq,
+					   struct sched_entity *se)
+{
+}
+
+static inline void dequeue_entity_load_avg(struct cfs_rq *cfs_rq,
+					   struct sched_entity *se)
+{
+}
+
+static inline void update_rq_runnable_avg(struct rq *rq, int runnable)
+{
+}
+
+static inline void init_task_runnable_average(struct cfs_rq *cfs_rq,
+					      struct task_struct *p)
+{
+}
+#endif /* CONFIG_SMP */
+
 static void enqueue_sleeper(struct cfs_rq *cfs_rq, struct sched_entity *se)
 {
 #ifdef CONFIG_SCHEDSTATS
@@ -1097,6 +1350,7 @@ enqueue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	 */
 	update_curr(cfs_rq);
 	update_cfs_load(cfs_rq, 0);
+	enqueue_entity_load_avg(cfs_rq, se);
 	account_entity_enqueue(cfs_rq, se);
 	update_cfs_shares(cfs_rq);
 
@@ -1171,6 +1425,7 @@ dequeue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	 * Update run-time statistics of the 'current'.
 	 */
 	update_curr(cfs_rq);
+	dequeue_entity_load_avg(cfs_rq, se);
 
 	update_stats_dequeue(cfs_rq, se);
 	if (flags & DEQUEUE_SLEEP) {
@@ -1340,6 +1595,8 @@ static void put_prev_entity(struct cfs_rq *cfs_rq, struct sched_entity *prev)
 		update_stats_wait_start(cfs_rq, prev);
 		/* Put 'current' back into the tree. */
 		__enqueue_entity(cfs_rq, prev);
+		/* in !on_rq case, update occurred at dequeue */
+		update_entity_load_avg(prev);
 	}
 	cfs_rq->curr = NULL;
 }
@@ -1353,8 +1610,10 @@ entity_tick(struct cfs_rq *cfs_rq, struct sched_entity *curr, int queued)
 	update_curr(cfs_rq);
 
 	/*
-	 * Update share accounting for long-running entities.
+	 * Update the load average and share accounting for long-running
+	 * entities.
 	 */
+	update_entity_load_avg(curr);
 	update_entity_shares_tick(cfs_rq);
 
 #ifdef CONFIG_SCHED_HRTICK
@@ -2228,10 +2487,13 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 
 		update_cfs_load(cfs_rq, 0);
 		update_cfs_shares(cfs_rq);
+		update_entity_load_avg(se);
 	}
 
-	if (!se)
+	if (!se) {
+		update_rq_runnable_avg(rq, rq->nr_running);
 		inc_nr_running(rq);
+	}
 	hrtick_update(rq);
 }
 
@@ -2287,18 +2549,24 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 
 		update_cfs_load(cfs_rq, 0);
 		update_cfs_shares(cfs_rq);
+		update_entity_load_avg(se);
 	}
 
-	if (!se)
+	if (!se) {
+		update_rq_runnable_avg(rq, 1);
 		dec_nr_running(rq);
+	}
 	hrtick_update(rq);
 }
 
 #ifdef CONFIG_SMP
-/* Used instead of source_load when we know the type == 0 */
-static unsigned long weighted_cpuload(const int cpu)
+/*
+ * Used instead of source_load when we know the type == 0, and to feed
+ * cpu_load[] so that both see the same runnable average.
+ */
+unsigned long weighted_cpuload(const int cpu)
 {
-	return cpu_rq(cpu)->load.weight;
+	return cpu_rq(cpu)->cfs.runnable_load_avg;
 }
 
 /*
@@ -2342,10 +2610,11 @@ static unsigned long power_of(int cpu)
 static unsigned long cpu_avg_load_per_task(int cpu)
 {
 	struct rq *rq = cpu_rq(cpu);
-	unsigned long nr_running = ACCESS_ONCE(rq->nr_running);
+	unsigned long nr_running = ACCESS_ONCE(rq->cfs.h_nr_running);
 
+	/* runnable_load_avg only covers CFS tasks, so count only those */
 	if (nr_running)
-		return rq->load.weight / nr_running;
+		return rq->cfs.runnable_load_avg / nr_running;
 
 	return 0;
 }
@@ -2510,14 +2779,14 @@ static int wake_affine(struct sched_domain *sd, struct task_struct *p, int sync)
 	 */
 	if (sync) {
 		tg = task_group(current);
-		weight = current->se.load.weight;
+		weight = current->se.avg.load_avg_contrib;
 
 		this_load += effective_load(tg, this_cpu, -weight, -weight);
 		load += effective_load(tg, prev_cpu, 0, -weight);
 	}
 
 	tg = task_group(p);
-	weight = p->se.load.weight;
+	weight = p->se.avg.load_avg_contrib;
 
 	/*
 	 * In low-load situations, where prev_cpu is idle and this_cpu is idle
@@ -3381,11 +3650,11 @@ static int tg_load_down(struct task_group *tg, void *data)
 	long cpu = (long)data;
 
 	if (!tg->parent) {
-		load = cpu_rq(cpu)->load.weight;
+		load = cpu_rq(cpu)->cfs.runnable_load_avg;
 	} else {
 		load = tg->parent->cfs_rq[cpu]->h_load;
-		load *= tg->se[cpu]->load.weight;
-		load /= tg->parent->cfs_rq[cpu]->load.weight + 1;
+		load *= tg->se[cpu]->avg.load_avg_contrib;
+		load /= tg->parent->cfs_rq[cpu]->runnable_load_avg + 1;
 	}
 
 	tg->cfs_rq[cpu]->h_load = load;
@@ -3405,8 +3674,8 @@ static unsigned long task_h_load(struct task_struct *p)
 	struct cfs_rq *cfs_rq = task_cfs_rq(p);
 	unsigned long load;
 
-	load = p->se.load.weight;
-	load = div_u64(load * cfs_rq->h_load, cfs_rq->load.weight + 1);
+	load = p->se.avg.load_avg_contrib;
+	load = div_u64(load * cfs_rq->h_load, cfs_rq->runnable_load_avg + 1);
 
 	return load;
 }
@@ -3421,7 +3690,7 @@ static inline void update_h_load(long cpu)
 
 static unsigned long task_h_load(struct task_struct *p)
 {
-	return p->se.load.weight;
+	return p->se.avg.load_avg_contrib;
 }
 #endif
 
@@ -5190,6 +5459,8 @@ static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 		cfs_rq = cfs_rq_of(se);
 		entity_tick(cfs_rq, se, queued);
 	}
+
+	update_rq_runnable_avg(rq, 1);
 }
 
 /*
@@ -5227,6 +5498,7 @@ static void task_fork_fair(struct task_struct *p)
 	if (curr)
 		se->vruntime = curr->vruntime;
 	place_entity(cfs_rq, se, 1);
+	init_task_runnable_average(cfs_rq, p);
 
 	if (sysctl_sched_child_runs_first && curr && entity_before(curr, se)) {
 		/*
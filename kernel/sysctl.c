@@ -131,6 +131,9 @@ static int one_hundred = 100;
 #ifdef CONFIG_PRINTK
 static int ten_thousand = 10000;
 #endif
+#ifdef CONFIG_NO_HZ
+static int timer_coalesce_us_max = TIMER_COALESCE_US_MAX;
+#endif
 
 /* this is needed for the proc_doulongvec_minmax of vm_dirty_bytes */
 static unsigned long dirty_bytes_min = 2 * PAGE_SIZE;
@@ -259,6 +262,9 @@ static int max_sched_tunable_scaling = SCHED_TUNABLESCALING_END-1;
 #ifdef CONFIG_COMPACTION
 static int min_extfrag_threshold;
 static int max_extfrag_threshold = 1000;
+static int max_compaction_proactive_order = MAX_ORDER - 1;
+static int min_compaction_proactive_centisecs = 1;
+static int max_compaction_proactive_centisecs = 360000;	/* one hour */
 #endif
 
 static struct ctl_table kern_table[] = {
@@ -343,6 +349,17 @@ static struct ctl_table kern_table[] = {
 		.extra1		= &zero,
 		.extra2		= &one,
 	},
+#endif
+#ifdef CONFIG_NO_HZ
+	{
+		.procname	= "timer_coalesce_us",
+		.data		= &sysctl_timer_coalesce_us,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &timer_coalesce_us_max,
+	},
 #endif
 	{
 		.procname	= "sched_rt_period_us",
@@ -1052,6 +1069,16 @@ static struct ctl_table vm_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= &zero,
 	},
+#ifdef CONFIG_LAUNCH_READAHEAD
+	{
+		.procname	= "launch_readahead_secs",
+		.data		= &sysctl_launch_readahead_secs,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+	},
+#endif
 	{
 		.procname	= "dirty_background_ratio",
 		.data		= &dirty_background_ratio,
@@ -1195,6 +1222,33 @@ static struct ctl_table vm_table[] = {
 		.extra1		= &min_extfrag_threshold,
 		.extra2		= &max_extfrag_threshold,
 	},
+	{
+		.procname	= "compaction_proactive_order",
+		.data		= &sysctl_compaction_proactive_order,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &zero,
+		.extra2		= &max_compaction_proactive_order,
+	},
+	{
+		.procname	= "compaction_proactive_target",
+		.data		= &sysctl_compaction_proactive_target,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &min_extfrag_threshold,
+		.extra2		= &max_extfrag_threshold,
+	},
+	{
+		.procname	= "compaction_proactive_centisecs",
+		.data		= &sysctl_compaction_proactive_centisecs,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &min_compaction_proactive_centisecs,
+		.extra2		= &max_compaction_proactive_centisecs,
+	},
 
 #endif /* CONFIG_COMPACTION */
 	{
@@ -27,6 +27,7 @@
 #include <linux/cgroup.h>
 #include <linux/fs.h>
 #include <linux/file.h>
+#include <linux/pid_namespace.h>
 #include <net/genetlink.h>
 #include <linux/atomic.h>
 
@@ -51,7 +52,8 @@ static const struct nla_policy taskstats_cmd_get_policy[TASKSTATS_CMD_ATTR_MAX+1
 	[TASKSTATS_CMD_ATTR_PID]  = { .type = NLA_U32 },
 	[TASKSTATS_CMD_ATTR_TGID] = { .type = NLA_U32 },
 	[TASKSTATS_CMD_ATTR_REGISTER_CPUMASK] = { .type = NLA_STRING },
-	[TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK] = { .type = NLA_STRING },};
+	[TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK] = { .type = NLA_STRING },
+	[TASKSTATS_CMD_ATTR_CGROUP_FD] = { .type = NLA_U32 },};
 
 static const struct nla_policy cgroupstats_cmd_get_policy[CGROUPSTATS_CMD_ATTR_MAX+1] = {
 	[CGROUPSTATS_CMD_ATTR_FD] = { .type = NLA_U32 },
@@ -568,6 +570,96 @@ static int taskstats_user_cmd(struct sk_buff *skb, struct genl_info *info)
 		return -EINVAL;
 }
 
+/*
+ * A dump keeps the next pid to look at in cb->args[0], 0 before the
+ * first call, and the cgroup file to filter tasks by, if any, in
+ * cb->args[1].
+ */
+static int taskstats_dump_start(struct netlink_callback *cb)
+{
+	struct nlattr *attrs[TASKSTATS_CMD_ATTR_MAX + 1];
+	struct file *file;
+	int rc;
+
+	rc = nlmsg_parse(cb->nlh, GENL_HDRLEN, attrs, TASKSTATS_CMD_ATTR_MAX,
+			 taskstats_cmd_get_policy);
+	if (rc < 0)
+		return rc;
+
+	/* pid 0 is the idle task, which has no struct pid */
+	cb->args[0] = 1;
+	if (!attrs[TASKSTATS_CMD_ATTR_CGROUP_FD])
+		return 0;
+
+	file = fget(nla_get_u32(attrs[TASKSTATS_CMD_ATTR_CGROUP_FD]));
+	if (!file)
+		return -EBADF;
+	if (cgroupstats_has_task(file->f_dentry, current) < 0) {
+		fput(file);
+		return -EINVAL;
+	}
+	cb->args[1] = (long)file;
+	return 0;
+}
+
+/*
+ * Send the per-pid stats of all tasks, in pid order, as one
+ * TASKSTATS_CMD_NEW message each.  Every batch is filled under
+ * rcu_read_lock() alone, without taking a reference on any task.
+ */
+static int taskstats_user_dump(struct sk_buff *skb,
+			       struct netlink_callback *cb)
+{
+	struct pid_namespace *ns = task_active_pid_ns(current);
+	struct task_struct *tsk;
+	struct taskstats *stats;
+	struct file *file;
+	struct pid *pid;
+	void *reply;
+	int nr, rc;
+
+	if (!cb->args[0]) {
+		rc = taskstats_dump_start(cb);
+		if (rc < 0)
+			return rc;
+	}
+	file = (struct file *)cb->args[1];
+
+	rcu_read_lock();
+	for (nr = cb->args[0]; (pid = find_ge_pid(nr, ns)); nr++) {
+		nr = pid_nr_ns(pid, ns);
+		tsk = pid_task(pid, PIDTYPE_PID);
+		if (!tsk)
+			continue;
+		if (file && cgroupstats_has_task(file->f_dentry, tsk) <= 0)
+			continue;
+
+		reply = genlmsg_put(skb, NETLINK_CB(cb->skb).pid,
+				    cb->nlh->nlmsg_seq, &family, NLM_F_MULTI,
+				    TASKSTATS_CMD_NEW);
+		if (!reply)
+			break;
+		stats = mk_reply(skb, TASKSTATS_TYPE_PID, nr);
+		if (!stats) {
+			genlmsg_cancel(skb, reply);
+			break;
+		}
+		fill_stats(tsk, stats);
+		genlmsg_end(skb, reply);
+	}
+	rcu_read_unlock();
+
+	cb->args[0] = nr;
+	return skb->len;
+}
+
+static int taskstats_user_dump_done(struct netlink_callback *cb)
+{
+	if (cb->args[1])
+		fput((struct file *)cb->args[1]);
+	return 0;
+}
+
 static struct taskstats *taskstats_tgid_alloc(struct task_struct *tsk)
 {
 	struct signal_struct *sig = tsk->signal;
@@ -654,6 +746,8 @@ err:
 static struct genl_ops taskstats_ops = {
 	.cmd		= TASKSTATS_CMD_GET,
 	.doit		= taskstats_user_cmd,
+	.dumpit		= taskstats_user_dump,
+	.done		= taskstats_user_dump_done,
 	.policy		= taskstats_cmd_get_policy,
 	.flags		= GENL_ADMIN_PERM,
 };
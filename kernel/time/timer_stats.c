@@ -42,6 +42,7 @@
 #include <linux/sched.h>
 #include <linux/seq_file.h>
 #include <linux/kallsyms.h>
+#include <linux/kernel_stat.h>
 
 #include <asm/uaccess.h>
 
@@ -88,6 +89,22 @@ static DEFINE_RAW_SPINLOCK(table_lock);
  */
 static DEFINE_PER_CPU(raw_spinlock_t, tstats_lookup_lock);
 
+/*
+ * Per-CPU wakeup reasons, protected by the lookup lock of the CPU.
+ * Timers which expire from the same interrupt as an earlier one are
+ * counted as coalesced, the first timer of an interrupt which hit an
+ * idle CPU as a wakeup:
+ */
+struct cpu_stats {
+	unsigned long		events;
+	unsigned long		wakeups;
+	unsigned long		coalesced;
+	unsigned long		deferrable;
+	unsigned int		last_irqs;
+};
+
+static DEFINE_PER_CPU(struct cpu_stats, tstats_cpu);
+
 /*
  * Mutex to serialize state changes with show-stats activities:
  */
@@ -137,6 +154,11 @@ static struct entry *tstat_hash_table[TSTAT_HASH_SIZE] __read_mostly;
 
 static void reset_entries(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(tstats_cpu, cpu), 0, sizeof(struct cpu_stats));
+
 	nr_entries = 0;
 	memset(entries, 0, sizeof(entries));
 	memset(tstat_hash_table, 0, sizeof(tstat_hash_table));
@@ -240,12 +262,17 @@ void timer_stats_update_stats(void *timer, pid_t pid, void *startf,
 	 */
 	raw_spinlock_t *lock;
 	struct entry *entry, input;
+	struct cpu_stats *stats;
 	unsigned long flags;
+	unsigned int irqs;
+	int cpu;
 
 	if (likely(!timer_stats_active))
 		return;
 
-	lock = &per_cpu(tstats_lookup_lock, raw_smp_processor_id());
+	cpu = raw_smp_processor_id();
+	lock = &per_cpu(tstats_lookup_lock, cpu);
+	stats = &per_cpu(tstats_cpu, cpu);
 
 	input.timer = timer;
 	input.start_func = startf;
@@ -263,6 +290,16 @@ void timer_stats_update_stats(void *timer, pid_t pid, void *startf,
 	else
 		atomic_inc(&overflow_count);
 
+	stats->events++;
+	if (timer_flag & TIMER_STATS_FLAG_DEFERRABLE)
+		stats->deferrable++;
+	irqs = kstat_cpu_irqs_sum(cpu);
+	if (irqs == stats->last_irqs)
+		stats->coalesced++;
+	else if (idle_cpu(cpu))
+		stats->wakeups++;
+	stats->last_irqs = irqs;
+
  out_unlock:
 	raw_spin_unlock_irqrestore(lock, flags);
 }
@@ -298,7 +335,7 @@ static int tstats_show(struct seq_file *m, void *v)
 	period = ktime_to_timespec(time);
 	ms = period.tv_nsec / 1000000;
 
-	seq_puts(m, "Timer Stats Version: v0.2\n");
+	seq_puts(m, "Timer Stats Version: v0.3\n");
 	seq_printf(m, "Sample period: %ld.%03ld s\n", period.tv_sec, ms);
 	if (atomic_read(&overflow_count))
 		seq_printf(m, "Overflow: %d entries\n",
@@ -333,6 +370,14 @@ static int tstats_show(struct seq_file *m, void *v)
 	else
 		seq_printf(m, "%ld total events\n", events);
 
+	for_each_online_cpu(i) {
+		struct cpu_stats *stats = &per_cpu(tstats_cpu, i);
+
+		seq_printf(m, "cpu%d: %lu events, %lu idle wakeups, "
+			   "%lu coalesced, %lu deferrable\n", i, stats->events,
+			   stats->wakeups, stats->coalesced, stats->deferrable);
+	}
+
 	mutex_unlock(&show_mutex);
 
 	return 0;
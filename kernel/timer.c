@@ -783,6 +783,50 @@ int mod_timer_pending(struct timer_list *timer, unsigned long expires)
 }
 EXPORT_SYMBOL(mod_timer_pending);
 
+#ifdef CONFIG_NO_HZ
+unsigned int sysctl_timer_coalesce_us;
+
+/*
+ * Coalesce timers into one wakeup per window: move the latest allowed
+ * expiry down to a multiple of the window, provided that is not before
+ * the requested expiry.  jiffies is the same on all CPUs, so timers with
+ * overlapping slack end up expiring on the same tick wherever they are
+ * queued.  Deferrable timers don't wake an idle CPU in the first place,
+ * so they get up to a whole window of extra slack.
+ */
+static bool coalesce_timer(struct timer_list *timer, unsigned long expires,
+			   unsigned long *expires_limit)
+{
+	unsigned long window, limit;
+
+	if (!sysctl_timer_coalesce_us)
+		return false;
+
+	window = usecs_to_jiffies(sysctl_timer_coalesce_us);
+	if (window < 2)
+		return false;
+
+	limit = *expires_limit;
+	if (tbase_get_deferrable(timer->base) &&
+	    time_before(limit, expires + window - 1))
+		limit = expires + window - 1;
+
+	limit -= limit % window;
+	if (time_before(limit, expires))
+		return false;
+
+	*expires_limit = limit;
+	return true;
+}
+#else
+static inline bool coalesce_timer(struct timer_list *timer,
+				  unsigned long expires,
+				  unsigned long *expires_limit)
+{
+	return false;
+}
+#endif
+
 /*
  * Decide where to put the timer while taking the slack into account
  *
@@ -792,6 +836,9 @@ EXPORT_SYMBOL(mod_timer_pending);
  *   3) use this bit to make a mask
  *   4) use the bitmask to round down the maximum time, so that all last
  *      bits are zeros
+ *
+ * If timer coalescing is enabled and the coalescing window boundary
+ * falls between the expiry and the maximum time, that is used instead.
  */
 static inline
 unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
@@ -804,11 +851,13 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 	} else {
 		long delta = expires - jiffies;
 
-		if (delta < 256)
-			return expires;
-
-		expires_limit = expires + delta / 256;
+		expires_limit = expires;
+		if (delta >= 256)
+			expires_limit += delta / 256;
 	}
+	if (coalesce_timer(timer, expires, &expires_limit))
+		return expires_limit;
+
 	mask = expires ^ expires_limit;
 	if (mask == 0)
 		return expires;
@@ -56,6 +56,7 @@ void bacct_add_tsk(struct taskstats *stats, struct task_struct *tsk)
 	stats->ac_nice	 = task_nice(tsk);
 	stats->ac_sched	 = tsk->policy;
 	stats->ac_pid	 = tsk->pid;
+	stats->ac_tgid	 = tsk->tgid;
 	rcu_read_lock();
 	tcred = __task_cred(tsk);
 	stats->ac_uid	 = tcred->uid;
@@ -89,13 +90,20 @@ void xacct_add_tsk(struct taskstats *stats, struct task_struct *p)
 	/* convert pages-usec to Mbyte-usec */
 	stats->coremem = p->acct_rss_mem1 * PAGE_SIZE / MB;
 	stats->virtmem = p->acct_vm_mem1 * PAGE_SIZE / MB;
-	mm = get_task_mm(p);
-	if (mm) {
+	/*
+	 * Like get_task_mm(), but without taking a reference: mmput() may
+	 * sleep, and the taskstats dump fills in stats under rcu_read_lock().
+	 */
+	task_lock(p);
+	mm = p->mm;
+	if (mm && !(p->flags & PF_KTHREAD)) {
 		/* adjust to KB unit */
 		stats->hiwater_rss   = get_mm_hiwater_rss(mm) * PAGE_SIZE / KB;
 		stats->hiwater_vm    = get_mm_hiwater_vm(mm)  * PAGE_SIZE / KB;
-		mmput(mm);
+		stats->cur_rss	     = get_mm_rss(mm) * PAGE_SIZE / KB;
+		stats->cur_vm	     = mm->total_vm * PAGE_SIZE / KB;
 	}
+	task_unlock(p);
 	stats->read_char	= p->ioac.rchar & KB_MASK;
 	stats->write_char	= p->ioac.wchar & KB_MASK;
 	stats->read_syscalls	= p->ioac.syscr & KB_MASK;
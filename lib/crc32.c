@@ -53,7 +53,8 @@ MODULE_LICENSE("GPL");
 
 /* implements slicing-by-4 or slicing-by-8 algorithm */
 static inline u32
-crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
+crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256],
+	   const int rows)
 {
 # ifdef __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = t0[(crc ^ (x)) & 255] ^ (crc >> 8)
@@ -84,13 +85,13 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 		} while ((--len) && ((long)buf)&3);
 	}
 
-# if CRC_LE_BITS == 32
-	rem_len = len & 3;
-	len = len >> 2;
-# else
-	rem_len = len & 7;
-	len = len >> 3;
-# endif
+	if (rows == 4) {
+		rem_len = len & 3;
+		len = len >> 2;
+	} else {
+		rem_len = len & 7;
+		len = len >> 3;
+	}
 
 	b = (const u32 *)buf;
 # ifdef CONFIG_X86
@@ -100,13 +101,13 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 	for (--b; len; --len) {
 # endif
 		q = crc ^ *++b; /* use pre increment for speed */
-# if CRC_LE_BITS == 32
-		crc = DO_CRC4;
-# else
-		crc = DO_CRC8;
-		q = *++b;
-		crc ^= DO_CRC4;
-# endif
+		if (rows == 4) {
+			crc = DO_CRC4;
+		} else {
+			crc = DO_CRC8;
+			q = *++b;
+			crc ^= DO_CRC4;
+		}
 	}
 	len = rem_len;
 	/* And the last few bytes */
@@ -128,6 +129,44 @@ crc32_body(u32 crc, unsigned char const *buf, size_t len, const u32 (*tab)[256])
 }
 #endif
 
+static inline u32 __pure crc32_le_bitwise(u32 crc, unsigned char const *p,
+					  size_t len, u32 polynomial)
+{
+	int i;
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+	}
+	return crc;
+}
+
+/* aka Sarwate algorithm; the first row of any table of CRC_LE_BITS >= 8 */
+static inline u32 __pure crc32_le_sarwate(u32 crc, unsigned char const *p,
+					  size_t len, const u32 (*tab)[256])
+{
+	while (len--) {
+		crc ^= *p++;
+#if CRC_LE_BITS > 8
+		crc = (crc >> 8) ^ __le32_to_cpu((__force __le32)tab[0][crc & 255]);
+#else
+		crc = (crc >> 8) ^ tab[0][crc & 255];
+#endif
+	}
+	return crc;
+}
+
+#if CRC_LE_BITS > 8
+static inline u32 __pure crc32_le_slice(u32 crc, unsigned char const *p,
+					size_t len, const u32 (*tab)[256],
+					const int rows)
+{
+	crc = (__force u32) __cpu_to_le32(crc);
+	crc = crc32_body(crc, p, len, tab, rows);
+	return __le32_to_cpu((__force __le32)crc);
+}
+#endif
+
 /**
  * crc32_le() - Calculate bitwise little-endian Ethernet AUTODIN II CRC32
  * @crc: seed value for computation.  ~0 for Ethernet, sometimes 0 for
@@ -140,12 +179,7 @@ static inline u32 __pure crc32_le_generic(u32 crc, unsigned char const *p,
 					  u32 polynomial)
 {
 #if CRC_LE_BITS == 1
-	int i;
-	while (len--) {
-		crc ^= *p++;
-		for (i = 0; i < 8; i++)
-			crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
-	}
+	crc = crc32_le_bitwise(crc, p, len, polynomial);
 # elif CRC_LE_BITS == 2
 	while (len--) {
 		crc ^= *p++;
@@ -161,20 +195,78 @@ static inline u32 __pure crc32_le_generic(u32 crc, unsigned char const *p,
 		crc = (crc >> 4) ^ tab[0][crc & 15];
 	}
 # elif CRC_LE_BITS == 8
-	/* aka Sarwate algorithm */
-	while (len--) {
-		crc ^= *p++;
-		crc = (crc >> 8) ^ tab[0][crc & 255];
-	}
+	crc = crc32_le_sarwate(crc, p, len, tab);
 # else
-	crc = (__force u32) __cpu_to_le32(crc);
-	crc = crc32_body(crc, p, len, tab);
-	crc = __le32_to_cpu((__force __le32)crc);
+	crc = crc32_le_slice(crc, p, len, tab, CRC_LE_BITS / 8);
 #endif
 	return crc;
 }
 
-#if CRC_LE_BITS == 1
+#ifdef CONFIG_CRC32_RUNTIME
+/*
+ * All little-endian variants below run off the same slice-by-8 tables,
+ * so switching between them at runtime costs no extra memory.  The
+ * bitwise variant is kept as the reference for the self test and is
+ * never picked by the benchmark.
+ */
+struct crc32_impl {
+	const char *name;
+	u32 (*le)(u32 crc, unsigned char const *p, size_t len,
+		  const u32 (*tab)[256], u32 polynomial);
+};
+
+static u32 __pure crc32_le_impl_bitwise(u32 crc, unsigned char const *p,
+					size_t len, const u32 (*tab)[256],
+					u32 polynomial)
+{
+	return crc32_le_bitwise(crc, p, len, polynomial);
+}
+
+static u32 __pure crc32_le_impl_sarwate(u32 crc, unsigned char const *p,
+					size_t len, const u32 (*tab)[256],
+					u32 polynomial)
+{
+	return crc32_le_sarwate(crc, p, len, tab);
+}
+
+static u32 __pure crc32_le_impl_slice4(u32 crc, unsigned char const *p,
+				       size_t len, const u32 (*tab)[256],
+				       u32 polynomial)
+{
+	return crc32_le_slice(crc, p, len, tab, 4);
+}
+
+static u32 __pure crc32_le_impl_slice8(u32 crc, unsigned char const *p,
+				       size_t len, const u32 (*tab)[256],
+				       u32 polynomial)
+{
+	return crc32_le_slice(crc, p, len, tab, 8);
+}
+
+static const struct crc32_impl crc32_impls[] = {
+	{ "bitwise",	crc32_le_impl_bitwise },
+	{ "sarwate",	crc32_le_impl_sarwate },
+	{ "slice-by-4",	crc32_le_impl_slice4 },
+	{ "slice-by-8",	crc32_le_impl_slice8 },
+};
+
+/* Used until the boot time benchmark has run */
+static const struct crc32_impl *crc32_le_impl = &crc32_impls[3];
+
+static char *impl;
+module_param(impl, charp, 0444);
+MODULE_PARM_DESC(impl, "Force a little-endian CRC32/CRC32c implementation "
+		 "(bitwise, sarwate, slice-by-4, slice-by-8)");
+
+u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_le_impl->le(crc, p, len, crc32table_le, CRCPOLY_LE);
+}
+u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_le_impl->le(crc, p, len, crc32ctable_le, CRC32C_POLY_LE);
+}
+#elif CRC_LE_BITS == 1
 u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len, NULL, CRCPOLY_LE);
@@ -237,7 +329,7 @@ static inline u32 __pure crc32_be_generic(u32 crc, unsigned char const *p,
 	}
 # else
 	crc = (__force u32) __cpu_to_be32(crc);
-	crc = crc32_body(crc, p, len, tab);
+	crc = crc32_body(crc, p, len, tab, CRC_BE_BITS / 8);
 	crc = __be32_to_cpu((__force __be32)crc);
 # endif
 	return crc;
@@ -256,6 +348,94 @@ u32 __pure crc32_be(u32 crc, unsigned char const *p, size_t len)
 #endif
 EXPORT_SYMBOL(crc32_be);
 
+#ifdef CONFIG_CRC32_RUNTIME
+
+#include <linux/math64.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/time.h>
+
+#define CRC32_BENCH_LEN		4096
+#define CRC32_BENCH_LOOPS	16
+#define CRC32_BENCH_RUNS	4
+
+/* best of CRC32_BENCH_RUNS runs, in nanoseconds */
+static u64 __init crc32_bench_one(const struct crc32_impl *ci, const u8 *buf)
+{
+	struct timespec start, stop;
+	unsigned long flags;
+	u64 nsec, best = ~0ULL;
+	/* keep static so the loop is not optimized away */
+	static u32 crc;
+	int run, i;
+
+	for (run = 0; run < CRC32_BENCH_RUNS; run++) {
+		local_irq_save(flags);
+		getnstimeofday(&start);
+		for (i = 0; i < CRC32_BENCH_LOOPS; i++)
+			crc ^= ci->le(crc, buf, CRC32_BENCH_LEN,
+				      crc32table_le, CRCPOLY_LE);
+		getnstimeofday(&stop);
+		local_irq_restore(flags);
+
+		nsec = stop.tv_nsec - start.tv_nsec +
+			1000000000ULL * (stop.tv_sec - start.tv_sec);
+		if (nsec < best)
+			best = nsec;
+	}
+
+	return best ?: 1;
+}
+
+static void __init crc32_select_impl(void)
+{
+	const struct crc32_impl *ci, *best = crc32_le_impl;
+	u64 nsec, best_nsec = ~0ULL;
+	u8 *buf;
+	int i;
+
+	if (impl) {
+		for (i = 0; i < ARRAY_SIZE(crc32_impls); i++) {
+			if (!strcmp(impl, crc32_impls[i].name)) {
+				crc32_le_impl = &crc32_impls[i];
+				pr_info("crc32: using %s (forced)\n",
+					crc32_le_impl->name);
+				return;
+			}
+		}
+		pr_warn("crc32: unknown implementation '%s'\n", impl);
+	}
+
+	buf = kmalloc(CRC32_BENCH_LEN, GFP_KERNEL);
+	if (!buf) {
+		pr_info("crc32: using %s\n", crc32_le_impl->name);
+		return;
+	}
+	get_random_bytes(buf, CRC32_BENCH_LEN);
+
+	/* skip the bitwise reference */
+	for (i = 1; i < ARRAY_SIZE(crc32_impls); i++) {
+		ci = &crc32_impls[i];
+		nsec = crc32_bench_one(ci, buf);
+		pr_info("crc32: %-10s %6llu MB/s\n", ci->name,
+			div64_u64((u64)CRC32_BENCH_LEN * CRC32_BENCH_LOOPS *
+				  1000, nsec));
+		if (nsec < best_nsec) {
+			best_nsec = nsec;
+			best = ci;
+		}
+	}
+	kfree(buf);
+
+	crc32_le_impl = best;
+	pr_info("crc32: using %s for crc32_le and __crc32c_le\n", best->name);
+}
+#else
+static inline void crc32_select_impl(void)
+{
+}
+#endif /* CONFIG_CRC32_RUNTIME */
+
 #ifdef CONFIG_CRC32_SELFTEST
 
 /* 4096 random bytes */
@@ -1099,10 +1279,73 @@ static int __init crc32_test(void)
 	return 0;
 }
 
-static int __init crc32test_init(void)
+#ifdef CONFIG_CRC32_RUNTIME
+/*
+ * Check every runtime-selectable implementation against the bitwise
+ * reference over random lengths, alignments and seeds.
+ */
+static int __init crc32_impl_test(void)
+{
+	struct rnd_state rnd;
+	int i, j, errors = 0;
+
+	prandom32_seed(&rnd, 0x6372633332ULL);
+
+	for (i = 0; i < 1000; i++) {
+		u32 seed = prandom32(&rnd);
+		size_t start = prandom32(&rnd) & 63;
+		size_t len = prandom32(&rnd) % (sizeof(test_buf) - start);
+		u32 ref_le, ref_c;
+
+		ref_le = crc32_le_bitwise(seed, test_buf + start, len,
+					  CRCPOLY_LE);
+		ref_c = crc32_le_bitwise(seed, test_buf + start, len,
+					 CRC32C_POLY_LE);
+
+		for (j = 1; j < ARRAY_SIZE(crc32_impls); j++) {
+			const struct crc32_impl *ci = &crc32_impls[j];
+
+			if (ci->le(seed, test_buf + start, len,
+				   crc32table_le, CRCPOLY_LE) != ref_le ||
+			    ci->le(seed, test_buf + start, len,
+				   crc32ctable_le, CRC32C_POLY_LE) != ref_c) {
+				pr_warn("crc32: %s mismatch, start %zu len %zu\n",
+					ci->name, start, len);
+				errors++;
+			}
+		}
+	}
+
+	if (errors)
+		pr_warn("crc32: %d implementation tests failed\n", errors);
+	else
+		pr_info("crc32: implementation tests passed\n");
+
+	return errors;
+}
+#else
+static inline int crc32_impl_test(void)
+{
+	return 0;
+}
+#endif /* CONFIG_CRC32_RUNTIME */
+
+static void __init crc32_selftest(void)
 {
 	crc32_test();
 	crc32c_test();
+	crc32_impl_test();
+}
+#else
+static inline void crc32_selftest(void)
+{
+}
+#endif /* CONFIG_CRC32_SELFTEST */
+
+static int __init crc32_init(void)
+{
+	crc32_select_impl();
+	crc32_selftest();
 	return 0;
 }
 
@@ -1110,6 +1353,5 @@ static void __exit crc32_exit(void)
 {
 }
 
-module_init(crc32test_init);
+module_init(crc32_init);
 module_exit(crc32_exit);
-#endif /* CONFIG_CRC32_SELFTEST */
@@ -14,6 +14,10 @@
 #define CRC32C_POLY_LE 0x82F63B78
 
 /* Try to choose an implementation variant via Kconfig */
+#ifdef CONFIG_CRC32_RUNTIME
+# define CRC_LE_BITS 64
+# define CRC_BE_BITS 64
+#endif
 #ifdef CONFIG_CRC32_SLICEBY8
 # define CRC_LE_BITS 64
 # define CRC_BE_BITS 64
@@ -14,6 +14,9 @@
 #include <linux/backing-dev.h>
 #include <linux/sysctl.h>
 #include <linux/sysfs.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/ktime.h>
 #include "internal.h"
 
 #if defined CONFIG_COMPACTION || defined CONFIG_CMA
@@ -753,6 +756,7 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 	struct zoneref *z;
 	struct zone *zone;
 	int rc = COMPACT_SKIPPED;
+	ktime_t start;
 
 	/*
 	 * Check whether it is worth even starting compaction. The order check is
@@ -763,6 +767,7 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 		return rc;
 
 	count_vm_event(COMPACTSTALL);
+	start = ktime_get();
 
 	/* Compact each zone in the list */
 	for_each_zone_zonelist_nodemask(zone, z, zonelist, high_zoneidx,
@@ -777,6 +782,9 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 			break;
 	}
 
+	count_vm_events(COMPACTSTALLTIME,
+			ktime_us_delta(ktime_get(), start));
+
 	return rc;
 }
 
@@ -872,6 +880,192 @@ int sysctl_extfrag_handler(struct ctl_table *table, int write,
 	return 0;
 }
 
+/*
+ * Proactive compaction: one kcompactd thread per node wakes up every
+ * compaction_proactive_centisecs and, if the machine is not busy,
+ * compacts the zones whose fragmentation index for
+ * compaction_proactive_order is above compaction_proactive_target, so
+ * that high-order allocations find a free block instead of stalling in
+ * direct compaction.  Runs that find no zone to compact or do not reach
+ * the target back off exponentially, like deferred direct compaction,
+ * and the thread sleeps on a deferrable timer, so that it does not wake
+ * up an idle system just to look at the fragmentation.
+ */
+int sysctl_compaction_proactive_order = PAGE_ALLOC_COSTLY_ORDER + 1;
+int sysctl_compaction_proactive_target = 500;
+int sysctl_compaction_proactive_centisecs = 50;
+
+int sysctl_compaction_proactive_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int ret, nid;
+
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	/* Let the threads pick up the new settings right away */
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		wake_up_interruptible(&NODE_DATA(nid)->kcompactd_wait);
+
+	return 0;
+}
+
+/*
+ * Only compact in the background when there is an idle CPU to do it on,
+ * i.e. when the other runnable tasks leave at least one CPU to kcompactd.
+ * nr_running() counts the calling kcompactd too.
+ */
+static bool kcompactd_system_busy(void)
+{
+	return nr_running() - 1 >= num_online_cpus();
+}
+
+/*
+ * Returns true if a zone was compacted and every zone that was compacted
+ * reached the target.
+ */
+static bool kcompactd_do_work(pg_data_t *pgdat, int order, int target)
+{
+	bool success = true;
+	int compacted = 0;
+	int zoneid;
+
+	lru_add_drain();
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+		struct compact_control cc = {
+			.order = order,
+			.migratetype = MIGRATE_MOVABLE,
+			.zone = zone,
+			.sync = false,
+		};
+		ktime_t start;
+
+		if (!populated_zone(zone))
+			continue;
+
+		if (fragmentation_index(zone, order) <= target)
+			continue;
+
+		if (kthread_should_stop() || kcompactd_system_busy())
+			break;
+
+		INIT_LIST_HEAD(&cc.freepages);
+		INIT_LIST_HEAD(&cc.migratepages);
+
+		count_vm_event(COMPACTPROACTIVE);
+		start = ktime_get();
+		compact_zone(zone, &cc);
+		count_vm_events(COMPACTPROACTIVETIME,
+				ktime_us_delta(ktime_get(), start));
+		compacted++;
+
+		if (fragmentation_index(zone, order) <= target) {
+			count_vm_event(COMPACTPROACTIVESUCCESS);
+		} else {
+			count_vm_event(COMPACTPROACTIVEFAIL);
+			success = false;
+		}
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+
+	return compacted && success;
+}
+
+static void kcompactd_timeout(unsigned long data)
+{
+	wake_up_process((struct task_struct *)data);
+}
+
+/*
+ * Sleep for @timeout, or until the sysctls are changed or the thread is
+ * to stop.  Like schedule_timeout(), but with a deferrable timer.  A
+ * @timeout of MAX_SCHEDULE_TIMEOUT arms no timer at all.
+ */
+static void kcompactd_sleep(pg_data_t *pgdat, unsigned long timeout)
+{
+	struct timer_list timer;
+	DEFINE_WAIT(wait);
+	bool timed = timeout != MAX_SCHEDULE_TIMEOUT;
+
+	prepare_to_wait(&pgdat->kcompactd_wait, &wait, TASK_INTERRUPTIBLE);
+	if (timed) {
+		setup_deferrable_timer_on_stack(&timer, kcompactd_timeout,
+						(unsigned long)current);
+		mod_timer(&timer, jiffies + timeout);
+	}
+	if (!kthread_should_stop())
+		freezable_schedule();
+	finish_wait(&pgdat->kcompactd_wait, &wait);
+	if (timed) {
+		del_singleshot_timer_sync(&timer);
+		destroy_timer_on_stack(&timer);
+	}
+}
+
+static int kcompactd(void *p)
+{
+	pg_data_t *pgdat = p;
+	unsigned int defer_shift = 0;
+
+	set_freezable();
+	set_user_nice(current, 19);
+
+	while (!kthread_should_stop()) {
+		int order = sysctl_compaction_proactive_order;
+		unsigned long timeout;
+
+		/* Disabled: sleep until the sysctls change */
+		if (!order)
+			timeout = MAX_SCHEDULE_TIMEOUT;
+		else
+			timeout = msecs_to_jiffies(
+				sysctl_compaction_proactive_centisecs * 10)
+				<< defer_shift;
+		kcompactd_sleep(pgdat, timeout);
+
+		if (!order || kthread_should_stop() || kcompactd_system_busy())
+			continue;
+
+		if (kcompactd_do_work(pgdat, order,
+				      sysctl_compaction_proactive_target))
+			defer_shift = 0;
+		else if (defer_shift < COMPACT_MAX_DEFER_SHIFT)
+			defer_shift++;
+	}
+
+	return 0;
+}
+
+static int __init kcompactd_run(int nid)
+{
+	pg_data_t *pgdat = NODE_DATA(nid);
+
+	pgdat->kcompactd = kthread_run(kcompactd, pgdat, "kcompactd%d", nid);
+	if (IS_ERR(pgdat->kcompactd)) {
+		pr_err("Failed to start kcompactd on node %d\n", nid);
+		pgdat->kcompactd = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int __init kcompactd_init(void)
+{
+	int nid;
+
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		kcompactd_run(nid);
+
+	return 0;
+}
+module_init(kcompactd_init)
+
 #if defined(CONFIG_SYSFS) && defined(CONFIG_NUMA)
 ssize_t sysfs_compact_node(struct device *dev,
 			struct device_attribute *attr,
@@ -189,6 +189,19 @@ static unsigned int ksm_thread_pages_to_scan = 100;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/* Back off when a full scan merges less than ksm_min_yield per mille */
+static unsigned int ksm_adaptive_scan = 1;
+static unsigned int ksm_min_yield = 10;
+
+/* ksmd sleeps sleep_millisecs << ksm_scan_backoff between batches */
+#define KSM_MAX_BACKOFF	6
+static unsigned int ksm_scan_backoff;
+static bool ksm_scan_boost;
+
+/* Pages scanned and merged during the current full scan */
+static unsigned long ksm_pass_scanned;
+static unsigned long ksm_pass_merged;
+
 #define KSM_RUN_STOP	0
 #define KSM_RUN_MERGE	1
 #define KSM_RUN_UNMERGE	2
@@ -673,12 +686,27 @@ error:
 }
 #endif /* CONFIG_SYSFS */
 
+/*
+ * The checksum only tells whether a page changed since it was last
+ * scanned, so hash a few chunks spread over the page rather than all of
+ * it.  A page that only changes outside the sampled chunks can still get
+ * into the unstable tree, which is fine: the tree is allowed to be a bit
+ * wrong and merging always compares the whole page.
+ */
+#define KSM_CHECKSUM_CHUNKS	8
+#define KSM_CHECKSUM_WORDS	16
+#define KSM_CHECKSUM_STRIDE	(PAGE_SIZE / 4 / KSM_CHECKSUM_CHUNKS)
+
 static u32 calc_checksum(struct page *page)
 {
-	u32 checksum;
-	void *addr = kmap_atomic(page);
-	checksum = jhash2(addr, PAGE_SIZE / 4, 17);
-	kunmap_atomic(addr);
+	u32 checksum = 17;
+	u32 *kaddr = kmap_atomic(page);
+	u32 *addr = kaddr;
+	int i;
+
+	for (i = 0; i < KSM_CHECKSUM_CHUNKS; i++, addr += KSM_CHECKSUM_STRIDE)
+		checksum = jhash2(addr, KSM_CHECKSUM_WORDS, checksum);
+	kunmap_atomic(kaddr);
 	return checksum;
 }
 
@@ -939,6 +967,9 @@ static int try_to_merge_with_ksm_page(struct rmap_item *rmap_item,
 	if (err)
 		goto out;
 
+	vma->ksm_merged++;
+	ksm_pass_merged++;
+
 	/* Must get reference to anon_vma while still holding mmap_sem */
 	rmap_item->anon_vma = vma->anon_vma;
 	get_anon_vma(vma->anon_vma);
@@ -1351,6 +1382,8 @@ next_mm:
 					ksm_scan.rmap_list =
 							&rmap_item->rmap_list;
 					ksm_scan.address += PAGE_SIZE;
+					vma->ksm_scanned++;
+					ksm_pass_scanned++;
 				} else
 					put_page(*page);
 				up_read(&mm->mmap_sem);
@@ -1427,6 +1460,24 @@ static void ksm_do_scan(unsigned int scan_npages)
 	}
 }
 
+/*
+ * Called after each full scan: slow down while merging does not pay for
+ * the scanning, go back to full speed as soon as it does again.
+ */
+static void ksm_adapt_scan_rate(void)
+{
+	if (!ksm_adaptive_scan)
+		ksm_scan_backoff = 0;
+	else if (ksm_pass_merged * 1000 < ksm_pass_scanned * ksm_min_yield) {
+		if (ksm_scan_backoff < KSM_MAX_BACKOFF)
+			ksm_scan_backoff++;
+	} else
+		ksm_scan_backoff = 0;
+
+	ksm_pass_scanned = 0;
+	ksm_pass_merged = 0;
+}
+
 static int ksmd_should_run(void)
 {
 	return (ksm_run & KSM_RUN_MERGE) && !list_empty(&ksm_mm_head.mm_list);
@@ -1439,15 +1490,23 @@ static int ksm_scan_thread(void *nothing)
 
 	while (!kthread_should_stop()) {
 		mutex_lock(&ksm_thread_mutex);
-		if (ksmd_should_run())
+		if (ksmd_should_run()) {
+			unsigned long seqnr = ksm_scan.seqnr;
+
 			ksm_do_scan(ksm_thread_pages_to_scan);
+			if (ksm_scan.seqnr != seqnr)
+				ksm_adapt_scan_rate();
+		}
 		mutex_unlock(&ksm_thread_mutex);
 
 		try_to_freeze();
 
 		if (ksmd_should_run()) {
-			schedule_timeout_interruptible(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+			wait_event_freezable_timeout(ksm_thread_wait,
+				ksm_scan_boost || kthread_should_stop(),
+				msecs_to_jiffies(ksm_thread_sleep_millisecs) <<
+				ksm_scan_backoff);
+			ksm_scan_boost = false;
 		} else {
 			wait_event_freezable(ksm_thread_wait,
 				ksmd_should_run() || kthread_should_stop());
@@ -1524,6 +1583,16 @@ int __ksm_enter(struct mm_struct *mm)
 	set_bit(MMF_VM_MERGEABLE, &mm->flags);
 	atomic_inc(&mm->mm_count);
 
+	/*
+	 * A new mergeable mm, typically a fork of the zygote, is likely to
+	 * share a lot with the others: scan at full speed again.
+	 */
+	if (ksm_scan_backoff) {
+		ksm_scan_backoff = 0;
+		ksm_scan_boost = true;
+		needs_wakeup = 1;
+	}
+
 	if (needs_wakeup)
 		wake_up_interruptible(&ksm_thread_wait);
 
@@ -1876,6 +1945,65 @@ static ssize_t pages_to_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(pages_to_scan);
 
+static ssize_t adaptive_scan_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_adaptive_scan);
+}
+
+static ssize_t adaptive_scan_store(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   const char *buf, size_t count)
+{
+	int err;
+	unsigned long flags;
+
+	err = strict_strtoul(buf, 10, &flags);
+	if (err || flags > 1)
+		return -EINVAL;
+
+	mutex_lock(&ksm_thread_mutex);
+	ksm_adaptive_scan = flags;
+	if (!flags)
+		ksm_scan_backoff = 0;
+	mutex_unlock(&ksm_thread_mutex);
+
+	return count;
+}
+KSM_ATTR(adaptive_scan);
+
+static ssize_t min_yield_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_min_yield);
+}
+
+static ssize_t min_yield_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	int err;
+	unsigned long yield;
+
+	err = strict_strtoul(buf, 10, &yield);
+	if (err || yield > 1000)
+		return -EINVAL;
+
+	ksm_min_yield = yield;
+
+	return count;
+}
+KSM_ATTR(min_yield);
+
+static ssize_t current_sleep_millisecs_show(struct kobject *kobj,
+					    struct kobj_attribute *attr,
+					    char *buf)
+{
+	return sprintf(buf, "%lu\n", (unsigned long)ksm_thread_sleep_millisecs
+		       << ksm_scan_backoff);
+}
+KSM_ATTR_RO(current_sleep_millisecs);
+
 static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
 			char *buf)
 {
@@ -1974,6 +2102,9 @@ KSM_ATTR_RO(full_scans);
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
+	&adaptive_scan_attr.attr,
+	&min_yield_attr.attr,
+	&current_sleep_millisecs_attr.attr,
 	&run_attr.attr,
 	&pages_shared_attr.attr,
 	&pages_sharing_attr.attr,
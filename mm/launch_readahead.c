@@ -0,0 +1,548 @@
+/*
+ * mm/launch_readahead.c - replay the page faults of previous launches
+ *
+ * Applications fault in their mmap'd APK, odex and library files in a
+ * random order that ondemand_readahead() cannot predict, paying one
+ * small synchronous read per fault while they start up.  Record which
+ * file pages get faulted during the first launch_readahead_secs of a
+ * new mm, which covers both exec and a fork of the zygote, and the next
+ * time a new mm faults on the same file read all of them in one batch.
+ * Ranges that none of the last few launches faulted on, including hits
+ * on pages a replay brought in, are forgotten again.
+ *
+ * The history is kept per inode, keyed by device and inode number, and
+ * dropped when the inode's generation changes.  It can be saved and
+ * restored across reboots through <debugfs>/launch_readahead, one inode
+ * per line:
+ *
+ *	<major>:<minor> <ino> <generation> <start>+<nr_pages> ...
+ *
+ * Copyright (C) 2013
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/blkdev.h>
+#include <linux/ctype.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/hash.h>
+#include <linux/jiffies.h>
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/readahead.h>
+
+#define LAUNCH_RA_HASH_BITS	8
+#define LAUNCH_RA_MAX_HISTORY	512	/* inodes remembered */
+#define LAUNCH_RA_MAX_EXTENTS	64	/* ranges remembered per inode */
+#define LAUNCH_RA_MERGE_GAP	4	/* pages read to join two ranges */
+#define LAUNCH_RA_JOIN_GAP	64	/* largest gap bridged to make room */
+#define LAUNCH_RA_MAX_AGE	4	/* launches a range may go unused */
+#define LAUNCH_RA_MAX_PAGES	4096	/* pages replayed per inode */
+
+int sysctl_launch_readahead_secs = 5;
+
+struct launch_ra_extent {
+	pgoff_t start;
+	unsigned long nr;
+	unsigned int seen;	/* launch that last faulted on it */
+};
+
+/**
+ * struct launch_ra_history - file pages faulted during launches
+ * @hash:	entry in launch_ra_hash
+ * @lru:	entry in launch_ra_lru, most recently used first
+ * @rcu:	for freeing under RCU, the fault path looks up without
+ *		launch_ra_lock
+ * @dev:	device of the inode
+ * @ino:	inode number
+ * @lock:	protects the fields below
+ * @generation:	i_generation of the inode
+ * @was_replayed: @replayed is valid
+ * @replayed:	jiffies of the last replay
+ * @launches:	number of launches seen, to age the extents
+ * @nr_extents:	number of valid entries in @extents
+ * @extents:	faulted page ranges, sorted and non-overlapping
+ */
+struct launch_ra_history {
+	struct hlist_node hash;
+	struct list_head lru;
+	struct rcu_head rcu;
+	dev_t dev;
+	unsigned long ino;
+	spinlock_t lock;
+	u32 generation;
+	bool was_replayed;
+	unsigned long replayed;
+	unsigned int launches;
+	unsigned int nr_extents;
+	struct launch_ra_extent extents[LAUNCH_RA_MAX_EXTENTS];
+};
+
+/* protects launch_ra_hash, launch_ra_lru and launch_ra_nr_history */
+static DEFINE_SPINLOCK(launch_ra_lock);
+static struct hlist_head launch_ra_hash[1 << LAUNCH_RA_HASH_BITS];
+static LIST_HEAD(launch_ra_lru);
+static unsigned int launch_ra_nr_history;
+
+static struct hlist_head *launch_ra_bucket(dev_t dev, unsigned long ino)
+{
+	return &launch_ra_hash[hash_long(ino ^ dev, LAUNCH_RA_HASH_BITS)];
+}
+
+/* Called with launch_ra_lock or rcu_read_lock held */
+static struct launch_ra_history *launch_ra_lookup(dev_t dev,
+						  unsigned long ino)
+{
+	struct launch_ra_history *h;
+	struct hlist_node *node;
+
+	hlist_for_each_entry_rcu(h, node, launch_ra_bucket(dev, ino), hash)
+		if (h->dev == dev && h->ino == ino)
+			return h;
+
+	return NULL;
+}
+
+/*
+ * Called with launch_ra_lock held.  Inserts @new unless there already
+ * is a history for its inode, returns the history in the table.
+ */
+static struct launch_ra_history *
+launch_ra_insert(struct launch_ra_history *new)
+{
+	struct launch_ra_history *h;
+
+	h = launch_ra_lookup(new->dev, new->ino);
+	if (h)
+		return h;
+
+	if (launch_ra_nr_history >= LAUNCH_RA_MAX_HISTORY) {
+		h = list_entry(launch_ra_lru.prev, struct launch_ra_history,
+			       lru);
+		hlist_del_rcu(&h->hash);
+		list_del(&h->lru);
+		kfree_rcu(h, rcu);
+		launch_ra_nr_history--;
+	}
+
+	hlist_add_head_rcu(&new->hash, launch_ra_bucket(new->dev, new->ino));
+	list_add(&new->lru, &launch_ra_lru);
+	launch_ra_nr_history++;
+
+	return new;
+}
+
+static struct launch_ra_history *launch_ra_alloc(dev_t dev, unsigned long ino,
+						 u32 generation)
+{
+	struct launch_ra_history *h;
+
+	h = kzalloc(sizeof(*h), GFP_KERNEL);
+	if (!h)
+		return NULL;
+	h->dev = dev;
+	h->ino = ino;
+	h->generation = generation;
+	spin_lock_init(&h->lock);
+
+	return h;
+}
+
+/* Number of launches since @e was last faulted on */
+static unsigned int launch_ra_age(struct launch_ra_history *h,
+				  struct launch_ra_extent *e)
+{
+	return h->launches - e->seen;
+}
+
+/* Called with h->lock held: forget the extents no recent launch used */
+static void launch_ra_expire(struct launch_ra_history *h)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < h->nr_extents; i++)
+		if (launch_ra_age(h, &h->extents[i]) <= LAUNCH_RA_MAX_AGE)
+			h->extents[n++] = h->extents[i];
+	h->nr_extents = n;
+}
+
+/*
+ * Called with h->lock held and all extents in use.  Joins the two
+ * closest extents if they are at most LAUNCH_RA_JOIN_GAP pages apart,
+ * else drops the extent that went unused for the most launches.
+ * Returns false if every extent was used by the current launch.
+ */
+static bool launch_ra_make_room(struct launch_ra_history *h)
+{
+	struct launch_ra_extent *e = h->extents;
+	unsigned int j, best, victim;
+
+	best = 0;
+	for (j = 1; j < h->nr_extents - 1; j++)
+		if (e[j + 1].start - (e[j].start + e[j].nr) <
+		    e[best + 1].start - (e[best].start + e[best].nr))
+			best = j;
+
+	if (e[best + 1].start - (e[best].start + e[best].nr) <=
+	    LAUNCH_RA_JOIN_GAP) {
+		if (launch_ra_age(h, &e[best + 1]) < launch_ra_age(h, &e[best]))
+			e[best].seen = e[best + 1].seen;
+		e[best].nr = e[best + 1].start + e[best + 1].nr -
+			     e[best].start;
+		victim = best + 1;
+	} else {
+		victim = 0;
+		for (j = 1; j < h->nr_extents; j++)
+			if (launch_ra_age(h, &e[j]) >
+			    launch_ra_age(h, &e[victim]))
+				victim = j;
+		if (!launch_ra_age(h, &e[victim]))
+			return false;
+	}
+
+	memmove(&e[victim], &e[victim + 1],
+		(h->nr_extents - victim - 1) * sizeof(*e));
+	h->nr_extents--;
+	return true;
+}
+
+/* Called with h->lock held: a launch faulted on a cached page */
+static void launch_ra_touch(struct launch_ra_history *h, pgoff_t offset)
+{
+	struct launch_ra_extent *e = h->extents;
+	unsigned int i;
+
+	for (i = 0; i < h->nr_extents && e[i].start <= offset; i++)
+		if (offset < e[i].start + e[i].nr) {
+			e[i].seen = h->launches;
+			break;
+		}
+}
+
+/* Called with h->lock held, or before @h is inserted */
+static void launch_ra_add_range(struct launch_ra_history *h, pgoff_t start,
+				unsigned long nr)
+{
+	struct launch_ra_extent *e = h->extents;
+	unsigned int i, j;
+	pgoff_t end = start + nr;
+
+	/* find the first extent that does not end before @start */
+	for (i = 0; i < h->nr_extents; i++)
+		if (e[i].start + e[i].nr + LAUNCH_RA_MERGE_GAP >= start)
+			break;
+
+	if (i < h->nr_extents && e[i].start <= end + LAUNCH_RA_MERGE_GAP) {
+		/* overlaps or is close to e[i], and maybe to the ones after */
+		start = min(start, e[i].start);
+		end = max(end, e[i].start + e[i].nr);
+		for (j = i + 1; j < h->nr_extents &&
+		     e[j].start <= end + LAUNCH_RA_MERGE_GAP; j++)
+			end = max(end, e[j].start + e[j].nr);
+		e[i].start = start;
+		e[i].nr = end - start;
+		e[i].seen = h->launches;
+		memmove(&e[i + 1], &e[j],
+			(h->nr_extents - j) * sizeof(*e));
+		h->nr_extents -= j - i - 1;
+		return;
+	}
+
+	if (h->nr_extents == LAUNCH_RA_MAX_EXTENTS) {
+		/* the range may now fall into or next to a joined extent */
+		if (launch_ra_make_room(h))
+			launch_ra_add_range(h, start, nr);
+		return;
+	}
+
+	memmove(&e[i + 1], &e[i], (h->nr_extents - i) * sizeof(*e));
+	e[i].start = start;
+	e[i].nr = nr;
+	e[i].seen = h->launches;
+	h->nr_extents++;
+}
+
+static void launch_ra_replay(struct file *file, struct inode *inode,
+			     struct launch_ra_extent *extents,
+			     unsigned int nr_extents)
+{
+	struct address_space *mapping = file->f_mapping;
+	unsigned long nr_pages = 0;
+	struct blk_plug plug;
+	unsigned int i;
+
+	blk_start_plug(&plug);
+	for (i = 0; i < nr_extents && nr_pages < LAUNCH_RA_MAX_PAGES; i++) {
+		unsigned long nr = min(extents[i].nr,
+				       LAUNCH_RA_MAX_PAGES - nr_pages);
+
+		force_page_cache_readahead(mapping, file, extents[i].start, nr);
+		nr_pages += nr;
+	}
+	blk_finish_plug(&plug);
+
+	trace_mm_launch_readahead(inode, i, nr_pages);
+}
+
+/**
+ * launch_readahead_fault - record a page fault and replay past launches
+ * @vma:	vma in which the fault was taken
+ * @file:	the file mapped by @vma
+ * @offset:	file page that faulted
+ * @major:	the page was not in the page cache
+ *
+ * Does nothing unless @vma's mm was created less than
+ * launch_readahead_secs ago.  The first fault on an uncached page of a
+ * file in a new mm reads in everything recent launches faulted on that
+ * file.  A fault on a cached page only marks its range as still used.
+ *
+ * This runs for every fault in filemap_fault() while a process starts
+ * up, so the history is looked up under RCU and only its own lock is
+ * taken.  launch_ra_lock is needed once per file and mm, to create the
+ * history or move it to the head of the LRU.
+ */
+void launch_readahead_fault(struct vm_area_struct *vma, struct file *file,
+			    pgoff_t offset, bool major)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	struct inode *inode = file->f_mapping->host;
+	struct launch_ra_history *h, *new;
+	struct launch_ra_extent *extents = NULL;
+	unsigned int nr_extents = 0;
+	dev_t dev = inode->i_sb->s_dev;
+	u32 gen = inode->i_generation;
+	bool first = false, replay = false;
+
+	if (!sysctl_launch_readahead_secs ||
+	    time_after(jiffies, mm->launch_start +
+				sysctl_launch_readahead_secs * HZ))
+		return;
+
+	trace_mm_launch_fault(inode, offset, major);
+
+	/* a hit, maybe on a page replayed earlier, keeps its range alive */
+	if (!major) {
+		rcu_read_lock();
+		h = launch_ra_lookup(dev, inode->i_ino);
+		if (h) {
+			spin_lock(&h->lock);
+			if (h->generation == gen)
+				launch_ra_touch(h, offset);
+			spin_unlock(&h->lock);
+		}
+		rcu_read_unlock();
+		return;
+	}
+
+	rcu_read_lock();
+	h = launch_ra_lookup(dev, inode->i_ino);
+	if (!h) {
+		rcu_read_unlock();
+		new = launch_ra_alloc(dev, inode->i_ino, gen);
+		if (!new)
+			return;
+		spin_lock(&launch_ra_lock);
+		if (launch_ra_insert(new) == new)
+			new = NULL;
+		spin_unlock(&launch_ra_lock);
+		kfree(new);
+
+		rcu_read_lock();
+		h = launch_ra_lookup(dev, inode->i_ino);
+		if (!h)
+			goto out;
+	}
+
+	spin_lock(&h->lock);
+	/* the inode number was reused, the history is of another file */
+	if (h->generation != gen) {
+		h->generation = gen;
+		h->was_replayed = false;
+		h->nr_extents = 0;
+	}
+	/* first fault on this file since the mm was created */
+	if (!h->was_replayed || time_before(h->replayed, mm->launch_start)) {
+		h->was_replayed = true;
+		h->replayed = jiffies;
+		h->launches++;
+		launch_ra_expire(h);
+		first = true;
+		replay = h->nr_extents != 0;
+	}
+	if (!replay)
+		launch_ra_add_range(h, offset, 1);
+	spin_unlock(&h->lock);
+
+	if (first) {
+		spin_lock(&launch_ra_lock);
+		/* unless it was evicted meanwhile */
+		if (launch_ra_lookup(dev, inode->i_ino) == h)
+			list_move(&h->lru, &launch_ra_lru);
+		spin_unlock(&launch_ra_lock);
+	}
+	rcu_read_unlock();
+
+	if (!replay)
+		return;
+
+	extents = kmalloc(sizeof(h->extents), GFP_KERNEL);
+
+	rcu_read_lock();
+	/* it may have been evicted while we slept */
+	h = launch_ra_lookup(dev, inode->i_ino);
+	if (h) {
+		spin_lock(&h->lock);
+		if (h->generation == gen) {
+			if (extents) {
+				nr_extents = h->nr_extents;
+				memcpy(extents, h->extents,
+				       nr_extents * sizeof(*extents));
+			}
+			launch_ra_add_range(h, offset, 1);
+		}
+		spin_unlock(&h->lock);
+	}
+out:
+	rcu_read_unlock();
+
+	if (extents) {
+		launch_ra_replay(file, inode, extents, nr_extents);
+		kfree(extents);
+	}
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int launch_ra_show(struct seq_file *m, void *v)
+{
+	struct launch_ra_history *h;
+	unsigned int i;
+
+	spin_lock(&launch_ra_lock);
+	list_for_each_entry(h, &launch_ra_lru, lru) {
+		spin_lock(&h->lock);
+		seq_printf(m, "%u:%u %lu %u", MAJOR(h->dev), MINOR(h->dev),
+			   h->ino, h->generation);
+		for (i = 0; i < h->nr_extents; i++)
+			seq_printf(m, " %lu+%lu", h->extents[i].start,
+				   h->extents[i].nr);
+		spin_unlock(&h->lock);
+		seq_putc(m, '\n');
+	}
+	spin_unlock(&launch_ra_lock);
+
+	return 0;
+}
+
+static int launch_ra_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, launch_ra_show, NULL);
+}
+
+/* Parse one "<major>:<minor> <ino> <generation> <start>+<nr> ..." line */
+static int launch_ra_parse(char *line)
+{
+	struct launch_ra_history *new, *h;
+	unsigned int major, minor;
+	unsigned long ino, start, nr;
+	u32 gen;
+	int n;
+
+	if (sscanf(line, "%u:%u %lu %u%n", &major, &minor, &ino, &gen,
+		   &n) != 4)
+		return -EINVAL;
+	line += n;
+
+	new = launch_ra_alloc(MKDEV(major, minor), ino, gen);
+	if (!new)
+		return -ENOMEM;
+
+	while (sscanf(line, " %lu+%lu%n", &start, &nr, &n) == 2) {
+		if (nr)
+			launch_ra_add_range(new, start,
+				min_t(unsigned long, nr, LAUNCH_RA_MAX_PAGES));
+		line += n;
+	}
+	if (*skip_spaces(line)) {
+		kfree(new);
+		return -EINVAL;
+	}
+
+	/* a restored history replaces whatever was recorded */
+	spin_lock(&launch_ra_lock);
+	h = launch_ra_lookup(new->dev, new->ino);
+	if (h) {
+		hlist_del_rcu(&h->hash);
+		list_del(&h->lru);
+		kfree_rcu(h, rcu);
+		launch_ra_nr_history--;
+	}
+	launch_ra_insert(new);
+	spin_unlock(&launch_ra_lock);
+
+	return 0;
+}
+
+static ssize_t launch_ra_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char *buf, *line, *next;
+	size_t len = min_t(size_t, count, PAGE_SIZE - 1);
+	int err = 0;
+
+	buf = kmalloc(len + 1, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	if (copy_from_user(buf, ubuf, len)) {
+		kfree(buf);
+		return -EFAULT;
+	}
+	buf[len] = '\0';
+
+	/* only consume complete lines, unless this is all there is */
+	next = strrchr(buf, '\n');
+	if (next && len < count)
+		len = next + 1 - buf;
+	buf[len] = '\0';
+
+	for (line = buf; line && !err; line = next) {
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		if (*skip_spaces(line))
+			err = launch_ra_parse(line);
+	}
+	kfree(buf);
+
+	return err ? err : len;
+}
+
+static const struct file_operations launch_ra_fops = {
+	.open		= launch_ra_open,
+	.read		= seq_read,
+	.write		= launch_ra_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init launch_ra_debugfs_init(void)
+{
+	if (!debugfs_create_file("launch_readahead", 0600, NULL, NULL,
+				 &launch_ra_fops))
+		return -ENOMEM;
+
+	return 0;
+}
+late_initcall(launch_ra_debugfs_init);
+#endif /* CONFIG_DEBUG_FS */
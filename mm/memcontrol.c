@@ -98,6 +98,9 @@ enum mem_cgroup_events_index {
 	MEM_CGROUP_EVENTS_COUNT,	/* # of pages paged in/out */
 	MEM_CGROUP_EVENTS_PGFAULT,	/* # of page-faults */
 	MEM_CGROUP_EVENTS_PGMAJFAULT,	/* # of major page-faults */
+	MEM_CGROUP_EVENTS_PSWPIN,	/* # of pages read back from swap */
+	MEM_CGROUP_EVENTS_PSWPOUT,	/* # of pages written to swap */
+	MEM_CGROUP_EVENTS_REFAULT,	/* # of refaults of evicted file pages */
 	MEM_CGROUP_EVENTS_NSTATS,
 };
 /*
@@ -120,6 +123,7 @@ struct mem_cgroup_stat_cpu {
 	long count[MEM_CGROUP_STAT_NSTATS];
 	unsigned long events[MEM_CGROUP_EVENTS_NSTATS];
 	unsigned long targets[MEM_CGROUP_NTARGETS];
+	u64 swapin_time;	/* usecs spent waiting for swap-ins */
 };
 
 struct mem_cgroup_reclaim_iter {
@@ -694,6 +698,25 @@ static unsigned long mem_cgroup_read_events(struct mem_cgroup *memcg,
 	return val;
 }
 
+/*
+ * The swap-in wait is kept in a u64 of its own: in usecs, an unsigned
+ * long wraps after 71 minutes on 32-bit.
+ */
+static u64 mem_cgroup_read_swapin_time(struct mem_cgroup *memcg)
+{
+	u64 val = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		val += per_cpu(memcg->stat->swapin_time, cpu);
+#ifdef CONFIG_HOTPLUG_CPU
+	spin_lock(&memcg->pcp_counter_lock);
+	val += memcg->nocpu_base.swapin_time;
+	spin_unlock(&memcg->pcp_counter_lock);
+#endif
+	return val;
+}
+
 static void mem_cgroup_charge_statistics(struct mem_cgroup *memcg,
 					 bool anon, int nr_pages)
 {
@@ -1010,6 +1033,28 @@ out:
 }
 EXPORT_SYMBOL(mem_cgroup_count_vm_event);
 
+/*
+ * Account a swap-in fault of @mm that had to wait @usecs for the page
+ * to be read back, to tell which groups are slowed down by swapping.
+ */
+void mem_cgroup_count_swapin(struct mm_struct *mm, unsigned long usecs)
+{
+	struct mem_cgroup *memcg;
+
+	if (!mm)
+		return;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(rcu_dereference(mm->owner));
+	if (likely(memcg)) {
+		preempt_disable();
+		__this_cpu_inc(memcg->stat->events[MEM_CGROUP_EVENTS_PSWPIN]);
+		__this_cpu_add(memcg->stat->swapin_time, usecs);
+		preempt_enable();
+	}
+	rcu_read_unlock();
+}
+
 /**
  * mem_cgroup_zone_lruvec - get the lru list vector for a zone and memcg
  * @zone: zone of the wanted lruvec
@@ -1991,6 +2036,41 @@ void mem_cgroup_update_page_stat(struct page *page,
 	this_cpu_add(memcg->stat->count[idx], val);
 }
 
+/*
+ * Count an event against the group @page is charged to.  This does not
+ * serialize against moving charges, an event that races with it may be
+ * counted in the old group.
+ */
+void mem_cgroup_count_page_event(struct page *page,
+				 enum mem_cgroup_page_event_item idx)
+{
+	struct mem_cgroup *memcg;
+	struct page_cgroup *pc = lookup_page_cgroup(page);
+
+	if (mem_cgroup_disabled())
+		return;
+
+	rcu_read_lock();
+	memcg = pc->mem_cgroup;
+	if (unlikely(!memcg || !PageCgroupUsed(pc)))
+		goto out;
+
+	switch (idx) {
+	case MEMCG_PSWPOUT:
+		idx = MEM_CGROUP_EVENTS_PSWPOUT;
+		break;
+	case MEMCG_WORKINGSET_REFAULT:
+		idx = MEM_CGROUP_EVENTS_REFAULT;
+		break;
+	default:
+		BUG();
+	}
+
+	this_cpu_inc(memcg->stat->events[idx]);
+out:
+	rcu_read_unlock();
+}
+
 /*
  * size of first charge trial. "32" comes from vmscan.c's magic value.
  * TODO: maybe necessary to use big numbers in big irons.
@@ -2160,6 +2240,8 @@ static void mem_cgroup_drain_pcp_counter(struct mem_cgroup *memcg, int cpu)
 		per_cpu(memcg->stat->events[i], cpu) = 0;
 		memcg->nocpu_base.events[i] += x;
 	}
+	memcg->nocpu_base.swapin_time += per_cpu(memcg->stat->swapin_time, cpu);
+	per_cpu(memcg->stat->swapin_time, cpu) = 0;
 	spin_unlock(&memcg->pcp_counter_lock);
 }
 
@@ -4055,6 +4137,10 @@ enum {
 	MCS_SWAP,
 	MCS_PGFAULT,
 	MCS_PGMAJFAULT,
+	MCS_PSWPIN,
+	MCS_PSWPOUT,
+	MCS_SWAPIN_TIME,
+	MCS_WORKINGSET_REFAULT,
 	MCS_INACTIVE_ANON,
 	MCS_ACTIVE_ANON,
 	MCS_INACTIVE_FILE,
@@ -4079,6 +4165,10 @@ struct {
 	{"swap", "total_swap"},
 	{"pgfault", "total_pgfault"},
 	{"pgmajfault", "total_pgmajfault"},
+	{"pswpin", "total_pswpin"},
+	{"pswpout", "total_pswpout"},
+	{"swapin_time_us", "total_swapin_time_us"},
+	{"workingset_refault", "total_workingset_refault"},
 	{"inactive_anon", "total_inactive_anon"},
 	{"active_anon", "total_active_anon"},
 	{"inactive_file", "total_inactive_file"},
@@ -4111,6 +4201,13 @@ mem_cgroup_get_local_stat(struct mem_cgroup *memcg, struct mcs_total_stat *s)
 	s->stat[MCS_PGFAULT] += val;
 	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_PGMAJFAULT);
 	s->stat[MCS_PGMAJFAULT] += val;
+	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_PSWPIN);
+	s->stat[MCS_PSWPIN] += val;
+	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_PSWPOUT);
+	s->stat[MCS_PSWPOUT] += val;
+	s->stat[MCS_SWAPIN_TIME] += mem_cgroup_read_swapin_time(memcg);
+	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_REFAULT);
+	s->stat[MCS_WORKINGSET_REFAULT] += val;
 
 	/* per zone stat */
 	val = mem_cgroup_nr_lru_pages(memcg, BIT(LRU_INACTIVE_ANON));
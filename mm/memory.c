@@ -2944,6 +2944,7 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	struct mem_cgroup *ptr;
 	int exclusive = 0;
 	int ret = 0;
+	ktime_t start = ktime_set(0, 0);
 
 	if (!pte_unmap_same(mm, pmd, page_table, orig_pte))
 		goto out;
@@ -2963,6 +2964,7 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	delayacct_set_flag(DELAYACCT_PF_SWAPIN);
 	page = lookup_swap_cache(entry);
 	if (!page) {
+		start = ktime_get();
 		grab_swap_token(mm); /* Contend for token _before_ read-in */
 		page = swapin_readahead(entry,
 					GFP_HIGHUSER_MOVABLE, vma, address);
@@ -2994,6 +2996,14 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 
 	locked = lock_page_or_retry(page, mm, flags);
 	delayacct_clear_flag(DELAYACCT_PF_SWAPIN);
+	if (ret & VM_FAULT_MAJOR) {
+		unsigned long usecs;
+
+		usecs = ktime_to_us(ktime_sub(ktime_get(), start));
+		atomic_long_inc(&mm->nr_swapins);
+		atomic64_add(usecs, &mm->swapin_time);
+		mem_cgroup_count_swapin(mm, usecs);
+	}
 	if (!locked) {
 		ret |= VM_FAULT_RETRY;
 		goto out_release;
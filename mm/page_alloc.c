@@ -60,6 +60,7 @@
 #include <linux/migrate.h>
 #include <linux/page-debug-flags.h>
 #include <linux/pasr.h>
+#include <linux/ktime.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -626,7 +627,7 @@ static inline int free_pages_check(struct page *page)
 /*
  * Frees a number of pages from the PCP lists
  * Assumes all pages on list are in same zone, and of same order.
- * count is the number of pages to free.
+ * count is the number of blocks of the given order to free.
  *
  * If the zone was previously in an "all pages pinned" state then look to
  * see if this freeing clears that state.
@@ -635,7 +636,7 @@ static inline int free_pages_check(struct page *page)
  * pinned" detection logic.
  */
 static void free_pcppages_bulk(struct zone *zone, int count,
-					struct per_cpu_pages *pcp)
+					struct per_cpu_pages *pcp, int order)
 {
 	int migratetype = 0;
 	int batch_free = 0;
@@ -672,11 +673,12 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 			/* must delete as __free_one_page list manipulates */
 			list_del(&page->lru);
 			/* MIGRATE_MOVABLE list may include MIGRATE_RESERVEs */
-			__free_one_page(page, zone, 0, page_private(page));
-			trace_mm_page_pcpu_drain(page, 0, page_private(page));
+			__free_one_page(page, zone, order, page_private(page));
+			trace_mm_page_pcpu_drain(page, order,
+						 page_private(page));
 		} while (--to_free && --batch_free && !list_empty(list));
 	}
-	__mod_zone_page_state(zone, NR_FREE_PAGES, count);
+	__mod_zone_page_state(zone, NR_FREE_PAGES, count << order);
 	spin_unlock(&zone->lock);
 }
 
@@ -1155,22 +1157,66 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
  * Note that this function must be called with the thread pinned to
  * a single processor.
  */
-void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp)
+void drain_zone_pages(struct zone *zone, struct per_cpu_pageset *pset)
 {
+	struct per_cpu_pages *pcp;
 	unsigned long flags;
 	int to_drain;
+	int order;
 
 	local_irq_save(flags);
-	if (pcp->count >= pcp->batch)
-		to_drain = pcp->batch;
-	else
-		to_drain = pcp->count;
-	free_pcppages_bulk(zone, to_drain, pcp);
-	pcp->count -= to_drain;
+	for (order = 0; order <= PAGE_ALLOC_COSTLY_ORDER; order++) {
+		pcp = order ? &pset->pcp_high[order - 1] : &pset->pcp;
+		if (pcp->count >= pcp->batch)
+			to_drain = pcp->batch;
+		else
+			to_drain = pcp->count;
+		if (!to_drain)
+			continue;
+		free_pcppages_bulk(zone, to_drain, pcp, order);
+		pcp->count -= to_drain;
+	}
 	local_irq_restore(flags);
 }
 #endif
 
+/*
+ * Free all the pages on a pageset's lists, order-0 and higher order.
+ * Must be called with interrupts disabled.
+ */
+static void drain_pageset(struct zone *zone, struct per_cpu_pageset *pset)
+{
+	int order;
+
+	if (pset->pcp.count) {
+		free_pcppages_bulk(zone, pset->pcp.count, &pset->pcp, 0);
+		pset->pcp.count = 0;
+	}
+
+	for (order = 1; order <= PAGE_ALLOC_COSTLY_ORDER; order++) {
+		struct per_cpu_pages *pcp = &pset->pcp_high[order - 1];
+
+		if (pcp->count) {
+			free_pcppages_bulk(zone, pcp->count, pcp, order);
+			pcp->count = 0;
+		}
+	}
+}
+
+static bool pageset_has_pages(struct per_cpu_pageset *pset)
+{
+	int order;
+
+	if (pset->pcp.count)
+		return true;
+
+	for (order = 1; order <= PAGE_ALLOC_COSTLY_ORDER; order++)
+		if (pset->pcp_high[order - 1].count)
+			return true;
+
+	return false;
+}
+
 /*
  * Drain pages of the indicated processor.
  *
@@ -1185,16 +1231,10 @@ static void drain_pages(unsigned int cpu)
 
 	for_each_populated_zone(zone) {
 		struct per_cpu_pageset *pset;
-		struct per_cpu_pages *pcp;
 
 		local_irq_save(flags);
 		pset = per_cpu_ptr(zone->pageset, cpu);
-
-		pcp = &pset->pcp;
-		if (pcp->count) {
-			free_pcppages_bulk(zone, pcp->count, pcp);
-			pcp->count = 0;
-		}
+		drain_pageset(zone, pset);
 		local_irq_restore(flags);
 	}
 }
@@ -1238,7 +1278,7 @@ void drain_all_pages(void)
 		bool has_pcps = false;
 		for_each_populated_zone(zone) {
 			pcp = per_cpu_ptr(zone->pageset, cpu);
-			if (pcp->pcp.count) {
+			if (pageset_has_pages(pcp)) {
 				has_pcps = true;
 				break;
 			}
@@ -1331,7 +1371,59 @@ void free_hot_cold_page(struct page *page, int cold)
 		list_add(&page->lru, &pcp->lists[migratetype]);
 	pcp->count++;
 	if (pcp->count >= pcp->high) {
-		free_pcppages_bulk(zone, pcp->batch, pcp);
+		free_pcppages_bulk(zone, pcp->batch, pcp, 0);
+		pcp->count -= pcp->batch;
+	}
+
+out:
+	local_irq_restore(flags);
+}
+
+/*
+ * Free a block of order 1 to PAGE_ALLOC_COSTLY_ORDER to the per-cpu
+ * lists, so that slab pages, kernel stacks and the like do not need the
+ * zone->lock on either side.
+ */
+static void free_hot_high_page(struct page *page, unsigned int order)
+{
+	struct zone *zone = page_zone(page);
+	struct per_cpu_pages *pcp;
+	unsigned long flags;
+	int migratetype;
+	int wasMlocked = __TestClearPageMlocked(page);
+
+	if (!free_pages_prepare(page, order))
+		return;
+
+	/*
+	 * Blocks on the per-cpu lists skip __free_one_page(), so tear down
+	 * compound pages (slab, skb frags) here, or the next user would
+	 * find stale PG_head/PG_tail flags.
+	 */
+	if (PageCompound(page) && destroy_compound_page(page, order))
+		return;
+
+	migratetype = get_pageblock_migratetype(page);
+	set_page_private(page, migratetype);
+	local_irq_save(flags);
+	if (unlikely(wasMlocked))
+		free_page_mlock(page);
+	__count_vm_events(PGFREE, 1 << order);
+
+	/* See free_hot_cold_page() */
+	if (migratetype >= MIGRATE_PCPTYPES) {
+		if (unlikely(migratetype == MIGRATE_ISOLATE)) {
+			free_one_page(zone, page, order, migratetype);
+			goto out;
+		}
+		migratetype = MIGRATE_MOVABLE;
+	}
+
+	pcp = &this_cpu_ptr(zone->pageset)->pcp_high[order - 1];
+	list_add(&page->lru, &pcp->lists[migratetype]);
+	pcp->count++;
+	if (pcp->count >= pcp->high) {
+		free_pcppages_bulk(zone, pcp->batch, pcp, order);
 		pcp->count -= pcp->batch;
 	}
 
@@ -1445,16 +1537,33 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 	struct page *page;
 	int cold = !!(gfp_flags & __GFP_COLD);
 
+	if (unlikely(gfp_flags & __GFP_NOFAIL)) {
+		/*
+		 * __GFP_NOFAIL is not to be used in new code.
+		 *
+		 * All __GFP_NOFAIL callers should be fixed so that they
+		 * properly detect and handle allocation failures.
+		 *
+		 * We most definitely don't want callers attempting to
+		 * allocate greater than order-1 page units with
+		 * __GFP_NOFAIL.
+		 */
+		WARN_ON_ONCE(order > 1);
+	}
+
 again:
-	if (likely(order == 0)) {
+	if (likely(order <= PAGE_ALLOC_COSTLY_ORDER)) {
 		struct per_cpu_pages *pcp;
 		struct list_head *list;
 
 		local_irq_save(flags);
-		pcp = &this_cpu_ptr(zone->pageset)->pcp;
+		if (likely(order == 0))
+			pcp = &this_cpu_ptr(zone->pageset)->pcp;
+		else
+			pcp = &this_cpu_ptr(zone->pageset)->pcp_high[order - 1];
 		list = &pcp->lists[migratetype];
 		if (list_empty(list)) {
-			pcp->count += rmqueue_bulk(zone, 0,
+			pcp->count += rmqueue_bulk(zone, order,
 					pcp->batch, list,
 					migratetype, cold);
 			if (unlikely(list_empty(list)))
@@ -1469,19 +1578,6 @@ again:
 		list_del(&page->lru);
 		pcp->count--;
 	} else {
-		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
-			/*
-			 * __GFP_NOFAIL is not to be used in new code.
-			 *
-			 * All __GFP_NOFAIL callers should be fixed so that they
-			 * properly detect and handle allocation failures.
-			 *
-			 * We most definitely don't want callers attempting to
-			 * allocate greater than order-1 page units with
-			 * __GFP_NOFAIL.
-			 */
-			WARN_ON_ONCE(order > 1);
-		}
 		spin_lock_irqsave(&zone->lock, flags);
 		page = __rmqueue(zone, order, migratetype);
 		spin_unlock(&zone->lock);
@@ -2152,11 +2248,13 @@ __perform_reclaim(gfp_t gfp_mask, unsigned int order, struct zonelist *zonelist,
 		  nodemask_t *nodemask)
 {
 	struct reclaim_state reclaim_state;
+	ktime_t start;
 	int progress;
 
 	cond_resched();
 
 	/* We now go into synchronous reclaim */
+	start = ktime_get();
 	cpuset_memory_pressure_bump();
 	current->flags |= PF_MEMALLOC;
 	lockdep_set_current_reclaim_state(gfp_mask);
@@ -2169,6 +2267,8 @@ __perform_reclaim(gfp_t gfp_mask, unsigned int order, struct zonelist *zonelist,
 	lockdep_clear_current_reclaim_state();
 	current->flags &= ~PF_MEMALLOC;
 
+	count_vm_events(ALLOCSTALLTIME, ktime_us_delta(ktime_get(), start));
+
 	cond_resched();
 
 	return progress;
@@ -2579,6 +2679,8 @@ void __free_pages(struct page *page, unsigned int order)
 	if (put_page_testzero(page)) {
 		if (order == 0)
 			free_hot_cold_page(page, 0);
+		else if (order <= PAGE_ALLOC_COSTLY_ORDER)
+			free_hot_high_page(page, order);
 		else
 			__free_pages_ok(page, order);
 	}
@@ -3812,10 +3914,27 @@ static int zone_batchsize(struct zone *zone)
 #endif
 }
 
+/*
+ * The higher order lists move roughly as many pages per batch as the
+ * order-0 list but only hold two batches, so that they do not pin too
+ * many blocks that could otherwise merge into larger ones.
+ */
+static void setup_pageset_high(struct per_cpu_pageset *p)
+{
+	int order;
+
+	for (order = 1; order <= PAGE_ALLOC_COSTLY_ORDER; order++) {
+		struct per_cpu_pages *pcp = &p->pcp_high[order - 1];
+
+		pcp->batch = max(1, p->pcp.batch >> order);
+		pcp->high = 2 * pcp->batch;
+	}
+}
+
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
 {
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int migratetype, order;
 
 	memset(p, 0, sizeof(*p));
 
@@ -3825,6 +3944,14 @@ static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
 	pcp->batch = max(1UL, 1 * batch);
 	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
 		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+
+	for (order = 1; order <= PAGE_ALLOC_COSTLY_ORDER; order++) {
+		pcp = &p->pcp_high[order - 1];
+		for (migratetype = 0; migratetype < MIGRATE_PCPTYPES;
+		     migratetype++)
+			INIT_LIST_HEAD(&pcp->lists[migratetype]);
+	}
+	setup_pageset_high(p);
 }
 
 /*
@@ -3842,6 +3969,7 @@ static void setup_pagelist_highmark(struct per_cpu_pageset *p,
 	pcp->batch = max(1UL, high/4);
 	if ((high/4) > (PAGE_SHIFT * 8))
 		pcp->batch = PAGE_SHIFT * 8;
+	setup_pageset_high(p);
 }
 
 static void setup_zone_pageset(struct zone *zone)
@@ -3925,13 +4053,11 @@ static int __zone_pcp_update(void *data)
 
 	for_each_possible_cpu(cpu) {
 		struct per_cpu_pageset *pset;
-		struct per_cpu_pages *pcp;
 
 		pset = per_cpu_ptr(zone->pageset, cpu);
-		pcp = &pset->pcp;
 
 		local_irq_save(flags);
-		free_pcppages_bulk(zone, pcp->count, pcp);
+		drain_pageset(zone, pset);
 		setup_pageset(pset, batch);
 		local_irq_restore(flags);
 	}
@@ -4372,6 +4498,9 @@ static void __paginginit free_area_init_core(struct pglist_data *pgdat,
 	pgdat->nr_zones = 0;
 	init_waitqueue_head(&pgdat->kswapd_wait);
 	pgdat->kswapd_max_order = 0;
+#ifdef CONFIG_COMPACTION
+	init_waitqueue_head(&pgdat->kcompactd_wait);
+#endif
 	pgdat_page_cgroup_init(pgdat);
 
 	for (j = 0; j < MAX_NR_ZONES; j++) {
@@ -0,0 +1,218 @@
+/*
+ * mm/page_alloc_bench.c
+ *
+ * Page allocator microbenchmark: order-0..3 allocation throughput and
+ * kernel_thread() creation rate (which allocates an order-1 stack on
+ * ARM) with 1, 2, 4... CPUs hammering the allocator at the same time.
+ *
+ * Everything happens at load time.  One line per order and CPU count
+ * goes to the kernel log, after which the load is failed on purpose so
+ * that the next run is just another
+ *
+ *	modprobe page_alloc_bench max_cpus=4
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define pr_fmt(fmt) "page_alloc_bench: " fmt
+
+#include <linux/completion.h>
+#include <linux/cpumask.h>
+#include <linux/gfp.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+#define BENCH_BATCH	16
+
+static unsigned int max_cpus = 4;
+module_param(max_cpus, uint, 0);
+MODULE_PARM_DESC(max_cpus, "Largest number of CPUs to run on (default 4)");
+
+static unsigned int alloc_iterations = 100000;
+module_param(alloc_iterations, uint, 0);
+MODULE_PARM_DESC(alloc_iterations, "Allocations per CPU and order");
+
+static unsigned int fork_iterations = 2000;
+module_param(fork_iterations, uint, 0);
+MODULE_PARM_DESC(fork_iterations, "Threads created per CPU");
+
+struct bench_thread {
+	struct task_struct *task;
+	int (*fn)(struct bench_thread *bt);
+	unsigned int order;
+	unsigned long ops;
+	s64 ns;
+};
+
+static atomic_t bench_ready;
+static int bench_go;
+static DECLARE_COMPLETION(bench_done);
+static atomic_t bench_running;
+
+static int bench_alloc(struct bench_thread *bt)
+{
+	struct page *pages[BENCH_BATCH];
+	unsigned int i, j;
+
+	for (i = 0; i < alloc_iterations / BENCH_BATCH; i++) {
+		for (j = 0; j < BENCH_BATCH; j++) {
+			pages[j] = alloc_pages(GFP_KERNEL, bt->order);
+			if (!pages[j])
+				break;
+		}
+		bt->ops += j;
+		while (j--)
+			__free_pages(pages[j], bt->order);
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int bench_child(void *data)
+{
+	complete(data);
+	return 0;
+}
+
+static int bench_fork(struct bench_thread *bt)
+{
+	struct completion started;
+	unsigned int i;
+	int pid;
+
+	init_completion(&started);
+	for (i = 0; i < fork_iterations; i++) {
+		/* SIGCHLD is ignored by kernel threads, the child autoreaps */
+		pid = kernel_thread(bench_child, &started,
+				    CLONE_FS | CLONE_FILES | SIGCHLD);
+		if (pid < 0)
+			return pid;
+		wait_for_completion(&started);
+		INIT_COMPLETION(started);
+		bt->ops++;
+	}
+
+	return 0;
+}
+
+static int bench_thread_fn(void *data)
+{
+	struct bench_thread *bt = data;
+	ktime_t start;
+
+	/* start all CPUs at the same time */
+	atomic_inc(&bench_ready);
+	while (!ACCESS_ONCE(bench_go))
+		cpu_relax();
+
+	start = ktime_get();
+	bt->fn(bt);
+	bt->ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (atomic_dec_and_test(&bench_running))
+		complete(&bench_done);
+
+	/* wait for kthread_stop() */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+static void bench_run(const char *name, int (*fn)(struct bench_thread *),
+		      unsigned int order, unsigned int nr_cpus)
+{
+	struct bench_thread *bt;
+	unsigned long ops = 0;
+	s64 ns = 0;
+	unsigned int i, started;
+	int cpu;
+
+	bt = kcalloc(nr_cpus, sizeof(*bt), GFP_KERNEL);
+	if (!bt)
+		return;
+
+	atomic_set(&bench_ready, 0);
+	atomic_set(&bench_running, nr_cpus);
+	bench_go = 0;
+	INIT_COMPLETION(bench_done);
+
+	i = 0;
+	for_each_online_cpu(cpu) {
+		if (i == nr_cpus)
+			break;
+		bt[i].fn = fn;
+		bt[i].order = order;
+		bt[i].task = kthread_create(bench_thread_fn, &bt[i],
+					    "page_alloc_bench/%d", cpu);
+		if (IS_ERR(bt[i].task)) {
+			pr_err("failed to create thread on cpu %d\n", cpu);
+			bt[i].task = NULL;
+			atomic_sub(nr_cpus - i, &bench_running);
+			break;
+		}
+		kthread_bind(bt[i].task, cpu);
+		wake_up_process(bt[i].task);
+		i++;
+	}
+
+	started = i;
+
+	if (started == nr_cpus) {
+		while (atomic_read(&bench_ready) != nr_cpus)
+			schedule_timeout_uninterruptible(1);
+		bench_go = 1;
+		wait_for_completion(&bench_done);
+	} else {
+		/* let whatever was started finish, the result is discarded */
+		bench_go = 1;
+	}
+
+	for (i = 0; i < started; i++) {
+		kthread_stop(bt[i].task);
+		ops += bt[i].ops;
+		ns = max(ns, bt[i].ns);
+	}
+
+	if (started == nr_cpus && ns)
+		pr_info("%-12s %u cpus: %10lu ops in %6lld ms, %10llu ops/s\n",
+			name, nr_cpus, ops, div_s64(ns, NSEC_PER_MSEC),
+			div64_s64((s64)ops * NSEC_PER_SEC, ns));
+
+	kfree(bt);
+}
+
+static int __init page_alloc_bench_init(void)
+{
+	unsigned int cpus = min(max_cpus, num_online_cpus());
+	unsigned int nr, order;
+	char name[16];
+
+	for (nr = 1; nr <= cpus; nr <<= 1) {
+		for (order = 0; order <= PAGE_ALLOC_COSTLY_ORDER; order++) {
+			snprintf(name, sizeof(name), "order-%u", order);
+			bench_run(name, bench_alloc, order, nr);
+		}
+		bench_run("kernel_thread", bench_fork, 0, nr);
+	}
+
+	/* nothing to keep around, see the top of the file */
+	return -EAGAIN;
+}
+module_init(page_alloc_bench_init);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Page allocator microbenchmark");
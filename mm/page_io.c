@@ -18,6 +18,7 @@
 #include <linux/bio.h>
 #include <linux/swapops.h>
 #include <linux/writeback.h>
+#include <linux/memcontrol.h>
 #include <asm/pgtable.h>
 
 static struct bio *get_swap_bio(gfp_t gfp_flags,
@@ -40,29 +41,38 @@ static struct bio *get_swap_bio(gfp_t gfp_flags,
 	return bio;
 }
 
+/* Maximum number of pages in a bio built by swap_writepage_batch() */
+#define SWAP_BATCH_PAGES	SWAP_CLUSTER_MAX
+
 static void end_swap_bio_write(struct bio *bio, int err)
 {
 	const int uptodate = test_bit(BIO_UPTODATE, &bio->bi_flags);
-	struct page *page = bio->bi_io_vec[0].bv_page;
+	struct bio_vec *bvec = bio->bi_io_vec + bio->bi_vcnt - 1;
 
-	if (!uptodate) {
-		SetPageError(page);
-		/*
-		 * We failed to write the page out to swap-space.
-		 * Re-dirty the page in order to avoid it being reclaimed.
-		 * Also print a dire warning that things will go BAD (tm)
-		 * very quickly.
-		 *
-		 * Also clear PG_reclaim to avoid rotate_reclaimable_page()
-		 */
-		set_page_dirty(page);
-		printk(KERN_ALERT "Write-error on swap-device (%u:%u:%Lu)\n",
-				imajor(bio->bi_bdev->bd_inode),
-				iminor(bio->bi_bdev->bd_inode),
-				(unsigned long long)bio->bi_sector);
-		ClearPageReclaim(page);
-	}
-	end_page_writeback(page);
+	do {
+		struct page *page = bvec->bv_page;
+
+		if (!uptodate) {
+			SetPageError(page);
+			/*
+			 * We failed to write the page out to swap-space.
+			 * Re-dirty the page in order to avoid it being
+			 * reclaimed.  Also print a dire warning that things
+			 * will go BAD (tm) very quickly.
+			 *
+			 * Also clear PG_reclaim to avoid
+			 * rotate_reclaimable_page()
+			 */
+			set_page_dirty(page);
+			printk(KERN_ALERT "Write-error on swap-device "
+					"(%u:%u:%Lu)\n",
+					imajor(bio->bi_bdev->bd_inode),
+					iminor(bio->bi_bdev->bd_inode),
+					(unsigned long long)bio->bi_sector);
+			ClearPageReclaim(page);
+		}
+		end_page_writeback(page);
+	} while (--bvec >= bio->bi_io_vec);
 	bio_put(bio);
 }
 
@@ -108,6 +118,7 @@ int swap_writepage(struct page *page, struct writeback_control *wbc)
 	if (wbc->sync_mode == WB_SYNC_ALL)
 		rw |= REQ_SYNC;
 	count_vm_event(PSWPOUT);
+	mem_cgroup_count_page_event(page, MEMCG_PSWPOUT);
 	set_page_writeback(page);
 	unlock_page(page);
 	submit_bio(rw, bio);
@@ -115,6 +126,78 @@ out:
 	return ret;
 }
 
+/**
+ * swap_writepage_batch - write a swap page as part of a multi-page bio
+ * @page: locked swap cache page to write
+ * @wbc: writeback control, as for swap_writepage()
+ * @batch: bio being filled by the caller, or NULL
+ *
+ * Adds @page to *@batch if its swap slot follows the last one in there,
+ * otherwise submits *@batch and starts a new bio with @page.  The caller
+ * must hand the last bio to swap_submit_batch().  Reclaim batches the
+ * pages of one shrink_page_list() pass this way, so that a swap device
+ * such as zram gets many pages in one request and can compress them in
+ * parallel.
+ */
+int swap_writepage_batch(struct page *page, struct writeback_control *wbc,
+			 struct bio **batch)
+{
+	struct bio *bio = *batch;
+	struct block_device *bdev;
+	sector_t sector;
+
+	if (wbc->sync_mode == WB_SYNC_ALL)
+		return swap_writepage(page, wbc);
+
+	if (try_to_free_swap(page)) {
+		unlock_page(page);
+		return 0;
+	}
+
+	sector = map_swap_page(page, &bdev) << (PAGE_SHIFT - 9);
+	if (bio && (bio->bi_bdev != bdev ||
+		    bio->bi_sector + (bio->bi_size >> 9) != sector ||
+		    !bio_add_page(bio, page, PAGE_SIZE, 0))) {
+		swap_submit_batch(batch);
+		bio = NULL;
+	}
+
+	if (!bio) {
+		bio = bio_alloc(GFP_NOIO, SWAP_BATCH_PAGES);
+		if (!bio)
+			return swap_writepage(page, wbc);
+		bio->bi_sector = sector;
+		bio->bi_bdev = bdev;
+		bio->bi_end_io = end_swap_bio_write;
+		if (!bio_add_page(bio, page, PAGE_SIZE, 0)) {
+			bio_put(bio);
+			return swap_writepage(page, wbc);
+		}
+		*batch = bio;
+	}
+
+	count_vm_event(PSWPOUT);
+	mem_cgroup_count_page_event(page, MEMCG_PSWPOUT);
+	set_page_writeback(page);
+	unlock_page(page);
+
+	if (bio->bi_vcnt == bio->bi_max_vecs)
+		swap_submit_batch(batch);
+	return 0;
+}
+
+/**
+ * swap_submit_batch - submit the bio built by swap_writepage_batch()
+ * @batch: the bio, or NULL
+ */
+void swap_submit_batch(struct bio **batch)
+{
+	if (*batch) {
+		submit_bio(WRITE, *batch);
+		*batch = NULL;
+	}
+}
+
 int swap_readpage(struct page *page)
 {
 	struct bio *bio;
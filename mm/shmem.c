@@ -421,6 +421,15 @@ void shmem_unlock_mapping(struct address_space *mapping)
 	}
 }
 
+/*
+ * Exceptional entries in a shmem mapping are swap entries, elsewhere
+ * they are the shadows of evicted page cache pages.
+ */
+bool shmem_mapping(struct address_space *mapping)
+{
+	return mapping->backing_dev_info == &shmem_backing_dev_info;
+}
+
 /*
  * Remove range of pages and swap entries from radix tree, and free them.
  */
@@ -2541,6 +2550,11 @@ void shmem_unlock_mapping(struct address_space *mapping)
 {
 }
 
+bool shmem_mapping(struct address_space *mapping)
+{
+	return false;
+}
+
 void shmem_truncate_range(struct inode *inode, loff_t lstart, loff_t lend)
 {
 	truncate_inode_pages_range(inode->i_mapping, lstart, lend);
@@ -0,0 +1,126 @@
+/*
+ * mm/slab_bench.c
+ *
+ * Slab allocator microbenchmark: the cost of kmalloc() and kfree() for
+ * the common kmalloc cache sizes, both for an alloc immediately freed
+ * again (the per cpu fastpath on both ends) and for a batch allocated
+ * and then freed in one go (which also walks the slowpath as per cpu
+ * slabs run empty and full).
+ *
+ * The timings are taken while the module initialises.  There is no
+ * state worth keeping afterwards, so init reports -EAGAIN and another
+ * round is simply
+ *
+ *	modprobe slab_bench iterations=1000000
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define pr_fmt(fmt) "slab_bench: " fmt
+
+#include <linux/cpumask.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+#define BENCH_BATCH	256
+
+static unsigned int iterations = 100000;
+module_param(iterations, uint, 0);
+MODULE_PARM_DESC(iterations, "Allocations per size and pattern");
+
+static const size_t bench_sizes[] = {
+	8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096,
+};
+
+static void *bench_objs[BENCH_BATCH];
+
+/* kmalloc() followed right away by kfree() of the same object. */
+static void bench_pair(size_t size)
+{
+	unsigned long ops = 0;
+	s64 ns = 0;
+	ktime_t start;
+	unsigned int i, j;
+
+	for (i = 0; i < iterations / BENCH_BATCH; i++) {
+		start = ktime_get();
+		for (j = 0; j < BENCH_BATCH; j++)
+			kfree(kmalloc(size, GFP_KERNEL));
+		ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+		ops += BENCH_BATCH;
+		cond_resched();
+	}
+
+	if (!ops)
+		return;
+	pr_info("kmalloc-%-5zu pair:  %5lld ns per kmalloc+kfree\n",
+		size, div64_s64(ns, ops));
+}
+
+/* BENCH_BATCH kmalloc()s, then BENCH_BATCH kfree()s. */
+static void bench_batch(size_t size)
+{
+	s64 alloc_ns = 0, free_ns = 0;
+	unsigned long allocs = 0;
+	ktime_t start;
+	unsigned int i, j, n;
+
+	for (i = 0; i < iterations / BENCH_BATCH; i++) {
+		start = ktime_get();
+		for (n = 0; n < BENCH_BATCH; n++) {
+			bench_objs[n] = kmalloc(size, GFP_KERNEL);
+			if (!bench_objs[n])
+				break;
+		}
+		alloc_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		start = ktime_get();
+		for (j = 0; j < n; j++)
+			kfree(bench_objs[j]);
+		free_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		allocs += n;
+		cond_resched();
+	}
+
+	if (!allocs)
+		return;
+	pr_info("kmalloc-%-5zu batch: %5lld ns per kmalloc, %5lld ns per kfree\n",
+		size, div64_s64(alloc_ns, allocs), div64_s64(free_ns, allocs));
+}
+
+static int __init slab_bench_init(void)
+{
+	cpumask_var_t saved_mask;
+	unsigned int i;
+	int cpu;
+
+	if (!alloc_cpumask_var(&saved_mask, GFP_KERNEL))
+		return -ENOMEM;
+	cpumask_copy(saved_mask, tsk_cpus_allowed(current));
+
+	/* stay on one cpu so every run hits the same per cpu slabs */
+	cpu = raw_smp_processor_id();
+	set_cpus_allowed_ptr(current, cpumask_of(cpu));
+	pr_info("running on cpu %d\n", cpu);
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		bench_pair(bench_sizes[i]);
+		bench_batch(bench_sizes[i]);
+	}
+
+	set_cpus_allowed_ptr(current, saved_mask);
+	free_cpumask_var(saved_mask);
+
+	return -EAGAIN;
+}
+module_init(slab_bench_init);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Slab allocator microbenchmark");
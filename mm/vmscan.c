@@ -461,7 +461,7 @@ typedef enum {
  * Calls ->writepage().
  */
 static pageout_t pageout(struct page *page, struct address_space *mapping,
-			 struct scan_control *sc)
+			 struct scan_control *sc, struct bio **swap_batch)
 {
 	/*
 	 * If the page is dirty, only perform writeback if that write
@@ -511,7 +511,10 @@ static pageout_t pageout(struct page *page, struct address_space *mapping,
 		};
 
 		SetPageReclaim(page);
-		res = mapping->a_ops->writepage(page, &wbc);
+		if (PageSwapCache(page))
+			res = swap_writepage_batch(page, &wbc, swap_batch);
+		else
+			res = mapping->a_ops->writepage(page, &wbc);
 		if (res < 0)
 			handle_write_error(mapping, page, res);
 		if (res == AOP_WRITEPAGE_ACTIVATE) {
@@ -534,9 +537,11 @@ static pageout_t pageout(struct page *page, struct address_space *mapping,
 
 /*
  * Same as remove_mapping, but if the page is removed from the mapping, it
- * gets returned with a refcount of 0.
+ * gets returned with a refcount of 0.  Pages @reclaimed by the LRU scan
+ * leave a shadow entry behind so that their refaults can be detected.
  */
-static int __remove_mapping(struct address_space *mapping, struct page *page)
+static int __remove_mapping(struct address_space *mapping, struct page *page,
+			    bool reclaimed)
 {
 	BUG_ON(!PageLocked(page));
 	BUG_ON(mapping != page_mapping(page));
@@ -582,10 +587,13 @@ static int __remove_mapping(struct address_space *mapping, struct page *page)
 		swapcache_free(swap, page);
 	} else {
 		void (*freepage)(struct page *);
+		void *shadow = NULL;
 
 		freepage = mapping->a_ops->freepage;
 
-		__delete_from_page_cache(page);
+		if (reclaimed && page_is_file_cache(page))
+			shadow = workingset_eviction(mapping, page);
+		__delete_from_page_cache(page, shadow);
 		spin_unlock_irq(&mapping->tree_lock);
 		mem_cgroup_uncharge_cache_page(page);
 
@@ -608,7 +616,7 @@ cannot_free:
  */
 int remove_mapping(struct address_space *mapping, struct page *page)
 {
-	if (__remove_mapping(mapping, page)) {
+	if (__remove_mapping(mapping, page, false)) {
 		/*
 		 * Unfreezing the refcount with 1 rather than 2 effectively
 		 * drops the pagecache ref for us without requiring another
@@ -771,6 +779,9 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 {
 	LIST_HEAD(ret_pages);
 	LIST_HEAD(free_pages);
+	LIST_HEAD(swap_pages);
+	struct bio *swap_batch = NULL;
+	struct page *page, *next;
 	int pgactivate = 0;
 	unsigned long nr_dirty = 0;
 	unsigned long nr_congested = 0;
@@ -782,7 +793,6 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 	while (!list_empty(page_list)) {
 		enum page_references references;
 		struct address_space *mapping;
-		struct page *page;
 		int may_enter_fs;
 
 		cond_resched();
@@ -900,13 +910,18 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 				goto keep_locked;
 
 			/* Page is dirty, try to write it out here */
-			switch (pageout(page, mapping, sc)) {
+			switch (pageout(page, mapping, sc, &swap_batch)) {
 			case PAGE_KEEP:
 				nr_congested++;
 				goto keep_locked;
 			case PAGE_ACTIVATE:
 				goto activate_locked;
 			case PAGE_SUCCESS:
+				/* possibly not even submitted yet, see below */
+				if (PageWriteback(page) && PageSwapCache(page)) {
+					list_add(&page->lru, &swap_pages);
+					continue;
+				}
 				if (PageWriteback(page))
 					goto keep_lumpy;
 				if (PageDirty(page))
@@ -968,7 +983,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			}
 		}
 
-		if (!mapping || !__remove_mapping(mapping, page))
+		if (!mapping || !__remove_mapping(mapping, page, true))
 			goto keep_locked;
 
 		/*
@@ -1013,6 +1028,32 @@ keep_lumpy:
 		VM_BUG_ON(PageLRU(page) || PageUnevictable(page));
 	}
 
+	/*
+	 * Submit the swap pages pageout() batched up.  A synchronous swap
+	 * device like zram has written them by the time submit_bio()
+	 * returns, so free those right away like other synchronous writes.
+	 */
+	swap_submit_batch(&swap_batch);
+	list_for_each_entry_safe(page, next, &swap_pages, lru) {
+		struct address_space *mapping;
+
+		list_del(&page->lru);
+		if (PageWriteback(page) || !trylock_page(page))
+			goto keep_swap;
+		mapping = page_mapping(page);
+		if (PageDirty(page) || PageWriteback(page) || !mapping ||
+		    !__remove_mapping(mapping, page, true)) {
+			unlock_page(page);
+			goto keep_swap;
+		}
+		__clear_page_locked(page);
+		nr_reclaimed++;
+		list_add(&page->lru, &free_pages);
+		continue;
+keep_swap:
+		list_add(&page->lru, &ret_pages);
+	}
+
 	/*
 	 * Tag a zone as congested if all the dirty pages encountered were
 	 * backed by a congested BDI. In this case, reclaimers should just
@@ -468,9 +468,10 @@ void refresh_cpu_vm_stats(int cpu)
 		 * processor
 		 *
 		 * Check if there are pages remaining in this pageset
-		 * if not then there is nothing to expire.
+		 * if not then there is nothing to expire.  The higher
+		 * order lists are checked by drain_zone_pages().
 		 */
-		if (!p->expire || !p->pcp.count)
+		if (!p->expire)
 			continue;
 
 		/*
@@ -485,8 +486,7 @@ void refresh_cpu_vm_stats(int cpu)
 		if (p->expire)
 			continue;
 
-		if (p->pcp.count)
-			drain_zone_pages(zone, &p->pcp);
+		drain_zone_pages(zone, p);
 #endif
 	}
 
@@ -712,6 +712,8 @@ const char * const vmstat_text[] = {
 	"nr_shmem",
 	"nr_dirtied",
 	"nr_written",
+	"workingset_refault",
+	"workingset_activate",
 
 #ifdef CONFIG_NUMA
 	"numa_hit",
@@ -757,6 +759,7 @@ const char * const vmstat_text[] = {
 	"kswapd_skip_congestion_wait",
 	"pageoutrun",
 	"allocstall",
+	"allocstall_time_us",
 
 	"pgrotated",
 
@@ -767,6 +770,11 @@ const char * const vmstat_text[] = {
 	"compact_stall",
 	"compact_fail",
 	"compact_success",
+	"compact_stall_time_us",
+	"compact_proactive",
+	"compact_proactive_success",
+	"compact_proactive_fail",
+	"compact_proactive_time_us",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
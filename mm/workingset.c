@@ -0,0 +1,311 @@
+/*
+ * Workingset detection
+ */
+
+#include <linux/memcontrol.h>
+#include <linux/writeback.h>
+#include <linux/pagemap.h>
+#include <linux/atomic.h>
+#include <linux/module.h>
+#include <linux/pagevec.h>
+#include <linux/shrinker.h>
+#include <linux/swap.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+
+/*
+ * Double CLOCK lists
+ *
+ * Per zone, two clock lists are maintained for file pages: the
+ * inactive and the active list.  Freshly faulted pages start out at
+ * the head of the inactive list and page reclaim scans pages from the
+ * tail.  Pages that are accessed multiple times on the inactive list
+ * are promoted to the active list, to protect them from reclaim,
+ * whereas active pages are demoted to the inactive list when the
+ * active list grows too big.
+ *
+ * A workload whose pages are each used once, like a media scan or a
+ * large copy, streams through the inactive list without touching the
+ * active list.  But when the pages the user cares about do not fit on
+ * the inactive list either, they keep being evicted before they are
+ * accessed a second time and never get activated, while the active
+ * list keeps holding on to pages that are no longer used.
+ *
+ * Approximating inactive page access frequency - Observations:
+ *
+ * 1. When a page is accessed for the first time, it is added to the
+ *    head of the inactive list, slides every existing inactive page
+ *    towards the tail by one slot, and pushes the current tail page
+ *    out of memory.
+ *
+ * 2. When a page is accessed for the second time, it is promoted to
+ *    the active list, shrinking the inactive list by one slot.  This
+ *    also slides all inactive pages that were faulted into the cache
+ *    more recently than the activated page towards the tail of the
+ *    inactive list.
+ *
+ * Thus, the sum of evictions and activations between any two points in
+ * time indicate the minimum number of inactive pages accessed in
+ * between.  This is counted in zone->inactive_age.
+ *
+ * Every page that is evicted leaves a shadow entry holding the value
+ * of inactive_age at that time in its page cache slot.  When the page
+ * is faulted in again, the difference between the current inactive_age
+ * and the one stored in the shadow is the refault distance: the number
+ * of inactive pages that were accessed while the page was gone.
+ *
+ * Had the inactive list been refault distance pages bigger, the page
+ * would have been activated instead of evicted.  The inactive list can
+ * only grow into the active list, so a refault distance smaller than
+ * the active list means that the page would have stayed in memory if
+ * all of memory had been given to the inactive list: it belongs to the
+ * workingset, is activated right away, and from now on competes with
+ * the existing active pages.
+ *
+ * Refaults are counted as workingset_refault in /proc/vmstat, and the
+ * ones that were activated as workingset_activate.
+ *
+ * Shadow entry reclaim
+ *
+ * A shadow entry only goes away when its page refaults or the file is
+ * truncated, and it pins the radix tree node it sits in.  A file that
+ * is read once and never again could keep its whole tree around for as
+ * long as the inode is cached.  But the refault distance is bounded by
+ * the amount of memory, so only a limited number of shadow entries can
+ * ever be useful: mappings with shadow entries are kept on a list and a
+ * shrinker deletes them, least recently shadowed mapping first, once
+ * there are more of them than there are file pages on the LRU lists.
+ */
+
+#define EVICTION_SHIFT	(RADIX_TREE_EXCEPTIONAL_SHIFT + \
+			 ZONES_SHIFT + NODES_SHIFT)
+#define EVICTION_MASK	(~0UL >> EVICTION_SHIFT)
+
+static void *pack_shadow(unsigned long eviction, struct zone *zone)
+{
+	eviction = (eviction << NODES_SHIFT) | zone_to_nid(zone);
+	eviction = (eviction << ZONES_SHIFT) | zone_idx(zone);
+	eviction = (eviction << RADIX_TREE_EXCEPTIONAL_SHIFT);
+
+	return (void *)(eviction | RADIX_TREE_EXCEPTIONAL_ENTRY);
+}
+
+static void unpack_shadow(void *shadow, struct zone **zone,
+			  unsigned long *distance)
+{
+	unsigned long entry = (unsigned long)shadow;
+	unsigned long eviction;
+	unsigned long refault;
+	int zid, nid;
+
+	entry >>= RADIX_TREE_EXCEPTIONAL_SHIFT;
+	zid = entry & ((1UL << ZONES_SHIFT) - 1);
+	entry >>= ZONES_SHIFT;
+	nid = entry & ((1UL << NODES_SHIFT) - 1);
+	entry >>= NODES_SHIFT;
+	eviction = entry;
+
+	*zone = NODE_DATA(nid)->node_zones + zid;
+
+	refault = atomic_long_read(&(*zone)->inactive_age);
+	*distance = (refault - eviction) & EVICTION_MASK;
+}
+
+/**
+ * workingset_eviction - note the eviction of a page from memory
+ * @mapping: address space the page was backing
+ * @page: the page being evicted
+ *
+ * Returns a shadow entry to be stored in @mapping->page_tree in place
+ * of the evicted @page so that a later refault can be detected.
+ */
+void *workingset_eviction(struct address_space *mapping, struct page *page)
+{
+	struct zone *zone = page_zone(page);
+	unsigned long eviction;
+
+	eviction = atomic_long_inc_return(&zone->inactive_age);
+	return pack_shadow(eviction, zone);
+}
+
+/**
+ * workingset_refault - evaluate the refault of a previously evicted page
+ * @shadow: shadow entry of the evicted page
+ *
+ * Calculates and evaluates the refault distance of the previously
+ * evicted page in the context of the zone it was allocated in.
+ *
+ * Returns %true if the page should be activated, %false otherwise.
+ */
+bool workingset_refault(void *shadow)
+{
+	unsigned long refault_distance;
+	struct zone *zone;
+
+	unpack_shadow(shadow, &zone, &refault_distance);
+	inc_zone_state(zone, WORKINGSET_REFAULT);
+
+	if (refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
+		inc_zone_state(zone, WORKINGSET_ACTIVATE);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * workingset_activation - note a page activation
+ * @page: page that is being activated
+ */
+void workingset_activation(struct page *page)
+{
+	atomic_long_inc(&page_zone(page)->inactive_age);
+}
+
+static LIST_HEAD(shadow_mappings);
+static DEFINE_SPINLOCK(shadow_mappings_lock);
+static atomic_long_t nr_shadows;
+
+/**
+ * workingset_shadows_inc - account a shadow entry stored in @mapping
+ * @mapping: address space the shadow entry was stored in
+ *
+ * Must be called with @mapping->tree_lock held.
+ */
+void workingset_shadows_inc(struct address_space *mapping)
+{
+	if (!mapping->nrshadows++) {
+		spin_lock(&shadow_mappings_lock);
+		list_add_tail(&mapping->shadow_list, &shadow_mappings);
+		spin_unlock(&shadow_mappings_lock);
+	}
+	atomic_long_inc(&nr_shadows);
+}
+
+/**
+ * workingset_shadows_dec - account shadow entries removed from @mapping
+ * @mapping: address space the shadow entries were removed from
+ * @nr: number of shadow entries removed
+ *
+ * Must be called with @mapping->tree_lock held.
+ */
+void workingset_shadows_dec(struct address_space *mapping, unsigned long nr)
+{
+	if (!nr)
+		return;
+
+	atomic_long_sub(nr, &nr_shadows);
+	mapping->nrshadows -= nr;
+	if (!mapping->nrshadows) {
+		spin_lock(&shadow_mappings_lock);
+		list_del_init(&mapping->shadow_list);
+		spin_unlock(&shadow_mappings_lock);
+	}
+}
+
+/*
+ * Delete shadow entries of @mapping, looking at no more than @nr_to_scan
+ * entries.  Called with shadow_mappings_lock and @mapping->tree_lock
+ * held, returns the number of entries looked at.
+ */
+static unsigned long shrink_mapping_shadows(struct address_space *mapping,
+					    unsigned long nr_to_scan)
+{
+	void **slots[PAGEVEC_SIZE];
+	unsigned long indices[PAGEVEC_SIZE];
+	pgoff_t shadows[PAGEVEC_SIZE];
+	unsigned long scanned = 0;
+	unsigned int i, nr, nr_deleted;
+	pgoff_t index = 0;
+
+	while (scanned < nr_to_scan && mapping->nrshadows) {
+		nr = radix_tree_gang_lookup_slot(&mapping->page_tree, slots,
+				indices, index,
+				min_t(unsigned long, PAGEVEC_SIZE,
+				      nr_to_scan - scanned));
+		if (!nr)
+			break;
+
+		nr_deleted = 0;
+		for (i = 0; i < nr; i++) {
+			void *entry;
+
+			entry = radix_tree_deref_slot_protected(slots[i],
+							&mapping->tree_lock);
+			if (radix_tree_exceptional_entry(entry))
+				shadows[nr_deleted++] = indices[i];
+		}
+		/* Deletion may free the nodes that slots[] point into */
+		for (i = 0; i < nr_deleted; i++)
+			radix_tree_delete(&mapping->page_tree, shadows[i]);
+
+		atomic_long_sub(nr_deleted, &nr_shadows);
+		mapping->nrshadows -= nr_deleted;
+		scanned += nr;
+
+		index = indices[nr - 1] + 1;
+		if (!index)
+			break;
+	}
+
+	if (!mapping->nrshadows)
+		list_del_init(&mapping->shadow_list);
+
+	return scanned;
+}
+
+/* Shadow entries beyond the number of file pages on the LRU lists */
+static unsigned long excess_shadows(void)
+{
+	unsigned long shadows = atomic_long_read(&nr_shadows);
+	unsigned long max;
+
+	max = global_page_state(NR_ACTIVE_FILE) +
+	      global_page_state(NR_INACTIVE_FILE);
+
+	return shadows > max ? shadows - max : 0;
+}
+
+static int shadow_shrink(struct shrinker *shrinker, struct shrink_control *sc)
+{
+	unsigned long nr_to_scan = sc->nr_to_scan;
+	struct address_space *mapping;
+
+	if (nr_to_scan && excess_shadows()) {
+		spin_lock_irq(&shadow_mappings_lock);
+		while (nr_to_scan && !list_empty(&shadow_mappings)) {
+			mapping = list_first_entry(&shadow_mappings,
+						   struct address_space,
+						   shadow_list);
+			list_move_tail(&mapping->shadow_list, &shadow_mappings);
+			nr_to_scan--;
+
+			/*
+			 * The eviction path takes shadow_mappings_lock
+			 * inside the tree_lock.  Holding shadow_mappings_lock
+			 * keeps the mapping alive, as the inode cannot be
+			 * freed with shadow entries left.
+			 */
+			if (!spin_trylock(&mapping->tree_lock))
+				continue;
+			nr_to_scan -= min(nr_to_scan,
+					  shrink_mapping_shadows(mapping,
+								 nr_to_scan));
+			spin_unlock(&mapping->tree_lock);
+		}
+		spin_unlock_irq(&shadow_mappings_lock);
+	}
+
+	return min_t(unsigned long, excess_shadows(), INT_MAX);
+}
+
+static struct shrinker workingset_shadow_shrinker = {
+	.shrink = shadow_shrink,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int __init workingset_init(void)
+{
+	register_shrinker(&workingset_shadow_shrinker);
+	return 0;
+}
+module_init(workingset_init);
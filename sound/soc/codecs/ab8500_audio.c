@@ -4026,7 +4026,7 @@ static void __exit ab850x_codec_platform_driver_exit(void)
 	platform_driver_unregister(&ab850x_codec_platform_driver);
 }
 
-module_init(ab850x_codec_platform_driver_init);
+module_init_async(ab850x_codec_platform_driver_init);
 module_exit(ab850x_codec_platform_driver_exit);
 
 MODULE_DESCRIPTION("AB850X Codec driver");
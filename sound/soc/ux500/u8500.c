@@ -396,7 +396,7 @@ static void __exit u85x0_soc_exit(void)
 	platform_device_unregister(u85x0_platform_dev);
 }
 
-module_init(u85x0_soc_init);
+module_init_async(u85x0_soc_init, "ab850x_codec_platform_driver_init");
 module_exit(u85x0_soc_exit);
 
 MODULE_LICENSE("GPLv2");
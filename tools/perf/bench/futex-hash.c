@@ -0,0 +1,176 @@
+/*
+ *
+ * futex-hash.c
+ *
+ * hash: Benchmark for the futex hash table
+ *
+ * Every thread does FUTEX_WAIT calls that fail right away because the
+ * futex value does not match, on futexes of its own.  No thread ever
+ * sleeps, so the throughput only depends on how fast the kernel can
+ * look up and lock the hash buckets, and how often threads collide on
+ * the same bucket lock.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+static unsigned int nthreads;
+static unsigned int nfutexes = 1024;
+static unsigned int nsecs = 5;
+static bool fshared;
+
+static volatile int done;
+static pthread_barrier_t barrier;
+
+struct worker {
+	pthread_t thread;
+	u_int32_t *futex;
+	unsigned long ops;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify number of threads (default: 1 up to #cpus)"),
+	OPT_UINTEGER('f', "futexes", &nfutexes,
+		     "Specify number of futexes per thread"),
+	OPT_UINTEGER('r', "runtime", &nsecs,
+		     "Specify runtime in seconds"),
+	OPT_BOOLEAN('s', "shared", &fshared,
+		    "Use shared futexes instead of private ones"),
+	OPT_END()
+};
+
+static const char * const bench_futex_hash_usage[] = {
+	"perf bench futex hash <options>",
+	NULL
+};
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	unsigned int i;
+
+	pthread_barrier_wait(&barrier);
+
+	while (!done) {
+		for (i = 0; i < nfutexes; i++) {
+			/* the futex is 0, so waiting for 1 returns EAGAIN */
+			if (futex_wait(&w->futex[i], 1, !fshared) != -1 ||
+			    errno != EAGAIN) {
+				fprintf(stderr, "futex_wait: %s\n",
+					strerror(errno));
+				exit(1);
+			}
+		}
+		w->ops += nfutexes;
+	}
+
+	return NULL;
+}
+
+static void alarm_handler(int sig __used)
+{
+	done = 1;
+}
+
+static unsigned long run(unsigned int threads)
+{
+	struct worker *workers;
+	unsigned long ops = 0;
+	unsigned int i;
+
+	workers = calloc(threads, sizeof(*workers));
+	if (!workers)
+		die("calloc");
+
+	done = 0;
+	pthread_barrier_init(&barrier, NULL, threads + 1);
+
+	for (i = 0; i < threads; i++) {
+		workers[i].futex = calloc(nfutexes, sizeof(u_int32_t));
+		if (!workers[i].futex)
+			die("calloc");
+		if (pthread_create(&workers[i].thread, NULL, worker_fn,
+				   &workers[i]))
+			die("pthread_create");
+	}
+
+	/* start them all at once, and stop them all at once */
+	pthread_barrier_wait(&barrier);
+	alarm(nsecs);
+
+	for (i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		ops += workers[i].ops;
+		free(workers[i].futex);
+	}
+
+	pthread_barrier_destroy(&barrier);
+	free(workers);
+
+	return ops / nsecs;
+}
+
+static void print_result(unsigned int threads, unsigned long ops)
+{
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %8u threads: %12lu ops/sec, %10lu ops/sec per thread\n",
+		       threads, ops, ops / threads);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%u %lu\n", threads, ops);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+}
+
+int bench_futex_hash(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	unsigned int threads, ncpus;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_hash_usage, 0);
+	if (!nfutexes || !nsecs)
+		usage_with_options(bench_futex_hash_usage, options);
+
+	signal(SIGALRM, alarm_handler);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u %s futexes per thread, %u seconds per run\n\n",
+		       nfutexes, fshared ? "shared" : "private", nsecs);
+
+	if (nthreads) {
+		print_result(nthreads, run(nthreads));
+		return 0;
+	}
+
+	/* 1, 2, 4... threads, up to one per online cpu */
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	for (threads = 1; threads < ncpus; threads <<= 1)
+		print_result(threads, run(threads));
+	print_result(ncpus, run(ncpus));
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ *
+ * futex-wake.c
+ *
+ * wake: Benchmark for waking up blocked futex waiters
+ *
+ * A number of threads block in FUTEX_WAIT on the same futex, and the
+ * main thread wakes them up one FUTEX_WAKE call at a time.  Since all
+ * waiters hash to the same bucket, this measures how long the kernel
+ * holds on to a single, contended bucket lock per wakeup.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+static unsigned int nthreads;
+static unsigned int nwakes = 1;
+static unsigned int nrepeat = 10;
+static bool fshared;
+
+static u_int32_t futex;
+static pthread_barrier_t barrier;
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify number of waiters (default: 1 up to 4 * #cpus)"),
+	OPT_UINTEGER('w', "nwakes", &nwakes,
+		     "Specify number of waiters woken per FUTEX_WAKE"),
+	OPT_UINTEGER('r', "repeat", &nrepeat,
+		     "Specify number of times to repeat each run"),
+	OPT_BOOLEAN('s', "shared", &fshared,
+		    "Use a shared futex instead of a private one"),
+	OPT_END()
+};
+
+static const char * const bench_futex_wake_usage[] = {
+	"perf bench futex wake <options>",
+	NULL
+};
+
+static void *waiter_fn(void *arg __used)
+{
+	pthread_barrier_wait(&barrier);
+
+	/* retry on spurious wakeups and signals, until really woken */
+	while (futex_wait(&futex, 0, !fshared) && errno == EINTR)
+		;
+
+	return NULL;
+}
+
+/* Returns the time it took to wake all waiters, in usecs. */
+static unsigned long run(unsigned int threads)
+{
+	struct timeval start, stop, diff;
+	pthread_t *waiters;
+	unsigned int i, woken = 0;
+	int ret;
+
+	waiters = calloc(threads, sizeof(*waiters));
+	if (!waiters)
+		die("calloc");
+
+	futex = 0;
+	pthread_barrier_init(&barrier, NULL, threads + 1);
+
+	for (i = 0; i < threads; i++)
+		if (pthread_create(&waiters[i], NULL, waiter_fn, NULL))
+			die("pthread_create");
+
+	pthread_barrier_wait(&barrier);
+
+	/*
+	 * The barrier does not guarantee that the waiters already sleep
+	 * in the kernel: give them some time to get there.
+	 */
+	usleep(100000);
+
+	gettimeofday(&start, NULL);
+	while (woken < threads) {
+		ret = futex_wake(&futex, nwakes, !fshared);
+		if (ret < 0)
+			die("futex_wake");
+		woken += ret;
+	}
+	gettimeofday(&stop, NULL);
+
+	for (i = 0; i < threads; i++)
+		pthread_join(waiters[i], NULL);
+
+	pthread_barrier_destroy(&barrier);
+	free(waiters);
+
+	timersub(&stop, &start, &diff);
+	return diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+static void print_result(unsigned int threads, unsigned long usecs)
+{
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %8u waiters: woken in %10.3f ms, %8.3f usecs per waiter\n",
+		       threads, usecs / 1000.0, (double)usecs / threads);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%u %lu\n", threads, usecs);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+}
+
+static void bench(unsigned int threads)
+{
+	unsigned long usecs = 0;
+	unsigned int i;
+
+	for (i = 0; i < nrepeat; i++)
+		usecs += run(threads);
+
+	print_result(threads, usecs / nrepeat);
+}
+
+int bench_futex_wake(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	unsigned int threads, max;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_wake_usage, 0);
+	if (!nwakes || !nrepeat)
+		usage_with_options(bench_futex_wake_usage, options);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# waking %u waiter(s) per call on a %s futex, "
+		       "average of %u runs\n\n",
+		       nwakes, fshared ? "shared" : "private", nrepeat);
+
+	if (nthreads) {
+		bench(nthreads);
+		return 0;
+	}
+
+	/* 1, 2, 4... waiters, up to four per online cpu */
+	max = 4 * sysconf(_SC_NPROCESSORS_ONLN);
+	for (threads = 1; threads <= max; threads <<= 1)
+		bench(threads);
+
+	return 0;
+}
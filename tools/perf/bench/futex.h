@@ -0,0 +1,34 @@
+/*
+ * futex.h: glue for the futex benchmarks
+ */
+
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <linux/futex.h>
+
+/*
+ * glibc has no futex() wrapper.  The private variants are only used
+ * when the benchmark is not asked to exercise the shared (inode or
+ * mm-based) keys.
+ */
+static inline int
+futex_wait(u_int32_t *uaddr, u_int32_t val, int private)
+{
+	return syscall(__NR_futex, uaddr,
+		       private ? FUTEX_WAIT_PRIVATE : FUTEX_WAIT,
+		       val, NULL, NULL, 0);
+}
+
+static inline int
+futex_wake(u_int32_t *uaddr, int nr_wake, int private)
+{
+	return syscall(__NR_futex, uaddr,
+		       private ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE,
+		       nr_wake, NULL, NULL, 0);
+}
+
+#endif /* _FUTEX_H */
@@ -0,0 +1,298 @@
+/*
+ * ion_stress:
+ *
+ * Hammer /dev/ion from many threads at once.  Every thread opens its own
+ * client and loops allocating a randomly sized buffer, sharing it as a
+ * dma-buf fd, filling it through mmap and freeing the handle.  The fd is
+ * then swapped with a random slot of a table shared by all threads and
+ * whatever fd was there before is imported into the thread's client,
+ * checked and released, so buffers are freed from a different client
+ * than the one that allocated them.
+ *
+ * usage: ion_stress [-t threads] [-n iterations] [-m heap_mask] [-s max_kb]
+ *
+ * The test is skipped if /dev/ion does not exist.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* from include/linux/ion.h */
+struct ion_handle;
+
+struct ion_allocation_data {
+	size_t len;
+	size_t align;
+	unsigned int heap_mask;
+	unsigned int flags;
+	struct ion_handle *handle;
+};
+
+struct ion_fd_data {
+	struct ion_handle *handle;
+	int fd;
+};
+
+struct ion_handle_data {
+	struct ion_handle *handle;
+};
+
+#define ION_IOC_MAGIC		'I'
+#define ION_IOC_ALLOC		_IOWR(ION_IOC_MAGIC, 0, \
+				      struct ion_allocation_data)
+#define ION_IOC_FREE		_IOWR(ION_IOC_MAGIC, 1, struct ion_handle_data)
+#define ION_IOC_SHARE		_IOWR(ION_IOC_MAGIC, 4, struct ion_fd_data)
+#define ION_IOC_IMPORT		_IOWR(ION_IOC_MAGIC, 5, struct ion_fd_data)
+
+#define ION_DEV		"/dev/ion"
+#define PAGE_SZ		4096
+#define NR_SLOTS	64
+
+struct slot {
+	int fd;
+	size_t len;
+	unsigned char pattern;
+};
+
+static struct slot slots[NR_SLOTS];
+static pthread_mutex_t slots_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int nr_threads = 8;
+static int nr_iterations = 1000;
+static unsigned int heap_mask = ~0U;
+static int max_pages = 256;
+
+struct worker {
+	pthread_t thread;
+	unsigned int seed;
+	unsigned long allocs;
+	unsigned long imports;
+	unsigned long enomem;
+	unsigned long failures;
+};
+
+static int ion_free(int ion_fd, struct ion_handle *handle)
+{
+	struct ion_handle_data data = { .handle = handle };
+
+	return ioctl(ion_fd, ION_IOC_FREE, &data);
+}
+
+/* import @slot into our own client, check its contents and release it */
+static int check_slot(struct worker *w, int ion_fd, struct slot *slot)
+{
+	struct ion_fd_data data = { .fd = slot->fd };
+	unsigned char *p;
+	int ret = 0;
+
+	if (ioctl(ion_fd, ION_IOC_IMPORT, &data)) {
+		perror("ION_IOC_IMPORT");
+		close(slot->fd);
+		return -1;
+	}
+	w->imports++;
+
+	p = mmap(NULL, slot->len, PROT_READ, MAP_SHARED, slot->fd, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap imported buffer");
+		ret = -1;
+	} else {
+		if (p[0] != slot->pattern || p[slot->len - 1] != slot->pattern) {
+			fprintf(stderr, "buffer contents changed: %02x %02x, "
+				"expected %02x\n", p[0], p[slot->len - 1],
+				slot->pattern);
+			ret = -1;
+		}
+		munmap(p, slot->len);
+	}
+
+	if (ion_free(ion_fd, data.handle)) {
+		perror("ION_IOC_FREE imported handle");
+		ret = -1;
+	}
+	close(slot->fd);
+
+	return ret;
+}
+
+static int one_iteration(struct worker *w, int ion_fd)
+{
+	struct ion_allocation_data alloc;
+	struct ion_fd_data share;
+	struct slot slot, old;
+	unsigned char *p;
+	int i;
+
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.len = (rand_r(&w->seed) % max_pages + 1) * PAGE_SZ;
+	alloc.align = PAGE_SZ;
+	alloc.heap_mask = heap_mask;
+	if (ioctl(ion_fd, ION_IOC_ALLOC, &alloc)) {
+		if (errno == ENOMEM) {
+			w->enomem++;
+			return 0;
+		}
+		perror("ION_IOC_ALLOC");
+		return -1;
+	}
+	w->allocs++;
+
+	memset(&share, 0, sizeof(share));
+	share.handle = alloc.handle;
+	if (ioctl(ion_fd, ION_IOC_SHARE, &share)) {
+		perror("ION_IOC_SHARE");
+		ion_free(ion_fd, alloc.handle);
+		return -1;
+	}
+
+	slot.fd = share.fd;
+	slot.len = alloc.len;
+	slot.pattern = rand_r(&w->seed);
+
+	p = mmap(NULL, slot.len, PROT_READ | PROT_WRITE, MAP_SHARED, slot.fd, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		ion_free(ion_fd, alloc.handle);
+		close(slot.fd);
+		return -1;
+	}
+	memset(p, slot.pattern, slot.len);
+	munmap(p, slot.len);
+
+	/* the dma-buf fd keeps the buffer alive from here on */
+	if (ion_free(ion_fd, alloc.handle)) {
+		perror("ION_IOC_FREE");
+		close(slot.fd);
+		return -1;
+	}
+
+	i = rand_r(&w->seed) % NR_SLOTS;
+	pthread_mutex_lock(&slots_lock);
+	old = slots[i];
+	slots[i] = slot;
+	pthread_mutex_unlock(&slots_lock);
+
+	if (old.fd >= 0)
+		return check_slot(w, ion_fd, &old);
+
+	return 0;
+}
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	int ion_fd, i;
+
+	ion_fd = open(ION_DEV, O_RDWR);
+	if (ion_fd < 0) {
+		perror("open " ION_DEV);
+		w->failures++;
+		return NULL;
+	}
+
+	for (i = 0; i < nr_iterations; i++)
+		if (one_iteration(w, ion_fd))
+			w->failures++;
+
+	close(ion_fd);
+	return NULL;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long allocs = 0, imports = 0, enomem = 0, failures = 0;
+	struct worker *workers;
+	double start, elapsed;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "t:n:m:s:")) != -1) {
+		switch (opt) {
+		case 't':
+			nr_threads = atoi(optarg);
+			break;
+		case 'n':
+			nr_iterations = atoi(optarg);
+			break;
+		case 'm':
+			heap_mask = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			max_pages = atoi(optarg) * 1024 / PAGE_SZ;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t threads] [-n iterations] "
+				"[-m heap_mask] [-s max_kb]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (nr_threads < 1 || nr_iterations < 1 || max_pages < 1) {
+		fprintf(stderr, "invalid arguments\n");
+		return 1;
+	}
+
+	if (access(ION_DEV, R_OK | W_OK)) {
+		printf("ion_stress: %s not available, skipping\n", ION_DEV);
+		return 0;
+	}
+
+	for (i = 0; i < NR_SLOTS; i++)
+		slots[i].fd = -1;
+
+	workers = calloc(nr_threads, sizeof(*workers));
+	if (!workers) {
+		perror("calloc");
+		return 1;
+	}
+
+	start = now();
+	for (i = 0; i < nr_threads; i++) {
+		workers[i].seed = getpid() ^ (i * 2654435761U);
+		if (pthread_create(&workers[i].thread, NULL, worker_fn,
+				   &workers[i])) {
+			perror("pthread_create");
+			return 1;
+		}
+	}
+	for (i = 0; i < nr_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		allocs += workers[i].allocs;
+		imports += workers[i].imports;
+		enomem += workers[i].enomem;
+		failures += workers[i].failures;
+	}
+	elapsed = now() - start;
+
+	/* whatever is left in the table is released by closing the fds */
+	for (i = 0; i < NR_SLOTS; i++)
+		if (slots[i].fd >= 0)
+			close(slots[i].fd);
+
+	printf("ion_stress: %d threads, %lu allocs, %lu imports, %lu ENOMEM "
+	       "in %.2fs (%.0f allocs/s)\n", nr_threads, allocs, imports,
+	       enomem, elapsed, allocs / elapsed);
+
+	free(workers);
+
+	if (failures) {
+		printf("ion_stress: [FAIL] %lu failures\n", failures);
+		return 1;
+	}
+	printf("ion_stress: [PASS]\n");
+	return 0;
+}
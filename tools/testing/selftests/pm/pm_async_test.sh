@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Check that asynchronous suspend/resume keeps devices in order: suspend
+# and resume the dummy devices of the pm_async_test module once, using
+# the "devices" pm_test level so that no real sleep state is entered.
+#
+# Usage: pm_async_test.sh [delay_ms]
+
+delay=${1:-100}
+result=/sys/devices/platform/pm_async_test.2/result
+
+if [ ! -w /sys/power/pm_test ]; then
+	echo "pm_test not available (CONFIG_PM_DEBUG), skipping"
+	exit 0
+fi
+if ! modprobe pm_async_test delay_ms=$delay 2>/dev/null; then
+	echo "pm_async_test module not available, skipping"
+	exit 0
+fi
+
+saved=`sed -n 's/.*\[\(.*\)\].*/\1/p' /sys/power/pm_test`
+echo 1 > /sys/power/pm_async
+echo devices > /sys/power/pm_test
+echo mem > /sys/power/state
+ret=$?
+echo ${saved:-none} > /sys/power/pm_test
+
+if [ $ret -ne 0 ]; then
+	echo "suspend failed"
+	rmmod pm_async_test
+	exit 1
+fi
+
+cat $result
+grep -q violated $result
+ret=$?
+rmmod pm_async_test
+
+if [ $ret -eq 0 ]; then
+	echo "[FAIL]"
+	exit 1
+fi
+echo "[PASS]"
+exit 0
@@ -0,0 +1,229 @@
+/*
+ * rcu_nocb:
+ *
+ * Compare RCU softirq load and idle residency of a CPU with callback
+ * offloading (CONFIG_RCU_NOCB_CPU) switched off and on.  The CPU should
+ * be one given by the rcu_nocbs= boot parameter.
+ *
+ * For each setting of /sys/module/rcutree/parameters/rcu_nocb_enabled,
+ * a task pinned to the CPU repeatedly opens and closes /dev/null, every
+ * close queueing an RCU callback to free the struct file, and sleeps in
+ * between so that the CPU can go idle.  The RCU softirqs, softirq time
+ * and cpuidle state residency of the CPU are reported for both runs.
+ *
+ * usage: rcu_nocb [-c cpu] [-s seconds]
+ *
+ * The test is skipped if the kernel can't offload RCU callbacks.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NOCB_PARAM	"/sys/module/rcutree/parameters/rcu_nocb_enabled"
+#define MAX_STATES	10
+#define BURST		1000	/* open/close pairs per burst */
+#define BURST_SLEEP	10000	/* us to sleep between bursts */
+
+struct sample {
+	unsigned long long rcu_softirqs;
+	unsigned long long softirq_ticks;
+	unsigned long long idle_us[MAX_STATES];
+	int nr_states;
+};
+
+static int cpu;
+static int seconds = 10;
+
+static int write_param(const char *val)
+{
+	FILE *f = fopen(NOCB_PARAM, "w");
+
+	if (!f)
+		return -1;
+	fprintf(f, "%s\n", val);
+	return fclose(f);
+}
+
+/* The RCU row of /proc/softirqs has one column per online cpu */
+static unsigned long long read_rcu_softirqs(void)
+{
+	char line[4096], *p, *end;
+	unsigned long long v = 0;
+	int col;
+	FILE *f;
+
+	f = fopen("/proc/softirqs", "r");
+	if (!f)
+		return 0;
+	/* the header names the cpus: find our column */
+	if (!fgets(line, sizeof(line), f))
+		goto out;
+	col = 0;
+	for (p = strtok(line, " \n"); p; p = strtok(NULL, " \n")) {
+		if (atoi(p + 3) == cpu)
+			break;
+		col++;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		p = line;
+		while (*p == ' ')
+			p++;
+		if (strncmp(p, "RCU:", 4))
+			continue;
+		p += 4;
+		do {
+			v = strtoull(p, &end, 10);
+			p = end;
+		} while (col--);
+		break;
+	}
+out:
+	fclose(f);
+	return v;
+}
+
+/* softirq is the 7th field of the cpuN line in /proc/stat */
+static unsigned long long read_softirq_ticks(void)
+{
+	unsigned long long f[7];
+	char name[16], want[16];
+	char line[512];
+	FILE *fp;
+
+	fp = fopen("/proc/stat", "r");
+	if (!fp)
+		return 0;
+	snprintf(want, sizeof(want), "cpu%d", cpu);
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%15s %llu %llu %llu %llu %llu %llu %llu",
+			   name, &f[0], &f[1], &f[2], &f[3], &f[4], &f[5],
+			   &f[6]) == 8 && !strcmp(name, want)) {
+			fclose(fp);
+			return f[6];
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+static void read_sample(struct sample *s)
+{
+	char path[128];
+	FILE *f;
+	int i;
+
+	s->rcu_softirqs = read_rcu_softirqs();
+	s->softirq_ticks = read_softirq_ticks();
+	for (i = 0; i < MAX_STATES; i++) {
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/time",
+			 cpu, i);
+		f = fopen(path, "r");
+		if (!f)
+			break;
+		if (fscanf(f, "%llu", &s->idle_us[i]) != 1)
+			s->idle_us[i] = 0;
+		fclose(f);
+	}
+	s->nr_states = i;
+}
+
+static void load(void)
+{
+	struct timeval start, now;
+	int i, fd;
+
+	gettimeofday(&start, NULL);
+	do {
+		for (i = 0; i < BURST; i++) {
+			fd = open("/dev/null", O_RDONLY);
+			if (fd >= 0)
+				close(fd);
+		}
+		usleep(BURST_SLEEP);
+		gettimeofday(&now, NULL);
+	} while (now.tv_sec - start.tv_sec < seconds);
+}
+
+static void run(const char *mode)
+{
+	struct sample before, after;
+	long hz = sysconf(_SC_CLK_TCK);
+	int i;
+
+	if (write_param(mode)) {
+		perror(NOCB_PARAM);
+		exit(1);
+	}
+	/* let callbacks queued with the old setting drain */
+	sleep(1);
+
+	read_sample(&before);
+	load();
+	read_sample(&after);
+
+	printf("offload %s: %.1f RCU softirqs/s, %.1f ms softirq time/s\n",
+	       *mode == '1' ? "on " : "off",
+	       (double)(after.rcu_softirqs - before.rcu_softirqs) / seconds,
+	       (after.softirq_ticks - before.softirq_ticks) * 1000.0 /
+			hz / seconds);
+	for (i = 0; i < after.nr_states; i++)
+		printf("offload %s: idle state%d residency %5.1f%%\n",
+		       *mode == '1' ? "on " : "off", i,
+		       (after.idle_us[i] - before.idle_us[i]) /
+				(seconds * 10000.0));
+}
+
+int main(int argc, char **argv)
+{
+	char saved[8] = "Y";
+	cpu_set_t set;
+	FILE *f;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:s:")) != -1) {
+		switch (opt) {
+		case 'c':
+			cpu = atoi(optarg);
+			break;
+		case 's':
+			seconds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-c cpu] [-s seconds]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (seconds <= 0)
+		seconds = 1;
+
+	f = fopen(NOCB_PARAM, "r");
+	if (!f) {
+		printf("RCU callback offloading not supported, skipping\n");
+		return 0;
+	}
+	if (fscanf(f, "%7s", saved) != 1)
+		saved[0] = 'Y';
+	fclose(f);
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		perror("sched_setaffinity");
+		return 1;
+	}
+
+	printf("cpu %d, %d seconds per run\n", cpu, seconds);
+	run("0");
+	run("1");
+
+	write_param(saved);
+	return 0;
+}
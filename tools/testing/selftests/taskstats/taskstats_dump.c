@@ -0,0 +1,361 @@
+/*
+ * taskstats_dump:
+ *
+ * Read the CPU time, memory, fault and I/O statistics of every task
+ * twice: with one taskstats dump over netlink, and by scraping
+ * /proc/<pid>/task/<tid>/stat and status the way system monitors do.
+ * Both are repeated a number of times, and the average time and number
+ * of syscalls per pass are reported for each, as well as the number of
+ * tasks seen.
+ *
+ * usage: taskstats_dump [-c cgroup-dir] [-n passes] [-v]
+ *
+ * -c restricts the dump to the tasks attached to a cgroup, and the procfs
+ * pass to the tasks listed in its tasks file.  -v prints the stats of
+ * every task of the last dump.
+ *
+ * Needs CAP_NET_ADMIN; the test is skipped if the kernel has no taskstats
+ * or can't dump all tasks.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+
+#define GENLMSG_DATA(glh)	((void *)((char *)NLMSG_DATA(glh) + GENL_HDRLEN))
+#define NLA_DATA(na)		((void *)((char *)(na) + NLA_HDRLEN))
+#define NLA_NEXT(na)		((struct nlattr *)((char *)(na) + \
+					NLA_ALIGN((na)->nla_len)))
+
+#define RECV_BUF	(64 * 1024)
+
+struct pass {
+	unsigned long tasks;
+	unsigned long syscalls;
+	unsigned long long utime_us;	/* sanity check: sum of user time */
+};
+
+static int verbose;
+static const char *cgroup;
+static char buf[RECV_BUF];
+
+static int nl_send(int sd, __u16 type, __u16 flags, __u8 cmd,
+		   __u16 attr, const void *data, int len)
+{
+	struct {
+		struct nlmsghdr n;
+		struct genlmsghdr g;
+		char buf[256];
+	} msg;
+	struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+	struct nlattr *na;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.n.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	msg.n.nlmsg_type = type;
+	msg.n.nlmsg_flags = NLM_F_REQUEST | flags;
+	msg.n.nlmsg_pid = getpid();
+	msg.g.cmd = cmd;
+	msg.g.version = 0x1;
+	if (data) {
+		na = GENLMSG_DATA(&msg);
+		na->nla_type = attr;
+		na->nla_len = NLA_HDRLEN + len;
+		memcpy(NLA_DATA(na), data, len);
+		msg.n.nlmsg_len += NLA_ALIGN(na->nla_len);
+	}
+
+	if (sendto(sd, &msg, msg.n.nlmsg_len, 0, (struct sockaddr *)&addr,
+		   sizeof(addr)) < 0)
+		return -1;
+	return 0;
+}
+
+static int get_family_id(int sd)
+{
+	struct nlmsghdr *n = (struct nlmsghdr *)buf;
+	struct nlattr *na;
+	int len;
+
+	if (nl_send(sd, GENL_ID_CTRL, 0, CTRL_CMD_GETFAMILY,
+		    CTRL_ATTR_FAMILY_NAME, TASKSTATS_GENL_NAME,
+		    sizeof(TASKSTATS_GENL_NAME)))
+		return 0;
+	len = recv(sd, buf, sizeof(buf), 0);
+	if (len < 0 || !NLMSG_OK(n, (unsigned int)len) ||
+	    n->nlmsg_type == NLMSG_ERROR)
+		return 0;
+
+	len = n->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+	for (na = GENLMSG_DATA(n); len >= NLA_HDRLEN;
+	     len -= NLA_ALIGN(na->nla_len), na = NLA_NEXT(na))
+		if (na->nla_type == CTRL_ATTR_FAMILY_ID)
+			return *(__u16 *)NLA_DATA(na);
+	return 0;
+}
+
+static void print_stats(__u32 pid, struct taskstats *t)
+{
+	printf("%6u %6u %-16.16s utime %8llu stime %8llu us, "
+	       "rss %7llu KB, flt %llu/%llu, io %llu/%llu KB\n",
+	       pid, t->ac_tgid, t->ac_comm,
+	       (unsigned long long)t->ac_utime,
+	       (unsigned long long)t->ac_stime,
+	       (unsigned long long)t->cur_rss,
+	       (unsigned long long)t->ac_minflt,
+	       (unsigned long long)t->ac_majflt,
+	       (unsigned long long)t->read_bytes / 1024,
+	       (unsigned long long)t->write_bytes / 1024);
+}
+
+/* Walk the attributes of one TASKSTATS_CMD_NEW message */
+static void parse_task(struct nlmsghdr *n, struct pass *p, int print)
+{
+	struct nlattr *na, *nested;
+	int len, nlen;
+	__u32 pid = 0;
+
+	len = n->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+	for (na = GENLMSG_DATA(n); len >= NLA_HDRLEN;
+	     len -= NLA_ALIGN(na->nla_len), na = NLA_NEXT(na)) {
+		if (na->nla_type != TASKSTATS_TYPE_AGGR_PID)
+			continue;
+		nlen = na->nla_len - NLA_HDRLEN;
+		for (nested = NLA_DATA(na); nlen >= NLA_HDRLEN;
+		     nlen -= NLA_ALIGN(nested->nla_len),
+		     nested = NLA_NEXT(nested)) {
+			struct taskstats *t = NLA_DATA(nested);
+
+			if (nested->nla_type == TASKSTATS_TYPE_PID)
+				pid = *(__u32 *)NLA_DATA(nested);
+			if (nested->nla_type != TASKSTATS_TYPE_STATS)
+				continue;
+			p->tasks++;
+			p->utime_us += t->ac_utime;
+			if (print)
+				print_stats(pid, t);
+		}
+	}
+}
+
+/* Returns 0, or a negative errno if the kernel refused the dump */
+static int dump_pass(int sd, int id, int cgroup_fd, struct pass *p, int print)
+{
+	struct nlmsghdr *n;
+	unsigned int left;
+	int len;
+
+	if (nl_send(sd, id, NLM_F_DUMP, TASKSTATS_CMD_GET,
+		    TASKSTATS_CMD_ATTR_CGROUP_FD,
+		    cgroup_fd >= 0 ? &cgroup_fd : NULL, sizeof(__u32)))
+		return -errno;
+	p->syscalls++;
+
+	for (;;) {
+		len = recv(sd, buf, sizeof(buf), 0);
+		p->syscalls++;
+		if (len < 0)
+			return -errno;
+		left = len;
+		for (n = (struct nlmsghdr *)buf; NLMSG_OK(n, left);
+		     n = NLMSG_NEXT(n, left)) {
+			if (n->nlmsg_type == NLMSG_DONE)
+				return *(int *)NLMSG_DATA(n);
+			if (n->nlmsg_type == NLMSG_ERROR)
+				return ((struct nlmsgerr *)NLMSG_DATA(n))->error;
+			parse_task(n, p, print);
+		}
+	}
+}
+
+/* open, read and close one file, as a monitor would */
+static int read_file(const char *path, struct pass *p)
+{
+	int fd, len;
+
+	fd = open(path, O_RDONLY);
+	p->syscalls++;
+	if (fd < 0)
+		return -1;
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	p->syscalls += 2;
+	if (len < 0)
+		return -1;
+	buf[len] = '\0';
+	return len;
+}
+
+static void scrape_task(const char *pid, const char *tid, struct pass *p)
+{
+	unsigned long utime;
+	char path[600], *s;
+
+	snprintf(path, sizeof(path), "/proc/%s/task/%s/status", pid, tid);
+	if (read_file(path, p) < 0)
+		return;
+	snprintf(path, sizeof(path), "/proc/%s/task/%s/stat", pid, tid);
+	if (read_file(path, p) < 0)
+		return;
+	p->tasks++;
+	/* utime is the 14th field, the comm in field 2 may contain spaces */
+	s = strrchr(buf, ')');
+	if (s && sscanf(s + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu",
+			&utime) == 1)
+		p->utime_us += utime * 1000000ULL / sysconf(_SC_CLK_TCK);
+}
+
+/* Scan a directory of pids or tids, with one getdents per batch */
+static void scrape_dir(const char *path, const char *pid, struct pass *p)
+{
+	struct dirent *de;
+	char sub[300];
+	DIR *d;
+
+	d = opendir(path);
+	p->syscalls += 2;
+	if (!d)
+		return;
+	while ((de = readdir(d))) {
+		if (de->d_name[0] < '0' || de->d_name[0] > '9')
+			continue;
+		if (pid) {
+			scrape_task(pid, de->d_name, p);
+		} else {
+			snprintf(sub, sizeof(sub), "/proc/%s/task", de->d_name);
+			scrape_dir(sub, de->d_name, p);
+		}
+	}
+	closedir(d);
+	p->syscalls += 2;
+}
+
+static void procfs_pass(struct pass *p)
+{
+	char path[256], *tids, *tid, *save;
+
+	if (!cgroup) {
+		scrape_dir("/proc", NULL, p);
+		return;
+	}
+
+	/* the tasks file lists tids; /proc/<tid>/task/<tid> exists for all */
+	snprintf(path, sizeof(path), "%s/tasks", cgroup);
+	if (read_file(path, p) < 0)
+		return;
+	tids = strdup(buf);
+	if (!tids)
+		return;
+	for (tid = strtok_r(tids, "\n", &save); tid;
+	     tid = strtok_r(NULL, "\n", &save))
+		scrape_task(tid, tid, p);
+	free(tids);
+}
+
+static double elapsed_us(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1e6 +
+		(now.tv_usec - start->tv_usec);
+}
+
+static void report(const char *what, struct pass *p, double us, int passes)
+{
+	printf("%-9s %6lu tasks, %8.1f us, %7lu syscalls per pass, "
+	       "%llu s user time\n", what, p->tasks / passes, us / passes,
+	       p->syscalls / passes, p->utime_us / passes / 1000000);
+}
+
+int main(int argc, char **argv)
+{
+	struct pass dump = { 0 }, procfs = { 0 };
+	struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+	int passes = 10, cgroup_fd = -1;
+	double dump_us, procfs_us;
+	struct timeval start;
+	int sd, id, i, opt, rc;
+
+	while ((opt = getopt(argc, argv, "c:n:v")) != -1) {
+		switch (opt) {
+		case 'c':
+			cgroup = optarg;
+			break;
+		case 'n':
+			passes = atoi(optarg);
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-c cgroup-dir] [-n passes] "
+				"[-v]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (passes <= 0)
+		passes = 1;
+
+	if (cgroup) {
+		cgroup_fd = open(cgroup, O_RDONLY | O_DIRECTORY);
+		if (cgroup_fd < 0) {
+			perror(cgroup);
+			return 1;
+		}
+	}
+
+	sd = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+	if (sd < 0 || bind(sd, (struct sockaddr *)&addr, sizeof(addr))) {
+		perror("netlink socket");
+		return 1;
+	}
+	id = get_family_id(sd);
+	if (!id) {
+		printf("taskstats not supported, skipping\n");
+		return 0;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < passes; i++) {
+		rc = dump_pass(sd, id, cgroup_fd, &dump,
+			       verbose && i == passes - 1);
+		if (rc == -EOPNOTSUPP || rc == -EPERM) {
+			printf("taskstats dump not available (%s), skipping\n",
+			       strerror(-rc));
+			return 0;
+		}
+		if (rc < 0) {
+			fprintf(stderr, "taskstats dump: %s\n", strerror(-rc));
+			return 1;
+		}
+	}
+	dump_us = elapsed_us(&start);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < passes; i++)
+		procfs_pass(&procfs);
+	procfs_us = elapsed_us(&start);
+
+	report("taskstats", &dump, dump_us, passes);
+	report("procfs", &procfs, procfs_us, passes);
+
+	/* tasks come and go, but the counts should be in the same ballpark */
+	if (!dump.tasks || dump.tasks * 2 < procfs.tasks ||
+	    procfs.tasks * 2 < dump.tasks) {
+		printf("[FAIL]\n");
+		return 1;
+	}
+	printf("[PASS]\n");
+	return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Allocate and touch more anonymous memory than is free, so that the
+ * kernel has to swap, and report how fast it reclaimed and how long
+ * allocations stalled in direct reclaim, from the /proc/vmstat deltas.
+ *
+ * Usage: reclaim_hog [megabytes]
+ *
+ * This can push the system into the OOM killer, so run_vmtests only
+ * runs it when RUN_RECLAIM_HOG is set in the environment.
+ *
+ * Without an argument it allocates MemFree plus half of SwapFree.
+ * Every page is filled with data that compresses about 2:1, like
+ * typical app heaps do on zram, and checked again after the run.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#define PAGE_WORDS	(page_size / sizeof(unsigned long))
+
+static long page_size;
+
+/* The pgsteal counters are per zone: sum up all fields they prefix */
+static const struct {
+	const char *name;
+	int per_zone;
+} counters[] = {
+	{ "pswpout", 0 },
+	{ "pswpin", 0 },
+	{ "allocstall", 0 },
+	{ "allocstall_time_us", 0 },
+	{ "pgsteal_kswapd_", 1 },
+	{ "pgsteal_direct_", 1 },
+};
+#define NR_COUNTERS	(sizeof(counters) / sizeof(counters[0]))
+
+static int read_vmstat(unsigned long long *val)
+{
+	char name[64];
+	unsigned long long v;
+	unsigned int i;
+	FILE *f;
+
+	f = fopen("/proc/vmstat", "r");
+	if (!f) {
+		perror("/proc/vmstat");
+		return -1;
+	}
+	memset(val, 0, NR_COUNTERS * sizeof(*val));
+	while (fscanf(f, "%63s %llu", name, &v) == 2) {
+		for (i = 0; i < NR_COUNTERS; i++) {
+			if (counters[i].per_zone ?
+			    !strncmp(name, counters[i].name,
+				     strlen(counters[i].name)) :
+			    !strcmp(name, counters[i].name))
+				val[i] += v;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+static unsigned long meminfo(const char *field)
+{
+	char name[64];
+	unsigned long v = 0, kb;
+	FILE *f;
+
+	f = fopen("/proc/meminfo", "r");
+	if (!f)
+		return 0;
+	while (fscanf(f, "%63s %lu kB", name, &kb) == 2) {
+		if (!strncmp(name, field, strlen(field))) {
+			v = kb;
+			break;
+		}
+	}
+	fclose(f);
+	return v;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void fill_page(unsigned long *p, unsigned long n)
+{
+	unsigned long i;
+
+	for (i = 0; i < PAGE_WORDS; i++)
+		p[i] = (i & 1) ? 0 : n * 2654435761UL + i;
+}
+
+static int check_page(unsigned long *p, unsigned long n)
+{
+	unsigned long i;
+
+	for (i = 0; i < PAGE_WORDS; i++)
+		if (p[i] != ((i & 1) ? 0 : n * 2654435761UL + i))
+			return -1;
+	return 0;
+}
+
+static void report(const char *pass, double secs,
+		   unsigned long long *before, unsigned long long *after)
+{
+	unsigned long long d[NR_COUNTERS];
+	unsigned int i;
+
+	for (i = 0; i < NR_COUNTERS; i++)
+		d[i] = after[i] - before[i];
+
+	printf("%s: %.2fs, %llu pages reclaimed (%.0f pages/s), "
+	       "%llu swapped out, %llu swapped in\n",
+	       pass, secs, d[4] + d[5], (d[4] + d[5]) / secs, d[0], d[1]);
+	printf("%s: %llu direct reclaim stalls, %llu us stalled "
+	       "(%.1f us per stall)\n",
+	       pass, d[2], d[3], d[2] ? (double)d[3] / d[2] : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long long before[NR_COUNTERS], after[NR_COUNTERS];
+	unsigned long nr_pages, i, bad = 0;
+	unsigned long megabytes;
+	size_t len;
+	double start;
+	char *mem;
+
+	page_size = sysconf(_SC_PAGESIZE);
+
+	if (!meminfo("SwapTotal:")) {
+		printf("no swap configured, skipping\n");
+		return 0;
+	}
+
+	if (argc > 1)
+		megabytes = strtoul(argv[1], NULL, 0);
+	else
+		megabytes = (meminfo("MemFree:") +
+			     meminfo("SwapFree:") / 2) / 1024;
+	if (megabytes > SIZE_MAX >> 20) {
+		printf("%lu MB do not fit in the address space\n", megabytes);
+		return 1;
+	}
+	len = (size_t)megabytes << 20;
+	nr_pages = len / page_size;
+
+	mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	printf("touching %lu MB\n", megabytes);
+
+	if (read_vmstat(before))
+		return 1;
+	start = now();
+	for (i = 0; i < nr_pages; i++)
+		fill_page((unsigned long *)(mem + i * page_size), i);
+	if (read_vmstat(after))
+		return 1;
+	report("write", now() - start, before, after);
+
+	memcpy(before, after, sizeof(before));
+	start = now();
+	for (i = 0; i < nr_pages; i++)
+		if (check_page((unsigned long *)(mem + i * page_size), i))
+			bad++;
+	if (read_vmstat(after))
+		return 1;
+	report("read", now() - start, before, after);
+
+	munmap(mem, len);
+
+	if (bad) {
+		printf("%lu pages corrupted\n", bad);
+		return 1;
+	}
+	return 0;
+}
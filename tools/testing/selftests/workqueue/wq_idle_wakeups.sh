@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# Count the idle wakeups caused by workqueues: a CPU leaving idle and
+# running a work item before anything else, per work function.
+#
+# Usage: wq_idle_wakeups.sh [seconds]
+#
+# Run it on an otherwise idle system, once booted with
+# workqueue.power_efficient=0 and once with workqueue.power_efficient=1,
+# to see how many wakeups the power efficient workqueues save.
+
+secs=${1:-30}
+
+debugfs=`awk '$3 == "debugfs" { print $2; exit }' /proc/mounts`
+tracing=$debugfs/tracing
+if [ -z "$debugfs" ] || [ ! -d $tracing/events/workqueue ] ||
+   [ ! -d $tracing/events/power/cpu_idle ]; then
+	echo "workqueue or cpu_idle tracepoints not available, skipping"
+	exit 0
+fi
+
+param=/sys/module/workqueue/parameters/power_efficient
+if [ -r $param ]; then
+	echo "workqueue.power_efficient=`cat $param`"
+fi
+
+echo 0 > $tracing/tracing_on
+echo > $tracing/trace
+echo 1 > $tracing/events/power/cpu_idle/enable
+echo 1 > $tracing/events/sched/sched_switch/enable
+echo 1 > $tracing/events/workqueue/workqueue_execute_start/enable
+echo 1 > $tracing/tracing_on
+
+echo "tracing for $secs seconds..."
+sleep $secs
+
+echo 0 > $tracing/tracing_on
+echo 0 > $tracing/events/power/cpu_idle/enable
+echo 0 > $tracing/events/sched/sched_switch/enable
+echo 0 > $tracing/events/workqueue/workqueue_execute_start/enable
+
+# state=4294967295 is PWR_EVENT_EXIT, i.e. the CPU left idle.  A CPU is
+# charged to the first work item it runs after that, unless it switched
+# to some task other than a kworker first.
+awk -v secs=$secs '
+function cpu_of(line) {
+	match(line, /\[[0-9]+\]/)
+	return substr(line, RSTART + 1, RLENGTH - 2) + 0
+}
+/ cpu_idle: / {
+	cpu = cpu_of($0)
+	if ($0 ~ /state=4294967295/) {
+		woken[cpu] = 1
+		exits++
+	} else
+		woken[cpu] = 0
+	next
+}
+/ sched_switch: / {
+	cpu = cpu_of($0)
+	if ($0 !~ /next_comm=(kworker|swapper)/)
+		woken[cpu] = 0
+	next
+}
+/ workqueue_execute_start: / {
+	cpu = cpu_of($0)
+	if (woken[cpu]) {
+		woken[cpu] = 0
+		fn = $NF
+		count[fn]++
+		wq++
+	}
+}
+END {
+	printf("%d idle exits, %d caused by workqueues (%.1f/s)\n",
+	       exits, wq, wq / secs)
+	for (fn in count)
+		printf("%8d %s\n", count[fn], fn) | "sort -rn"
+}' $tracing/trace
+
+echo > $tracing/trace